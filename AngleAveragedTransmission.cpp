@@ -76,6 +76,10 @@ double AngleAveragedTransmission::integrand (double mu)
 {
   Real z = mu / itsU;
   Real p = sqrt (1. - mu * mu) / itsU;
+  if (isHeII && itsOpticalDepthHeII->getCombinable (itsOpticalDepth)) {
+    return exp (-1. * itsOpticalDepthHeII->getCombinedOpticalDepth 
+		(p, z, itsKappaRatio));
+  }
   Real tau = itsOpticalDepth->getOpticalDepth (p, z);
   if (isHeII) {
     tau += itsKappaRatio * itsOpticalDepthHeII->getOpticalDepth (p, z);
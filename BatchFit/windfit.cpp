@@ -0,0 +1,307 @@
+/***************************************************************************
+    windfit.cpp     - Fits windprof, hwind, hewind or radwind to a list
+                      of spectra without XSPEC (see BatchFitter.h), and
+                      writes the results as a table.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  See BatchFit/README. The spectra and responses are all read first;
+  a response is read once, however many spectra use it.
+*/
+
+#include "../Benchmark/ModelTable.h"
+#include "BatchFitter.h"
+#include "ResponseMatrix.h"
+#include "WindProfileEmulator.h"
+#include "WindProfileConfig.h"
+#include "PrecisionSchedule.h"
+#include "FastMath.h"
+#include "OpticalDepth.h"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+
+static void usage ()
+{
+  cerr << "usage: windfit --model NAME --spectra FILE --free NAME ... "
+       << "[options]\n"
+       << "  --model NAME          windprof, hwind, hewind or radwind\n"
+       << "  --spectra FILE        lines of: name spectrum response\n"
+       << "  --free NAME[=LO:HI]   a fitted parameter (may be repeated;\n"
+       << "                        default limits from lmodel.dat)\n"
+       << "  --set NAME=VALUE      a starting value (may be repeated)\n"
+       << "  --statistic S         cstat or chi (default cstat)\n"
+       << "  --iterations N        default 100\n"
+       << "  --delta X             critical delta (default 1.e-3)\n"
+       << "  --threads N           default one per core\n"
+       << "  --output FILE         results (default stdout)\n"
+       << "  --emulator FILE       see WindProfileEmulator.h\n"
+       << "  --lmodel FILE         model definitions (default lmodel.dat)\n"
+       << "  --xset KEY=VALUE      set a model setting (may be repeated)\n";
+  return;
+}
+
+static bool getModelType (const string& model, ModelType& type)
+{
+  if (model == "windprof") {
+    type = general;
+  } else if (model == "hwind") {
+    type = hlike;
+  } else if (model == "hewind") {
+    type = helike;
+  } else if (model == "radwind") {
+    type = rad;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* Lines of: channel counts [error], and one line EXPOSURE seconds;
+   # starts a comment. Only the channels listed are fitted. */
+static bool readSpectrum
+(const string& filename, const ResponseMatrix& response,
+ FitSpectrum& spectrum)
+{
+  ifstream file (filename.c_str ());
+  if (!file) {
+    cerr << "windfit: cannot open " << filename << "\n";
+    return false;
+  }
+  vector<Real> counts, error;
+  spectrum.itsExposure = 0.;
+  spectrum.itsChannel.clear ();
+  string line;
+  while (getline (file, line)) {
+    istringstream words (line);
+    string first;
+    if (!(words >> first) || (first[0] == '#')) continue;
+    if (first == "EXPOSURE") {
+      words >> spectrum.itsExposure;
+      continue;
+    }
+    size_t channel = atoi (first.c_str ());
+    Real c, e;
+    if (!(words >> c) || (channel >= response.getNChannels ())) {
+      cerr << "windfit: cannot read " << filename << ": " << line << "\n";
+      return false;
+    }
+    spectrum.itsChannel.push_back (channel);
+    counts.push_back (c);
+    if (words >> e) error.push_back (e);
+  }
+  if ((spectrum.itsExposure <= 0.) || counts.empty () ||
+      (!error.empty () && (error.size () != counts.size ()))) {
+    cerr << "windfit: " << filename << " needs EXPOSURE, and counts (with "
+	 << "or without errors) in every line\n";
+    return false;
+  }
+  spectrum.itsCounts.resize (counts.size ());
+  for (size_t i = 0; i < counts.size (); i++) spectrum.itsCounts[i] = counts[i];
+  spectrum.itsError.resize (error.size ());
+  for (size_t i = 0; i < error.size (); i++) spectrum.itsError[i] = error[i];
+  return true;
+}
+
+// WINDPROFOPTICALDEPTH (see README.md)
+static bool isAutomaticOpticalDepth ()
+{
+  string backend = getConfigVariable ("WINDPROFOPTICALDEPTH", "SWITCH");
+  for (size_t i = 0; i < backend.size (); i++) {
+    backend[i] = toupper (backend[i]);
+  }
+  return (backend == "AUTO");
+}
+
+int main (int argc, char** argv)
+{
+  string modelFile ("lmodel.dat");
+  string model, spectraFile, outputFile, emulatorFile, changes;
+  string statistic ("cstat");
+  vector<string> freeNames;
+  size_t NThreads = 0;
+  size_t NIterations = 100;
+  Real delta = 1.e-3;
+  for (int i = 1; i < argc; i++) {
+    string option (argv[i]);
+    if (i + 1 >= argc) {
+      usage ();
+      return 1;
+    }
+    string value (argv[++i]);
+    if (option == "--model") {
+      model = value;
+    } else if (option == "--spectra") {
+      spectraFile = value;
+    } else if (option == "--free") {
+      freeNames.push_back (value);
+    } else if (option == "--set") {
+      changes += " " + value;
+    } else if (option == "--statistic") {
+      statistic = value;
+    } else if (option == "--iterations") {
+      NIterations = atoi (value.c_str ());
+    } else if (option == "--delta") {
+      delta = atof (value.c_str ());
+    } else if (option == "--threads") {
+      NThreads = atoi (value.c_str ());
+    } else if (option == "--output") {
+      outputFile = value;
+    } else if (option == "--emulator") {
+      emulatorFile = value;
+    } else if (option == "--lmodel") {
+      modelFile = value;
+    } else if (option == "--xset") {
+      if (!setXspecKey (value)) {
+	usage ();
+	return 1;
+      }
+    } else {
+      usage ();
+      return 1;
+    }
+  }
+  ModelType type;
+  if (!getModelType (model, type) || spectraFile.empty () ||
+      freeNames.empty () || ((statistic != "cstat") && (statistic != "chi"))) {
+    usage ();
+    return 1;
+  }
+  map<string, ParameterList> defaults;
+  map<string, LimitList> limits;
+  if (!readModelFile (modelFile, defaults, limits)) return 1;
+  if (defaults.find (model) == defaults.end ()) {
+    cerr << "windfit: " << model << " is not in " << modelFile << "\n";
+    return 1;
+  }
+  const ParameterList& list = defaults[model];
+  RealArray start;
+  if (!makeParameters (list, changes, start)) return 1;
+  vector<string> names;
+  for (size_t i = 0; i < list.size (); i++) names.push_back (list[i].first);
+
+  PrecisionSchedule& P = PrecisionSchedule::instance ();
+  P.setMode (getConfigVariable ("WINDPROFPRECISION", "FULL"));
+  bool isReference = (P.getMode () == referencePrecision);
+  setFastMath (!isReference &&
+	       (atoi (getConfigVariable ("WINDPROFFASTMATH", "0").c_str ())
+		== 1));
+  OpticalDepth::setAutomatic (!isReference && isAutomaticOpticalDepth ());
+  BatchFitter fitter (type, start, NThreads);
+  fitter.setTargetAccuracy
+    (isReference ? 0. :
+     atof (getConfigVariable ("WINDPROFTOLERANCE", "1.e-4").c_str ()));
+  fitter.setStatistic ((statistic == "chi") ? chiSquare : cStatistic);
+  fitter.setMaximumIterations (NIterations);
+  fitter.setCriticalDelta (delta);
+  for (size_t k = 0; k < freeNames.size (); k++) {
+    size_t equals = freeNames[k].find ('=');
+    string name = freeNames[k].substr (0, equals);
+    size_t i = 0;
+    while ((i < names.size ()) && (names[i] != name)) i++;
+    if (i == names.size ()) {
+      cerr << "windfit: " << model << " has no parameter " << name << "\n";
+      return 1;
+    }
+    Real low = limits[model][i].first;
+    Real high = limits[model][i].second;
+    if (equals != string::npos) {
+      string range = freeNames[k].substr (equals + 1);
+      size_t colon = range.find (':');
+      if (colon == string::npos) {
+	cerr << "windfit: cannot read --free " << freeNames[k] << "\n";
+	return 1;
+      }
+      low = atof (range.substr (0, colon).c_str ());
+      high = atof (range.substr (colon + 1).c_str ());
+    }
+    if (!fitter.setFree (i, low, high)) return 1;
+  }
+
+  WindProfileEmulator emulator;
+  if (!emulatorFile.empty ()) {
+    if (!emulator.read (emulatorFile)) return 1;
+    if (emulator.getModelName () != model) {
+      cerr << "windfit: " << emulatorFile << " is an emulator of "
+	   << emulator.getModelName () << ", not " << model << "\n";
+      return 1;
+    }
+    fitter.setEmulator
+      (&emulator,
+       atof (getConfigVariable ("WINDPROFEMULATORTOLERANCE", "1.e-3")
+	     .c_str ()));
+  }
+
+  ifstream listFile (spectraFile.c_str ());
+  if (!listFile) {
+    cerr << "windfit: cannot open " << spectraFile << "\n";
+    return 1;
+  }
+  map<string, ResponseMatrix> responses;
+  vector<FitSpectrum> spectra;
+  string line;
+  while (getline (listFile, line)) {
+    istringstream words (line);
+    string name, spectrumFile, responseFile;
+    if (!(words >> name) || (name[0] == '#')) continue;
+    if (!(words >> spectrumFile >> responseFile)) {
+      cerr << "windfit: cannot read " << spectraFile << ": " << line << "\n";
+      return 1;
+    }
+    if (responses.find (responseFile) == responses.end ()) {
+      if (!responses[responseFile].read (responseFile)) return 1;
+    }
+    FitSpectrum spectrum;
+    spectrum.itsName = name;
+    spectrum.itsResponse = &responses[responseFile];
+    if (!readSpectrum (spectrumFile, responses[responseFile], spectrum)) {
+      return 1;
+    }
+    spectra.push_back (spectrum);
+  }
+  cerr << "windfit: " << spectra.size () << " spectra, " << responses.size ()
+       << " responses, " << fitter.getNThreads () << " threads\n";
+
+  vector<FitResult> results;
+  fitter.fit (spectra, results);
+  size_t NConverged = 0;
+  for (size_t j = 0; j < results.size (); j++) {
+    if (results[j].hasConverged) NConverged++;
+  }
+  cerr << "windfit: " << NConverged << " of " << results.size ()
+       << " fits converged\n";
+  if (outputFile.empty ()) {
+    fitter.writeResults (cout, names, results);
+  } else {
+    ofstream output (outputFile.c_str ());
+    fitter.writeResults (output, names, results);
+    if (!output) {
+      cerr << "windfit: cannot write " << outputFile << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
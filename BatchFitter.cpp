@@ -0,0 +1,426 @@
+/***************************************************************************
+    BatchFitter.cpp - Fits the windprof family to many independent
+                      spectra at once, spreading the spectra over a
+                      thread pool.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <cmath>
+#include <iomanip>
+#include <gsl/gsl_math.h>
+#include "BatchFitter.h"
+#include "ResponseMatrix.h"
+#include "WindProfileBatch.h"
+#include "WindProfileEmulator.h"
+#include "ToleranceBudget.h"
+
+using namespace std;
+
+// Finite difference steps, relative to the parameter (or to 1% of its
+// range, if that is larger). The line position and velocity only move
+// the x grid, which the stencil integrates exactly, so they get a much
+// smaller step.
+static const Real STEP = 1.e-3;
+static const Real MAPPING_STEP = 1.e-5;
+// Model counts are kept above this in the C-statistic.
+static const Real MINIMUM_COUNTS = 1.e-10;
+static const Real MAXIMUM_LAMBDA = 1.e10;
+
+BatchFitter::BatchFitter
+(ModelType type, ConstRealSpan parameter, size_t NThreads)
+  : itsModelType (type), itsStart (parameter.size ()), itsFree (),
+    itsLow (), itsHigh (), isMapping (parameter.size (), false),
+    itsStatistic (cStatistic), itsTarget (ToleranceBudget::DEFAULT_TARGET),
+    itsMaximumIterations (100), itsCriticalDelta (1.e-3),
+    itsEmulator (NULL), itsEmulatorTolerance (0.), itsPool (NThreads),
+    itsEngine (itsPool.getNThreads ())
+{
+  for (size_t i = 0; i < parameter.size (); i++) itsStart[i] = parameter[i];
+  WindParameter W (parameter, type);
+  for (size_t i = 0; i < parameter.size (); i++) {
+    isMapping[i] = W.isMappingParameter (i);
+  }
+  return;
+}
+
+BatchFitter::~BatchFitter ()
+{
+  freeEngines ();
+  return;
+}
+
+bool BatchFitter::setFree (size_t index, Real low, Real high)
+{
+  if ((index >= itsStart.size ()) || (compare (high, low) != 1)) {
+    cerr << "BatchFitter: cannot fit parameter " << index << " between "
+	 << low << " and " << high << "\n";
+    return false;
+  }
+  for (size_t k = 0; k < itsFree.size (); k++) {
+    if (itsFree[k] == index) {
+      itsLow[k] = low;
+      itsHigh[k] = high;
+      return true;
+    }
+  }
+  itsFree.push_back (index);
+  itsLow.push_back (low);
+  itsHigh.push_back (high);
+  return true;
+}
+
+void BatchFitter::setEmulator
+(const WindProfileEmulator* emulator, Real tolerance)
+{
+  itsEmulator = emulator;
+  itsEmulatorTolerance = tolerance;
+  return;
+}
+
+void BatchFitter::fit
+(const vector<FitSpectrum>& spectrum, vector<FitResult>& result)
+{
+  result.assign (spectrum.size (), FitResult ());
+  itsPool.run (spectrum.size (), [&] (size_t i, size_t worker) {
+      fitSpectrum (spectrum[i], worker, result[i]);
+    });
+  freeEngines ();
+  return;
+}
+
+WindProfileBatch& BatchFitter::getEngine
+(const ResponseMatrix& response, size_t worker)
+{
+  EngineMap& engine = itsEngine[worker];
+  EngineMap::iterator e = engine.find (&response);
+  if (e == engine.end ()) {
+    WindProfileBatch* B =
+      new WindProfileBatch (response.getEnergy (), itsModelType, 1);
+    B->setTargetAccuracy (itsTarget);
+    e = engine.insert (make_pair (&response, B)).first;
+  }
+  return *(e->second);
+}
+
+void BatchFitter::freeEngines ()
+{
+  for (size_t t = 0; t < itsEngine.size (); t++) {
+    for (EngineMap::iterator e = itsEngine[t].begin ();
+	 e != itsEngine[t].end (); ++e) {
+      delete e->second;
+    }
+    itsEngine[t].clear ();
+  }
+  return;
+}
+
+void BatchFitter::foldFlux
+(const FitSpectrum& spectrum, ConstRealSpan flux, Real norm,
+ RealArray& counts) const
+{
+  const ResponseMatrix& R = *spectrum.itsResponse;
+  RealArray folded (R.getNChannels ());
+  R.fold (flux, folded);
+  counts.resize (spectrum.itsChannel.size ());
+  for (size_t i = 0; i < counts.size (); i++) {
+    counts[i] = spectrum.itsExposure * norm * folded[spectrum.itsChannel[i]];
+  }
+  return;
+}
+
+void BatchFitter::getCounts
+(const FitSpectrum& spectrum, size_t worker, const RealArray& parameter,
+ RealArray& counts)
+{
+  const RealArray& energy = spectrum.itsResponse->getEnergy ();
+  RealArray flux (energy.size () - 1);
+  if (itsEmulator && (itsEmulator->getErrorEstimate (parameter) <=
+		      itsEmulatorTolerance)) {
+    itsEmulator->getModelFlux (energy, parameter, flux);
+  } else {
+    getEngine (*spectrum.itsResponse, worker).getModelFlux
+      (parameter, 1, flux);
+  }
+  foldFlux (spectrum, flux, parameter[parameter.size () - 1], counts);
+  return;
+}
+
+void BatchFitter::getDerivatives
+(const FitSpectrum& spectrum, size_t worker, const RealArray& parameter,
+ RealArray& counts, vector<RealArray>& derivative)
+{
+  size_t norm = parameter.size () - 1;
+  vector<size_t> index;
+  vector<Real> step;
+  for (size_t k = 0; k < itsFree.size (); k++) {
+    size_t i = itsFree[k];
+    if (i == norm) continue;
+    Real h = (isMapping[i] ? MAPPING_STEP : STEP) *
+      GSL_MAX_DBL (fabs (parameter[i]), 0.01 * (itsHigh[k] - itsLow[k]));
+    if (parameter[i] + h > itsHigh[k]) h = -h;
+    index.push_back (i);
+    step.push_back (h);
+  }
+  const RealArray& energy = spectrum.itsResponse->getEnergy ();
+  size_t NFlux = energy.size () - 1;
+  size_t NRows = index.size () + 1;
+  RealArray flux (NRows * NFlux);
+  bool isEmulated = (itsEmulator != NULL);
+  vector<RealArray> row (NRows, parameter);
+  for (size_t k = 0; k < index.size (); k++) row[k + 1][index[k]] += step[k];
+  for (size_t r = 0; (r < NRows) && isEmulated; r++) {
+    isEmulated =
+      (itsEmulator->getErrorEstimate (row[r]) <= itsEmulatorTolerance);
+  }
+  if (isEmulated) {
+    for (size_t r = 0; r < NRows; r++) {
+      itsEmulator->getModelFlux
+	(energy, row[r], RealSpan (&flux[r * NFlux], NFlux));
+    }
+  } else {
+    RealArray delta (step.size ());
+    for (size_t k = 0; k < step.size (); k++) delta[k] = step[k];
+    getEngine (*spectrum.itsResponse, worker).getStencilFlux
+      (parameter, index, delta, flux);
+  }
+  foldFlux (spectrum, ConstRealSpan (&flux[0], NFlux), parameter[norm],
+	    counts);
+  derivative.assign (itsFree.size (), RealArray ());
+  size_t r = 0;
+  for (size_t k = 0; k < itsFree.size (); k++) {
+    if (itsFree[k] == norm) {
+      foldFlux (spectrum, ConstRealSpan (&flux[0], NFlux), 1.,
+		derivative[k]);
+      continue;
+    }
+    r++;
+    foldFlux (spectrum, ConstRealSpan (&flux[r * NFlux], NFlux),
+	      parameter[norm], derivative[k]);
+    derivative[k] = (derivative[k] - counts) / step[r - 1];
+  }
+  return;
+}
+
+Real BatchFitter::getStatistic
+(const FitSpectrum& spectrum, const RealArray& counts) const
+{
+  const RealArray& d = spectrum.itsCounts;
+  Real statistic = 0.;
+  for (size_t i = 0; i < counts.size (); i++) {
+    if (itsStatistic == chiSquare) {
+      Real sigma = spectrum.itsError.size () ? spectrum.itsError[i] :
+	sqrt (GSL_MAX_DBL (d[i], 1.));
+      statistic += gsl_pow_2 ((d[i] - counts[i]) / sigma);
+    } else {
+      Real m = GSL_MAX_DBL (counts[i], MINIMUM_COUNTS);
+      statistic += 2. * (m - d[i]);
+      if (d[i] > 0.) statistic += 2. * d[i] * log (d[i] / m);
+    }
+  }
+  return statistic;
+}
+
+void BatchFitter::getCurvature
+(const FitSpectrum& spectrum, const RealArray& counts,
+ const vector<RealArray>& derivative, RealArray& gradient,
+ vector<RealArray>& curvature) const
+{
+  const RealArray& d = spectrum.itsCounts;
+  size_t NFree = derivative.size ();
+  gradient.resize (NFree);
+  gradient = 0.;
+  curvature.assign (NFree, RealArray (0., NFree));
+  for (size_t i = 0; i < counts.size (); i++) {
+    Real slope, weight;
+    if (itsStatistic == chiSquare) {
+      Real sigma = spectrum.itsError.size () ? spectrum.itsError[i] :
+	sqrt (GSL_MAX_DBL (d[i], 1.));
+      weight = 1. / gsl_pow_2 (sigma);
+      slope = -(d[i] - counts[i]) * weight;
+    } else {
+      // the expected curvature (Fisher), which stays positive
+      Real m = GSL_MAX_DBL (counts[i], MINIMUM_COUNTS);
+      weight = 1. / m;
+      slope = 1. - d[i] / m;
+    }
+    for (size_t k = 0; k < NFree; k++) {
+      gradient[k] += 2. * slope * derivative[k][i];
+      for (size_t l = 0; l <= k; l++) {
+	curvature[k][l] += 2. * weight * derivative[k][i] * derivative[l][i];
+      }
+    }
+  }
+  for (size_t k = 0; k < NFree; k++) {
+    for (size_t l = 0; l < k; l++) curvature[l][k] = curvature[k][l];
+  }
+  return;
+}
+
+// Gauss-Jordan elimination with partial pivoting; false if singular.
+static bool invertMatrix (vector<RealArray>& A)
+{
+  size_t N = A.size ();
+  vector<RealArray> inverse (N, RealArray (0., N));
+  for (size_t i = 0; i < N; i++) inverse[i][i] = 1.;
+  for (size_t c = 0; c < N; c++) {
+    size_t pivot = c;
+    for (size_t r = c + 1; r < N; r++) {
+      if (fabs (A[r][c]) > fabs (A[pivot][c])) pivot = r;
+    }
+    if (A[pivot][c] == 0.) return false;
+    swap (A[c], A[pivot]);
+    swap (inverse[c], inverse[pivot]);
+    Real scale = 1. / A[c][c];
+    A[c] *= scale;
+    inverse[c] *= scale;
+    for (size_t r = 0; r < N; r++) {
+      if ((r == c) || (A[r][c] == 0.)) continue;
+      Real factor = A[r][c];
+      A[r] -= factor * A[c];
+      inverse[r] -= factor * inverse[c];
+    }
+  }
+  A = inverse;
+  return true;
+}
+
+/*
+  The normalization (if free) is first scaled to the total counts.
+  Each iteration then takes the Levenberg-Marquardt step from the
+  curvature with lambda times its diagonal added, increasing lambda
+  tenfold until the step lowers the statistic, and decreasing it
+  tenfold after each successful step.
+*/
+void BatchFitter::fitSpectrum
+(const FitSpectrum& spectrum, size_t worker, FitResult& result)
+{
+  size_t NFree = itsFree.size ();
+  size_t norm = itsStart.size () - 1;
+  RealArray parameter (itsStart);
+  for (size_t k = 0; k < NFree; k++) {
+    Real& p = parameter[itsFree[k]];
+    p = GSL_MAX_DBL (itsLow[k], GSL_MIN_DBL (itsHigh[k], p));
+  }
+  RealArray counts;
+  for (size_t k = 0; k < NFree; k++) {
+    if (itsFree[k] != norm) continue;
+    getCounts (spectrum, worker, parameter, counts);
+    Real model = counts.sum ();
+    Real data = spectrum.itsCounts.sum ();
+    if ((compare (model, 0.) == 1) && (compare (data, 0.) == 1)) {
+      parameter[norm] = GSL_MAX_DBL
+	(itsLow[k], GSL_MIN_DBL (itsHigh[k], parameter[norm] * data / model));
+    }
+  }
+
+  vector<RealArray> derivative, curvature;
+  RealArray gradient;
+  getDerivatives (spectrum, worker, parameter, counts, derivative);
+  Real statistic = getStatistic (spectrum, counts);
+  Real lambda = 1.e-3;
+  bool hasConverged = false;
+  size_t iteration = 0;
+  while (!hasConverged && (iteration < itsMaximumIterations)) {
+    iteration++;
+    getCurvature (spectrum, counts, derivative, gradient, curvature);
+    bool isLower = false;
+    RealArray trial;
+    Real trialStatistic = statistic;
+    while (!isLower && (lambda < MAXIMUM_LAMBDA)) {
+      vector<RealArray> A (curvature);
+      for (size_t k = 0; k < NFree; k++) {
+	A[k][k] += lambda * ((A[k][k] > 0.) ? A[k][k] : 1.);
+      }
+      if (!invertMatrix (A)) {
+	lambda *= 10.;
+	continue;
+      }
+      trial.resize (parameter.size ());
+      trial = parameter;
+      for (size_t k = 0; k < NFree; k++) {
+	Real step = 0.;
+	for (size_t l = 0; l < NFree; l++) step -= A[k][l] * gradient[l];
+	Real& p = trial[itsFree[k]];
+	p = GSL_MAX_DBL (itsLow[k], GSL_MIN_DBL (itsHigh[k], p + step));
+      }
+      RealArray trialCounts;
+      getCounts (spectrum, worker, trial, trialCounts);
+      trialStatistic = getStatistic (spectrum, trialCounts);
+      if (trialStatistic < statistic) {
+	isLower = true;
+	lambda = GSL_MAX_DBL (lambda / 10., 1.e-12);
+      } else {
+	lambda *= 10.;
+      }
+    }
+    if (!isLower) {
+      // no step along the gradient lowers the statistic
+      hasConverged = true;
+      break;
+    }
+    hasConverged = (statistic - trialStatistic < itsCriticalDelta);
+    parameter = trial;
+    statistic = trialStatistic;
+    getDerivatives (spectrum, worker, parameter, counts, derivative);
+  }
+
+  getCurvature (spectrum, counts, derivative, gradient, curvature);
+  result.itsName = spectrum.itsName;
+  result.hasConverged = hasConverged;
+  result.itsNIterations = iteration;
+  result.itsStatistic = getStatistic (spectrum, counts);
+  result.itsNDegrees = (spectrum.itsCounts.size () > NFree) ?
+    spectrum.itsCounts.size () - NFree : 0;
+  result.itsParameter.resize (parameter.size ());
+  result.itsParameter = parameter;
+  result.itsError.resize (parameter.size ());
+  result.itsError = 0.;
+  if (invertMatrix (curvature)) {
+    for (size_t k = 0; k < NFree; k++) {
+      result.itsError[itsFree[k]] = sqrt (GSL_MAX_DBL (2. * curvature[k][k],
+						       0.));
+    }
+  }
+  return;
+}
+
+void BatchFitter::writeResults
+(ostream& file, const vector<string>& names,
+ const vector<FitResult>& result) const
+{
+  file << "name converged iterations statistic dof";
+  for (size_t k = 0; k < itsFree.size (); k++) {
+    const string& name = names[itsFree[k]];
+    file << " " << name << " " << name << "_error";
+  }
+  file << "\n" << setprecision (10);
+  for (size_t j = 0; j < result.size (); j++) {
+    const FitResult& R = result[j];
+    file << R.itsName << " " << (R.hasConverged ? 1 : 0) << " "
+	 << R.itsNIterations << " " << R.itsStatistic << " "
+	 << R.itsNDegrees;
+    for (size_t k = 0; k < itsFree.size (); k++) {
+      file << " " << R.itsParameter[itsFree[k]] << " "
+	   << R.itsError[itsFree[k]];
+    }
+    file << "\n";
+  }
+  return;
+}
@@ -0,0 +1,157 @@
+/***************************************************************************
+    BatchFitter.h   - Fits the windprof family to many independent
+                      spectra at once, spreading the spectra over a
+                      thread pool.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef BATCH_FITTER_H
+#define BATCH_FITTER_H
+
+/*
+  Each spectrum is fitted on its own by Levenberg-Marquardt, with the
+  chi-square or the C-statistic (Cash 1979, as cstat in XSPEC without
+  a background). The model counts are the profile (windprof, hwind,
+  hewind or radwind, normalized as the model gives it) on the energy
+  bins of the response, times the normalization (the last parameter)
+  and the exposure, folded through the response.
+
+  The derivatives are forward differences, computed as a stencil by
+  WindProfileBatch (see WindProfileBatch::getStencilFlux), which keeps
+  the integration error from differing between the points of the
+  stencil; the derivative in the normalization is exact. Each thread
+  keeps one WindProfileBatch for each response it has fitted with, so
+  the x grids are reused from one spectrum to the next. An emulator
+  (see WindProfileEmulator), if given, is shared by the threads as it
+  was read; it is used for a whole stencil when its error estimate is
+  within the tolerance at every point of the stencil.
+
+  The fit stops when a step lowers the statistic by less than the
+  critical delta, or when no step along the gradient lowers it. The
+  errors are the square roots of the diagonal of the covariance matrix
+  from the curvature of the statistic (1 sigma for one parameter).
+*/
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+#include "WindParameter.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+class ResponseMatrix;
+class WindProfileBatch;
+class WindProfileEmulator;
+
+enum FitStatistic {chiSquare, cStatistic};
+
+struct FitSpectrum
+{
+  string itsName;
+  const ResponseMatrix* itsResponse;
+  vector<size_t> itsChannel; // the channels that are fitted
+  RealArray itsCounts; // in those channels
+  RealArray itsError; // for the chi-square; if empty, sqrt (max (counts, 1))
+  Real itsExposure; // s
+};
+
+struct FitResult
+{
+  string itsName;
+  bool hasConverged;
+  size_t itsNIterations;
+  Real itsStatistic;
+  size_t itsNDegrees; // of freedom
+  RealArray itsParameter;
+  RealArray itsError; // 0 for the parameters that are not fitted
+};
+
+class BatchFitter
+{
+ public:
+  // parameter: the starting values, with the normalization last, as
+  // the model gets them. NThreads = 0 means one thread per core.
+  BatchFitter (ModelType type, ConstRealSpan parameter, size_t NThreads = 0);
+  ~BatchFitter ();
+  // A parameter that is fitted, between low and high; the others keep
+  // their starting values.
+  bool setFree (size_t index, Real low, Real high);
+  void setStatistic (FitStatistic statistic) {itsStatistic = statistic;}
+  // Same meaning as WindProfile::setTargetAccuracy.
+  void setTargetAccuracy (Real target) {itsTarget = target;}
+  void setMaximumIterations (size_t N) {itsMaximumIterations = N;}
+  void setCriticalDelta (Real delta) {itsCriticalDelta = delta;}
+  // The emulator must not change while fit is running.
+  void setEmulator (const WindProfileEmulator* emulator, Real tolerance);
+  size_t getNThreads () const {return itsPool.getNThreads ();}
+  // The responses of the spectra must not change while fit is running.
+  void fit (const vector<FitSpectrum>& spectrum, vector<FitResult>& result);
+  /* One line for each spectrum, after a line of column names: the
+     name, whether the fit converged, the iterations, the statistic,
+     the degrees of freedom, then the value and error of each parameter
+     that was fitted. names are those of all the parameters. */
+  void writeResults (ostream& file, const vector<string>& names,
+		     const vector<FitResult>& result) const;
+ private:
+  typedef map<const ResponseMatrix*, WindProfileBatch*> EngineMap;
+  ModelType itsModelType;
+  RealArray itsStart;
+  vector<size_t> itsFree;
+  vector<Real> itsLow;
+  vector<Real> itsHigh;
+  vector<bool> isMapping; // see WindParameter::isMappingParameter
+  FitStatistic itsStatistic;
+  Real itsTarget;
+  size_t itsMaximumIterations;
+  Real itsCriticalDelta;
+  const WindProfileEmulator* itsEmulator;
+  Real itsEmulatorTolerance;
+  ThreadPool itsPool;
+  vector<EngineMap> itsEngine; // by thread
+  void fitSpectrum
+    (const FitSpectrum& spectrum, size_t worker, FitResult& result);
+  WindProfileBatch& getEngine (const ResponseMatrix& response, size_t worker);
+  void getCounts (const FitSpectrum& spectrum, size_t worker,
+		  const RealArray& parameter, RealArray& counts);
+  // The counts, and their derivatives in each free parameter.
+  void getDerivatives
+    (const FitSpectrum& spectrum, size_t worker, const RealArray& parameter,
+     RealArray& counts, vector<RealArray>& derivative);
+  void foldFlux (const FitSpectrum& spectrum, ConstRealSpan flux,
+		 Real norm, RealArray& counts) const;
+  Real getStatistic
+    (const FitSpectrum& spectrum, const RealArray& counts) const;
+  // The gradient of the statistic, and its curvature (twice the
+  // inverse of the covariance matrix).
+  void getCurvature
+    (const FitSpectrum& spectrum, const RealArray& counts,
+     const vector<RealArray>& derivative, RealArray& gradient,
+     vector<RealArray>& curvature) const;
+  void freeEngines ();
+  // To prevent copying and assignment:
+  BatchFitter (const BatchFitter& B);
+  BatchFitter operator = (const BatchFitter& B);
+};
+
+#endif//BATCH_FITTER_H
@@ -0,0 +1,287 @@
+/***************************************************************************
+    ModelTable.cpp  - The model entry points, their lmodel.dat defaults
+                      and the energy grids used by the benchmark and
+                      accuracy programs.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "ModelTable.h"
+#include "Utilities.h"
+#include "WindProfileConfig.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+#define DECLARE_MODEL(name) \
+  extern "C" void name \
+  (const RealArray& energy, const RealArray& parameter, int spectrum, \
+   RealArray& flux, RealArray& fluxError, const string& init)
+
+DECLARE_MODEL (windprof);
+DECLARE_MODEL (hwind);
+DECLARE_MODEL (hewind);
+DECLARE_MODEL (radwind);
+DECLARE_MODEL (abswind);
+#ifndef WINDPROF_NO_TABLES
+DECLARE_MODEL (windcabs);
+DECLARE_MODEL (windtabs);
+DECLARE_MODEL (vwindtab);
+DECLARE_MODEL (vvwindta);
+DECLARE_MODEL (slabtabs);
+DECLARE_MODEL (slamtabs);
+#endif
+DECLARE_MODEL (hgauss);
+DECLARE_MODEL (hcgauss);
+DECLARE_MODEL (hegauss);
+DECLARE_MODEL (hecgauss);
+DECLARE_MODEL (negauss);
+DECLARE_MODEL (necgauss);
+DECLARE_MODEL (vwgauss);
+DECLARE_MODEL (vwcgauss);
+DECLARE_MODEL (wgauss);
+DECLARE_MODEL (vwlorent);
+DECLARE_MODEL (vwcloren);
+DECLARE_MODEL (wlorentz);
+DECLARE_MODEL (gratprof);
+DECLARE_MODEL (gratpr2);
+DECLARE_MODEL (sxslsf);
+DECLARE_MODEL (sxslsf2);
+
+/*-------------------models----------------------*/
+
+static const Model theModels[] = {
+  {"windprof", windprof, "", 24.781, 0.03, false, ""},
+  {"hwind", hwind, "", 18.97, 0.03, false, ""}, // O VIII Ly alpha
+  {"hewind", hewind, "", 9.24, 0.03, false, ""}, // Mg XI triplet
+  {"radwind", radwind, "", 24.781, 0.03, false, ""},
+  {"abswind", abswind, "", 24.781, 0.03, false, ""},
+#ifndef WINDPROF_NO_TABLES // libwindprofile built without CCfits
+  {"windcabs", windcabs, "", 0., 0., true, ""},
+  {"windtabs", windtabs, "", 0., 0., true, ""},
+  {"vwindtab", vwindtab, "", 0., 0., true, ""},
+  {"vvwindta", vvwindta, "", 0., 0., true, ""},
+  {"slabtabs", slabtabs, "", 0., 0., true, ""},
+  {"slamtabs", slamtabs, "", 0., 0., true, ""},
+#endif
+  {"hgauss", hgauss, "", 18.97, 0.03, false, ""},
+  {"hcgauss", hcgauss, "", 18.97, 0.03, false, ""},
+  {"hegauss", hegauss, "", 21.8, 0.03, false, ""}, // O VII triplet
+  {"hecgauss", hecgauss, "", 21.8, 0.03, false, ""},
+  {"negauss", negauss, "", 16.0, 0.08, false, ""}, // Fe XVII 3C to 3G
+  {"necgauss", necgauss, "", 16.0, 0.08, false, ""},
+  {"vwgauss", vwgauss, "", 20., 0.03, false, ""},
+  {"vwcgauss", vwcgauss, "", 20., 0.03, false, ""},
+  {"wgauss", wgauss, "", 20., 0.03, false, ""},
+  {"vwlorent", vwlorent, "", 20., 0.03, false, ""},
+  {"vwcloren", vwcloren, "", 20., 0.03, false, ""},
+  {"wlorentz", wlorentz, "", 20., 0.03, false, ""},
+  {"gratprof", gratprof, "", 20., 0.03, false, ""},
+  {"gratproe", gratprof, "energy", 20., 0.03, false, "energy=0.62"},
+  {"gratpr2", gratpr2, "", 20., 0.03, false, ""},
+  {"gratpr2e", gratpr2, "energy", 20., 0.03, false, "energy=0.62"},
+  {"sxslsf", sxslsf, "", 12.398, 0.03, false, ""}, // e0 = 1 keV
+  {"sxslsf2", sxslsf2, "", 12.398, 0.03, false, ""}
+};
+
+static const size_t theNModels = sizeof (theModels) / sizeof (Model);
+
+size_t getNModels ()
+{
+  return theNModels;
+}
+
+const Model& getModel (size_t i)
+{
+  return theModels[i];
+}
+
+const Model* findModel (const string& name)
+{
+  for (size_t i = 0; i < theNModels; i++) {
+    if (name == theModels[i].itsName) return &theModels[i];
+  }
+  return NULL;
+}
+
+/*-------------------lmodel.dat----------------------*/
+
+static string lowerCase (string s)
+{
+  for (size_t i = 0; i < s.size (); i++) s[i] = tolower (s[i]);
+  return s;
+}
+
+/* Reads the names and default values of the parameters of every
+   model. A parameter line is either a switch ($name value) or
+   name "unit" default min bottom top max delta. Additive models get
+   the normalization last, as XSPEC passes it to the windprof family. */
+bool readModelFile
+(const string& filename, map<string, ParameterList>& defaults)
+{
+  map<string, LimitList> limits;
+  return readModelFile (filename, defaults, limits);
+}
+
+bool readModelFile
+(const string& filename, map<string, ParameterList>& defaults,
+ map<string, LimitList>& limits)
+{
+  ifstream file (filename.c_str ());
+  if (!file) {
+    cerr << "ModelTable: cannot open " << filename << "\n";
+    return false;
+  }
+  string line, model;
+  size_t NRemaining = 0;
+  bool isAdditive = false;
+  while (getline (file, line)) {
+    istringstream words (line);
+    string name;
+    if (!(words >> name)) continue;
+    if (NRemaining == 0) {
+      string low, high, function, type;
+      words >> NRemaining >> low >> high >> function >> type;
+      model = lowerCase (name);
+      defaults[model].clear ();
+      limits[model].clear ();
+      isAdditive = (type == "add");
+      continue;
+    }
+    Real value = 0.;
+    Real low = 0., high = 0.;
+    if (name[0] == '$') {
+      name = name.substr (1);
+      words >> value;
+      low = high = value;
+    } else {
+      size_t open = line.find ('"');
+      size_t close = line.find ('"', open + 1);
+      if (open == string::npos || close == string::npos) {
+	cerr << "ModelTable: cannot read " << model << " parameter "
+	     << name << "\n";
+	return false;
+      }
+      istringstream rest (line.substr (close + 1));
+      Real softLow, softHigh;
+      rest >> value >> low >> softLow >> softHigh >> high;
+    }
+    if (name[name.size () - 1] == '*') name.erase (name.size () - 1);
+    defaults[model].push_back (make_pair (name, value));
+    limits[model].push_back (make_pair (low, high));
+    NRemaining--;
+    if (NRemaining == 0 && isAdditive) {
+      defaults[model].push_back (make_pair (string ("norm"), 1.));
+      limits[model].push_back (make_pair (0., 1.e24));
+    }
+  }
+  return true;
+}
+
+bool makeParameters
+(const ParameterList& defaults, const string& changes, RealArray& parameter)
+{
+  parameter.resize (defaults.size ());
+  for (size_t i = 0; i < defaults.size (); i++) {
+    parameter[i] = defaults[i].second;
+  }
+  istringstream words (changes);
+  string change;
+  while (words >> change) {
+    size_t equals = change.find ('=');
+    string name = change.substr (0, equals);
+    size_t i = 0;
+    while (i < defaults.size () && defaults[i].first != name) i++;
+    if (equals == string::npos || i == defaults.size ()) {
+      cerr << "ModelTable: no parameter " << change << "\n";
+      return false;
+    }
+    parameter[i] = atof (change.substr (equals + 1).c_str ());
+  }
+  return true;
+}
+
+/*-------------------grids----------------------*/
+
+const char* getGridName (GridType type)
+{
+  return (type == grating) ? "grating" : "calorimeter";
+}
+
+/* Grating-like: bins of 5 mA (as for the HETG and RGS). Calorimeter-
+   like: bins of 0.5 eV (as for Resolve). Line models get a window
+   around the line, broadband models 5-40 A or 0.3-12 keV. */
+void makeGrid (GridType type, const Model& model, RealArray& energy)
+{
+  static const Real wavelengthStep = 5.e-3; // A
+  static const Real energyStep = 5.e-4; // keV
+  Real low, high;
+  if (type == grating) {
+    if (model.itsWavelength > 0.) {
+      low = model.itsWavelength * (1. - model.itsWindow);
+      high = model.itsWavelength * (1. + model.itsWindow);
+    } else {
+      low = 5.;
+      high = 40.;
+    }
+    size_t NBins = (size_t) ((high - low) / wavelengthStep + 0.5);
+    energy.resize (NBins + 1);
+    // in increasing energy
+    for (size_t i = 0; i <= NBins; i++) {
+      energy[i] = convert_A_keV (high - i * wavelengthStep);
+    }
+  } else {
+    if (model.itsWavelength > 0.) {
+      Real E0 = convert_A_keV (model.itsWavelength);
+      low = E0 * (1. - model.itsWindow);
+      high = E0 * (1. + model.itsWindow);
+    } else {
+      low = 0.3;
+      high = 12.;
+    }
+    size_t NBins = (size_t) ((high - low) / energyStep + 0.5);
+    energy.resize (NBins + 1);
+    for (size_t i = 0; i <= NBins; i++) {
+      energy[i] = low + i * energyStep;
+    }
+  }
+  return;
+}
+
+vector<GridType> getGrids (const string& selection)
+{
+  vector<GridType> grids;
+  if (selection != "calorimeter") grids.push_back (grating);
+  if (selection != "grating") grids.push_back (calorimeter);
+  return grids;
+}
+
+/*-------------------xset----------------------*/
+
+bool setXspecKey (const string& setting)
+{
+  size_t equals = setting.find ('=');
+  if (equals == string::npos) return false;
+  WindProfileConfig::instance ().set
+    (setting.substr (0, equals), setting.substr (equals + 1));
+  return true;
+}
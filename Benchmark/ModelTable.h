@@ -0,0 +1,84 @@
+/***************************************************************************
+    ModelTable.h    - The model entry points, their lmodel.dat defaults
+                      and the energy grids used by the benchmark and
+                      accuracy programs.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef BENCHMARK_MODEL_TABLE_H
+#define BENCHMARK_MODEL_TABLE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+
+using namespace std;
+
+typedef void (*ModelFunction)
+(const RealArray& energy, const RealArray& parameter, int spectrum,
+ RealArray& flux, RealArray& fluxError, const string& init);
+
+/* wavelength is where the line grids are centred (A), and window
+   their half width relative to it; 0 means a broadband model, which
+   gets a broadband grid instead. setup changes the lmodel.dat
+   defaults in every case (written as for makeParameters). */
+struct Model
+{
+  const char* itsName; // as in lmodel.dat
+  ModelFunction itsFunction;
+  const char* itsInit;
+  Real itsWavelength;
+  Real itsWindow;
+  bool needsTables;
+  const char* itsSetup;
+};
+
+size_t getNModels ();
+const Model& getModel (size_t i);
+// NULL if there is no such model
+const Model* findModel (const string& name);
+
+// The parameter names (switches without the $, and without a trailing
+// *) and default values, by lower case model name.
+typedef vector<pair<string, Real> > ParameterList;
+bool readModelFile
+(const string& filename, map<string, ParameterList>& defaults);
+// The same with the hard limits of each parameter (a switch is limited
+// to its value; the normalization to 0 to 1.e24).
+typedef vector<pair<Real, Real> > LimitList;
+bool readModelFile
+(const string& filename, map<string, ParameterList>& defaults,
+ map<string, LimitList>& limits);
+// changes is a list of name=value separated by spaces.
+bool makeParameters
+(const ParameterList& defaults, const string& changes, RealArray& parameter);
+
+enum GridType {grating, calorimeter};
+const char* getGridName (GridType type);
+void makeGrid (GridType type, const Model& model, RealArray& energy);
+// Reads the --grid option: grating, calorimeter or all.
+vector<GridType> getGrids (const string& selection);
+
+// Sets a model setting (an xset key in XSPEC; see WindProfileConfig)
+// from KEY=VALUE; false if there is no =.
+bool setXspecKey (const string& setting);
+
+#endif//BENCHMARK_MODEL_TABLE_H
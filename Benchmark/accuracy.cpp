@@ -0,0 +1,653 @@
+/***************************************************************************
+    accuracy.cpp    - Compares the faster precision settings of the
+                      models against reference precision on a lattice
+                      of parameters, giving the error next to the cost.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  See Benchmark/README for how to build and run this. For each model,
+  every point of its lattice is evaluated once at reference precision
+  (WINDPROFPRECISION REFERENCE), and then in each mode. The profiles
+  of additive models are normalized to unit sum; multiplicative models
+  are compared as they are. One line of JSON is written per model,
+  grid and mode.
+*/
+
+#include "ModelTable.h"
+#include "PrecisionSchedule.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+/*-------------------lattices and modes----------------------*/
+
+/* Each axis is name=value,value,...; the lattice is all their
+   combinations, on top of the lmodel.dat defaults. */
+struct Lattice
+{
+  const char* itsModel;
+  const char* itsAxes;
+  bool isAdditive;
+};
+
+static const Lattice theLattices[] = {
+  {"windprof", "q=-0.7,0,1 taustar=0.1,1,10 beta=1,2 numerica=0,1", true},
+  {"hwind", "q=-0.7,0,1 taustar=0.1,1,10 beta=1,2 numerica=0,1", true},
+  {"hewind", "q=-0.7,0,1 taustar=0.1,1,10 beta=1,2 numerica=0,1", true},
+  {"radwind", "q=0,1 taustar=0.1,1,10 tau0=0,10 deltae=0,-0.004 "
+   "gamma=0,1.e-3,1.e-5,1.e-7", true},
+  {"abswind", "q=-0.7,0,1 taustar=0.1,1,10 beta=1,2", false},
+  {"windcabs", "q=-0.7,0,1 Sigma=0.01,0.1,1", false},
+  {"sxslsf", "sigma=1,2,5 ftail=0.01,0.1 felc=0.01,0.3", true}
+};
+
+static const size_t theNLattices = sizeof (theLattices) / sizeof (Lattice);
+
+/* A mode is a set of xset keys, applied on top of the defaults below
+   (and of --xset); it can also replace the model by a faster one.
+   models lists the models it applies to (all if empty). The modes that
+   need emulators or table files only run with --emulators, and their
+   xset values are file names in that directory. */
+struct Mode
+{
+  const char* itsName;
+  const char* itsXset;
+  const char* itsModels;
+  const char* itsReplacement;
+  bool needsEmulators;
+};
+
+static const char* theWindprofFamily = "windprof,hwind,hewind,radwind,abswind";
+
+static const Mode theModes[] = {
+  {"full", "", "", "", false},
+  {"fixed", "WINDPROFTOLERANCE=0", theWindprofFamily, "", false},
+  {"tolerance1e-3", "WINDPROFTOLERANCE=1.e-3", theWindprofFamily, "", false},
+  {"coarse", "WINDPROFPRECISION=COARSE", theWindprofFamily, "", false},
+  {"fastmath", "WINDPROFFASTMATH=1", theWindprofFamily, "", false},
+  {"sxslsf2", "", "sxslsf", "sxslsf2", false},
+  {"autodepth", "WINDPROFOPTICALDEPTH=AUTO", "windprof,hwind,hewind,abswind",
+   "", false},
+  {"emulator", "WINDPROFEMULATOR=windprof.emu HWINDEMULATOR=hwind.emu "
+   "HEWINDEMULATOR=hewind.emu", "windprof,hwind,hewind", "", true},
+  {"table", "WINDPTABFILE=windprof.fits", "windprof", "windptab", true},
+  {"table", "HWINDTABFILE=hwind.fits", "hwind", "hwindtab", true},
+  {"table", "HEWINDTBFILE=hewind.fits", "hewind", "hewindtb", true}
+};
+
+static const size_t theNModes = sizeof (theModes) / sizeof (Mode);
+
+#ifndef WINDPROF_NO_TABLES
+extern "C" void windptab
+(const RealArray& energy, const RealArray& parameter, int spectrum,
+ RealArray& flux, RealArray& fluxError, const string& init);
+extern "C" void hwindtab
+(const RealArray& energy, const RealArray& parameter, int spectrum,
+ RealArray& flux, RealArray& fluxError, const string& init);
+extern "C" void hewindtb
+(const RealArray& energy, const RealArray& parameter, int spectrum,
+ RealArray& flux, RealArray& fluxError, const string& init);
+
+// Only replacements, so not in ModelTable (benchmark runs all of those).
+static const Model theTableModels[] = {
+  {"windptab", windptab, "", 24.781, 0.03, false, ""},
+  {"hwindtab", hwindtab, "", 18.97, 0.03, false, ""},
+  {"hewindtb", hewindtb, "", 9.24, 0.03, false, ""}
+};
+
+static const size_t theNTableModels = sizeof (theTableModels) / sizeof (Model);
+#endif
+
+// NULL if the model is not there (e.g. a table model without CCfits).
+static const Model* findReplacement (const string& name)
+{
+  const Model* model = findModel (name);
+#ifndef WINDPROF_NO_TABLES
+  for (size_t i = 0; !model && (i < theNTableModels); i++) {
+    if (name == theTableModels[i].itsName) model = &theTableModels[i];
+  }
+#endif
+  return model;
+}
+
+// KEY=FILE ... to KEY=directory/FILE ...
+static string inDirectory (const string& settings, const string& directory)
+{
+  istringstream words (settings);
+  string setting, result;
+  while (words >> setting) {
+    size_t equals = setting.find ('=');
+    result += " " + setting.substr (0, equals + 1) + directory + "/" +
+      setting.substr (equals + 1);
+  }
+  return result;
+}
+
+static const char* theDefaultXset =
+  "WINDPROFPRECISION=FULL WINDPROFTOLERANCE=1.e-4 WINDPROFFASTMATH=0 "
+  "WINDPROFOPTICALDEPTH=SWITCH WINDPROFEMULATOR= HWINDEMULATOR= HEWINDEMULATOR=";
+
+static bool isListed (const string& list, const string& name)
+{
+  return list.empty () || (("," + list + ",").find ("," + name + ",")
+			   != string::npos);
+}
+
+static void setXspecKeys (const string& settings)
+{
+  istringstream words (settings);
+  string setting;
+  while (words >> setting) setXspecKey (setting);
+  return;
+}
+
+// The changes (as for makeParameters) at every point of the lattice.
+static vector<string> getLatticePoints (const string& axes)
+{
+  vector<string> points (1, string (""));
+  istringstream words (axes);
+  string axis;
+  while (words >> axis) {
+    size_t equals = axis.find ('=');
+    string name = axis.substr (0, equals);
+    istringstream values (axis.substr (equals + 1));
+    string value;
+    vector<string> longer;
+    while (getline (values, value, ',')) {
+      for (size_t i = 0; i < points.size (); i++) {
+	longer.push_back (points[i] + (points[i].empty () ? "" : " ")
+			  + name + "=" + value);
+      }
+    }
+    points.swap (longer);
+  }
+  return points;
+}
+
+/*-------------------evaluation----------------------*/
+
+static Real evaluate
+(ModelFunction function, const string& init, const RealArray& energy,
+ const RealArray& parameter, size_t NRepeats, bool isAdditive,
+ RealArray& profile)
+{
+  RealArray fluxError;
+  vector<Real> seconds (NRepeats);
+  for (size_t i = 0; i < NRepeats; i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now ();
+    function (energy, parameter, 1, profile, fluxError, init);
+    chrono::duration<double> elapsed = chrono::steady_clock::now () - start;
+    seconds[i] = elapsed.count ();
+  }
+  if (isAdditive) {
+    Real total = profile.sum ();
+    if (compare (total, 0.) != 0) profile /= total;
+  }
+  sort (seconds.begin (), seconds.end ());
+  return seconds[NRepeats / 2];
+}
+
+// Deviations relative to the peak of the reference profile.
+struct Deviation
+{
+  Real itsMaximum;
+  Real itsSumSquares;
+  Real itsSumAbsolute;
+  size_t itsNBins;
+};
+
+static Deviation getDeviation
+(const RealArray& profile, const RealArray& reference)
+{
+  Deviation D = {0., 0., 0., reference.size ()};
+  Real peak = 0.;
+  for (size_t i = 0; i < reference.size (); i++) {
+    peak = max (peak, fabs (reference[i]));
+  }
+  if (compare (peak, 0.) == 0) peak = 1.;
+  for (size_t i = 0; i < reference.size (); i++) {
+    Real d = fabs (profile[i] - reference[i]);
+    if (!isfinite (d)) d = HUGE_VAL;
+    D.itsMaximum = max (D.itsMaximum, d / peak);
+    D.itsSumSquares += (d / peak) * (d / peak);
+    D.itsSumAbsolute += d;
+  }
+  return D;
+}
+
+struct Summary
+{
+  size_t itsNPoints;
+  Real itsMaximum;
+  string itsWorstPoint;
+  Real itsSumSquares;
+  size_t itsNBins;
+  Real itsMaximumSumAbsolute;
+  Real itsSeconds;
+  Real itsReferenceSeconds;
+};
+
+static void writeSummary
+(ostream& out, const string& model, GridType type, const string& mode,
+ const Summary& S)
+{
+  Real rms = sqrt (S.itsSumSquares / max (S.itsNBins, (size_t) 1));
+  out << "{\"model\": \"" << model << "\", \"grid\": \""
+      << getGridName (type) << "\", \"mode\": \"" << mode
+      << "\", \"points\": " << S.itsNPoints << setprecision (4)
+      << ", \"max_dev\": " << S.itsMaximum
+      << ", \"rms_dev\": " << rms
+      << ", \"max_sum_abs_dev\": " << S.itsMaximumSumAbsolute
+      << ", \"worst\": \"" << S.itsWorstPoint
+      << "\", \"ms\": " << 1.e3 * S.itsSeconds / S.itsNPoints
+      << ", \"reference_ms\": " << 1.e3 * S.itsReferenceSeconds / S.itsNPoints
+      << ", \"speedup\": " << S.itsReferenceSeconds / S.itsSeconds
+      << "}\n";
+  out.flush ();
+  return;
+}
+
+/*-------------------progressive fit----------------------*/
+
+/* A fit as XSPEC does it, with WINDPROFPRECISION PROGRESSIVE: 
+   Levenberg-Marquardt on the chi-square, with forward differences of
+   DERIVATIVE_STEP (relative, or absolute below 1), stopping when an
+   accepted step lowers the chi-square by less than FIT_DELTA. The data
+   are the full precision profile at the lmodel.dat defaults, scaled to
+   FIT_COUNTS, with Gaussian noise (from a fixed seed) of the square
+   root of the counts, and the fit starts from itsStart. The chi-square
+   of the last accepted call is then compared with that of a full
+   precision call at the same parameters: they are the same if the fit
+   ended at full precision, as the chi-square reported by XSPEC should
+   be. The factors of the schedule are also checked: more than two
+   calls should be loosened (or the mode saves nothing), and the
+   derivatives of a point should have the factor of the point (or the
+   differences mix two precisions). */
+struct FitCheck
+{
+  const char* itsModel;
+  const char* itsFree;
+  const char* itsStart;
+};
+
+static const FitCheck theFitChecks[] = {
+  {"windprof", "q,taustar", "q=0.3 taustar=2"},
+  {"hwind", "q,taustar", "q=0.3 taustar=2"},
+  {"hewind", "q,taustar", "q=0.3 taustar=2"},
+  {"radwind", "q,taustar", "q=0.3 taustar=2"}
+};
+
+static const size_t theNFitChecks = sizeof (theFitChecks) / sizeof (FitCheck);
+
+static const Real FIT_COUNTS = 1.e5;
+static const Real DERIVATIVE_STEP = 1.e-2;
+static const Real FIT_DELTA = 1.e-2;
+static const size_t MAXIMUM_FIT_ITERATIONS = 30;
+static const unsigned FIT_SEED = 12345;
+
+static Real getChiSquare (const RealArray& model, const RealArray& data)
+{
+  Real chi = 0.;
+  for (size_t i = 0; i < data.size (); i++) {
+    Real d = FIT_COUNTS * (model[i] - data[i]);
+    chi += d * d / max (FIT_COUNTS * data[i], 1.);
+  }
+  return chi;
+}
+
+// Gaussian elimination with partial pivoting; false if singular.
+static bool solveLinear (vector<RealArray> A, RealArray& x)
+{
+  size_t N = x.size ();
+  for (size_t c = 0; c < N; c++) {
+    size_t pivot = c;
+    for (size_t r = c + 1; r < N; r++) {
+      if (fabs (A[r][c]) > fabs (A[pivot][c])) pivot = r;
+    }
+    if (A[pivot][c] == 0.) return false;
+    swap (A[c], A[pivot]);
+    swap (x[c], x[pivot]);
+    for (size_t r = c + 1; r < N; r++) {
+      Real factor = A[r][c] / A[c][c];
+      for (size_t k = c; k < N; k++) A[r][k] -= factor * A[c][k];
+      x[r] -= factor * x[c];
+    }
+  }
+  for (size_t c = N; c-- > 0;) {
+    for (size_t k = c + 1; k < N; k++) x[c] -= A[c][k] * x[k];
+    x[c] /= A[c][c];
+  }
+  return true;
+}
+
+// True if the fit ended at the full precision statistic, with more
+// than two loose calls and derivatives at the factor of their point.
+static bool writeFitCheck
+(ostream& out, const Model& model, GridType type, const ParameterList& list,
+ const string& userXset, const FitCheck& check)
+{
+  string name (model.itsName);
+  RealArray energy, truth, parameter;
+  makeGrid (type, model, energy);
+  if (!makeParameters (list, model.itsSetup, truth) ||
+      !makeParameters (list, string (model.itsSetup) + " " + check.itsStart,
+		       parameter)) {
+    return false;
+  }
+  vector<size_t> free;
+  istringstream names (check.itsFree);
+  string freeName;
+  while (getline (names, freeName, ',')) {
+    for (size_t i = 0; i < list.size (); i++) {
+      if (list[i].first == freeName) free.push_back (i);
+    }
+  }
+  size_t NFree = free.size ();
+  setXspecKeys (theDefaultXset + userXset);
+  RealArray data;
+  evaluate (model.itsFunction, model.itsInit, energy, truth, 1, true, data);
+  mt19937 generator (FIT_SEED);
+  normal_distribution<Real> noise;
+  for (size_t i = 0; i < data.size (); i++) {
+    data[i] += sqrt (max (data[i], 0.) / FIT_COUNTS) * noise (generator);
+  }
+
+  setXspecKeys (theDefaultXset + userXset + " WINDPROFPRECISION=PROGRESSIVE");
+  PrecisionSchedule& schedule = PrecisionSchedule::instance ();
+  string key = name + "1"; // the state of spectrum 1 (see windprof.cpp)
+  size_t NCalls = 1;
+  RealArray profile;
+  evaluate (model.itsFunction, model.itsInit, energy, parameter, 1, true,
+	    profile);
+  Real pointFactor = schedule.getLastFactor (key);
+  size_t NLooseCalls = (pointFactor > 1.) ? 1 : 0;
+  bool isConsistent = true;
+  Real chi = getChiSquare (profile, data);
+  Real lambda = 1.e-3;
+  size_t iteration = 0;
+  bool hasConverged = false;
+  while (!hasConverged && (iteration < MAXIMUM_FIT_ITERATIONS)) {
+    iteration++;
+    vector<RealArray> derivative (NFree);
+    for (size_t k = 0; k < NFree; k++) {
+      RealArray shifted (parameter);
+      Real h = DERIVATIVE_STEP * max (fabs (parameter[free[k]]), 1.);
+      shifted[free[k]] += h;
+      evaluate (model.itsFunction, model.itsInit, energy, shifted, 1, true,
+		derivative[k]);
+      NCalls++;
+      Real factor = schedule.getLastFactor (key);
+      if (factor > 1.) NLooseCalls++;
+      if (factor != pointFactor) isConsistent = false;
+      derivative[k] = (derivative[k] - profile) / h;
+    }
+    vector<RealArray> curvature (NFree, RealArray (0., NFree));
+    RealArray gradient (0., NFree);
+    for (size_t i = 0; i < data.size (); i++) {
+      Real weight = FIT_COUNTS / max (FIT_COUNTS * data[i], 1.);
+      for (size_t k = 0; k < NFree; k++) {
+	gradient[k] += FIT_COUNTS * weight * (data[i] - profile[i]) *
+	  derivative[k][i];
+	for (size_t l = 0; l < NFree; l++) {
+	  curvature[k][l] += FIT_COUNTS * weight * derivative[k][i] *
+	    derivative[l][i];
+	}
+      }
+    }
+    bool isLower = false;
+    while (!isLower && (lambda < 1.e10)) {
+      vector<RealArray> A (curvature);
+      for (size_t k = 0; k < NFree; k++) A[k][k] *= 1. + lambda;
+      RealArray step (gradient);
+      if (!solveLinear (A, step)) break;
+      RealArray trial (parameter), trialProfile;
+      for (size_t k = 0; k < NFree; k++) trial[free[k]] += step[k];
+      evaluate (model.itsFunction, model.itsInit, energy, trial, 1, true,
+		trialProfile);
+      NCalls++;
+      Real trialFactor = schedule.getLastFactor (key);
+      if (trialFactor > 1.) NLooseCalls++;
+      Real trialChi = getChiSquare (trialProfile, data);
+      if (trialChi < chi) {
+	isLower = true;
+	hasConverged = (chi - trialChi < FIT_DELTA);
+	parameter = trial;
+	profile = trialProfile;
+	chi = trialChi;
+	pointFactor = trialFactor;
+	lambda = max (lambda / 10., 1.e-12);
+      } else {
+	lambda *= 10.;
+      }
+    }
+    if (!isLower) hasConverged = true;
+  }
+
+  setXspecKeys (theDefaultXset + userXset);
+  RealArray full;
+  evaluate (model.itsFunction, model.itsInit, energy, parameter, 1, true,
+	    full);
+  Real fullChi = getChiSquare (full, data);
+  out << "{\"model\": \"" << name << "\", \"grid\": \""
+      << getGridName (type) << "\", \"mode\": \"progressive_fit\""
+      << ", \"converged\": " << (hasConverged ? "true" : "false")
+      << ", \"iterations\": " << iteration << ", \"calls\": " << NCalls
+      << ", \"loose_calls\": " << NLooseCalls
+      << ", \"consistent_derivatives\": "
+      << (isConsistent ? "true" : "false")
+      << setprecision (6) << ", \"statistic\": " << chi
+      << ", \"full_statistic\": " << fullChi
+      << ", \"full_precision_at_end\": "
+      << ((chi == fullChi) ? "true" : "false") << "}\n";
+  out.flush ();
+  return (chi == fullChi) && (NLooseCalls > 2) && isConsistent;
+}
+
+/*-------------------main----------------------*/
+
+static void usage ()
+{
+  cerr << "usage: accuracy [options]\n"
+       << "  --lmodel FILE      model definitions (default lmodel.dat)\n"
+       << "  --output FILE      JSON lines output (default stdout)\n"
+       << "  --repeat N         timed calls per point and mode (default 3)\n"
+       << "  --model A,B,...    only these models (default all)\n"
+       << "  --grid TYPE        grating, calorimeter or all (default all)\n"
+       << "  --mode A,B,...     only these modes (default all)\n"
+       << "  --tables DIR       run windcabs, with WINDTABSDIRECTORY set\n"
+       << "                     to DIR\n"
+       << "  --emulators DIR    run the emulator and table modes, with\n"
+       << "                     the files in DIR\n"
+       << "  --xset KEY=VALUE   set an xset key (may be repeated)\n"
+       << "  --limit X          exit with 1 if a mode misplaces more than\n"
+       << "                     X of a profile, or if a progressive fit\n"
+       << "                     does not end at full precision\n";
+  return;
+}
+
+int main (int argc, char** argv)
+{
+  string modelFile ("lmodel.dat");
+  string outputFile;
+  size_t NRepeats = 3;
+  string selection;
+  string modeSelection;
+  string gridSelection ("all");
+  string userXset;
+  bool hasTables = false;
+  string emulatorDirectory;
+  Real limit = 0.; // no limit
+  for (int i = 1; i < argc; i++) {
+    string option (argv[i]);
+    if (i + 1 >= argc) {
+      usage ();
+      return 1;
+    }
+    string value (argv[++i]);
+    if (option == "--lmodel") {
+      modelFile = value;
+    } else if (option == "--output") {
+      outputFile = value;
+    } else if (option == "--repeat") {
+      NRepeats = atoi (value.c_str ());
+    } else if (option == "--model") {
+      selection = value;
+    } else if (option == "--mode") {
+      modeSelection = value;
+    } else if (option == "--grid") {
+      gridSelection = value;
+    } else if (option == "--tables") {
+      userXset += " WINDTABSDIRECTORY=" + value;
+      hasTables = true;
+    } else if (option == "--emulators") {
+      emulatorDirectory = value;
+    } else if (option == "--limit") {
+      limit = atof (value.c_str ());
+    } else if (option == "--xset") {
+      if (value.find ('=') == string::npos) {
+	usage ();
+	return 1;
+      }
+      userXset += " " + value;
+    } else {
+      usage ();
+      return 1;
+    }
+  }
+  if (NRepeats < 1) NRepeats = 1;
+
+  map<string, ParameterList> defaults;
+  if (!readModelFile (modelFile, defaults)) return 1;
+
+  ofstream file;
+  if (!outputFile.empty ()) file.open (outputFile.c_str ());
+  ostream& out = outputFile.empty () ? cout : file;
+
+  vector<GridType> grids = getGrids (gridSelection);
+  bool isPassed = true;
+
+  for (size_t l = 0; l < theNLattices; l++) {
+    const Lattice& lattice = theLattices[l];
+    string name (lattice.itsModel);
+    const Model* model = findModel (name);
+    if (!isListed (selection, name) || !model) continue;
+    if (model->needsTables && !hasTables) {
+      out << "{\"model\": \"" << name
+	  << "\", \"skipped\": \"no --tables directory\"}\n";
+      continue;
+    }
+    vector<const Mode*> modes;
+    for (size_t m = 0; m < theNModes; m++) {
+      const Mode& mode = theModes[m];
+      if (mode.needsEmulators && emulatorDirectory.empty ()) continue;
+      if (*mode.itsReplacement && !findReplacement (mode.itsReplacement)) {
+	continue;
+      }
+      if (isListed (mode.itsModels, name) &&
+	  isListed (modeSelection, mode.itsName)) {
+	modes.push_back (&theModes[m]);
+      }
+    }
+    for (size_t c = 0; c < theNFitChecks; c++) {
+      if ((name != theFitChecks[c].itsModel) ||
+	  !isListed (modeSelection, "progressive_fit")) {
+	continue;
+      }
+      for (size_t g = 0; g < grids.size (); g++) {
+	if (!writeFitCheck (out, *model, grids[g], defaults[name], userXset,
+			    theFitChecks[c]) && (limit > 0.)) {
+	  cerr << "accuracy: the progressive fit of " << name
+	       << " failed its check\n";
+	  isPassed = false;
+	}
+      }
+    }
+    if (modes.empty ()) continue;
+    vector<string> points = getLatticePoints (lattice.itsAxes);
+    for (size_t g = 0; g < grids.size (); g++) {
+      RealArray energy;
+      makeGrid (grids[g], *model, energy);
+      vector<Summary> summary (modes.size ());
+      for (size_t m = 0; m < modes.size (); m++) {
+	Summary S = {0, 0., "", 0., 0, 0., 0., 0.};
+	summary[m] = S;
+      }
+      for (size_t p = 0; p < points.size (); p++) {
+	RealArray parameter;
+	string changes = string (model->itsSetup) + " " + points[p];
+	if (!makeParameters (defaults[name], changes, parameter)) return 1;
+	setXspecKeys (theDefaultXset + userXset + " WINDPROFPRECISION=REFERENCE");
+	RealArray reference;
+	Real referenceSeconds =
+	  evaluate (model->itsFunction, model->itsInit, energy, parameter,
+		    1, lattice.isAdditive, reference);
+	for (size_t m = 0; m < modes.size (); m++) {
+	  const Mode& mode = *modes[m];
+	  string xset (mode.itsXset);
+	  if (mode.needsEmulators) xset = inDirectory (xset, emulatorDirectory);
+	  setXspecKeys (theDefaultXset + userXset + " " + xset);
+	  const Model* evaluated = model;
+	  if (*mode.itsReplacement) {
+	    evaluated = findReplacement (mode.itsReplacement);
+	  }
+	  // once untimed, e.g. to load tables
+	  RealArray profile;
+	  evaluate (evaluated->itsFunction, evaluated->itsInit, energy,
+		    parameter, 1, lattice.isAdditive, profile);
+	  Real seconds =
+	    evaluate (evaluated->itsFunction, evaluated->itsInit, energy,
+		      parameter, NRepeats, lattice.isAdditive, profile);
+	  Deviation D = getDeviation (profile, reference);
+	  Summary& S = summary[m];
+	  S.itsNPoints++;
+	  if ((p == 0) || (D.itsMaximum > S.itsMaximum)) {
+	    S.itsMaximum = D.itsMaximum;
+	    S.itsWorstPoint = points[p];
+	  }
+	  S.itsSumSquares += D.itsSumSquares;
+	  S.itsNBins += D.itsNBins;
+	  S.itsMaximumSumAbsolute = max (S.itsMaximumSumAbsolute,
+					 D.itsSumAbsolute);
+	  S.itsSeconds += seconds;
+	  S.itsReferenceSeconds += referenceSeconds;
+	}
+      }
+      for (size_t m = 0; m < modes.size (); m++) {
+	writeSummary (out, name, grids[g], modes[m]->itsName, summary[m]);
+	if ((limit > 0.) && (summary[m].itsMaximumSumAbsolute > limit)) {
+	  cerr << "accuracy: " << name << " " << getGridName (grids[g])
+	       << " " << modes[m]->itsName << " exceeds the limit\n";
+	  isPassed = false;
+	}
+      }
+    }
+  }
+  return isPassed ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+/***************************************************************************
+    benchmark.cpp   - Times the model entry points on grating-like and
+                      calorimeter-like energy grids, and counts their
+                      integrand evaluations and memory allocations.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  See Benchmark/README for how to build and run this. Each model is
+  evaluated with its lmodel.dat defaults and with a few stress cases,
+  and one line of JSON is written per model, case and grid.
+*/
+
+#include "ModelTable.h"
+#include "IntegrationProfiler.h"
+#include "WindProfileConfig.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+/*-------------------allocation counting----------------------*/
+
+/* Every C++ allocation in the process goes through these (valarray
+   and vector storage, new of the integration classes, ...). The GSL
+   workspaces are allocated with malloc and are not counted. */
+
+static atomic<size_t> theNAllocations (0);
+static atomic<size_t> theNBytes (0);
+
+void* operator new (size_t size)
+{
+  theNAllocations.fetch_add (1, memory_order_relaxed);
+  theNBytes.fetch_add (size, memory_order_relaxed);
+  void* p = malloc (size ? size : 1);
+  if (!p) throw bad_alloc ();
+  return p;
+}
+
+void operator delete (void* p) noexcept
+{
+  free (p);
+  return;
+}
+
+void operator delete (void* p, size_t) noexcept
+{
+  free (p);
+  return;
+}
+
+/*-------------------cases----------------------*/
+
+/* Parameters changed from the lmodel.dat defaults, by name (switches
+   without the $). Every model also gets a "default" case. */
+struct Case
+{
+  const char* itsModel;
+  const char* itsName;
+  const char* itsChanges;
+};
+
+static const Case theCases[] = {
+  {"windprof", "q-0.7", "q=-0.7"},
+  {"windprof", "porous", "numerica=1 h=1"},
+  {"windprof", "HeII", "kappaRatio=1"},
+  {"windprof", "tau0star100", "tau0star=100"},
+  {"windprof", "taustar10", "taustar=10"},
+  {"hwind", "q-0.7", "q=-0.7"},
+  {"hwind", "porous", "numerica=1 h=1"},
+  {"hwind", "HeII", "kappaRatio=1"},
+  {"hwind", "tau0star100", "tau0star=100"},
+  {"hewind", "q-0.7", "q=-0.7"},
+  {"hewind", "porous", "numerica=1 h=1"},
+  {"hewind", "HeII", "kappaRatio=1"},
+  {"hewind", "tau0star100", "tau0star=100"},
+  {"radwind", "q-0.7", "q=-0.7"},
+  {"radwind", "tau0-10", "tau0=10 gamma=0.01 deltae=0.01"},
+  {"abswind", "q-0.7", "q=-0.7"},
+  {"abswind", "taustar10", "taustar=10"},
+  {"windcabs", "q-0.7", "q=-0.7"},
+  {"windcabs", "Sigma1", "Sigma=1"},
+  {"windtabs", "Sigma1", "Sigma=1"},
+  {"vwindtab", "Sigma1", "Sigma=1"},
+  {"vvwindta", "Sigma1", "Sigma=1"},
+  {"slabtabs", "nH10", "nH=10"},
+  {"slamtabs", "Sigma1", "Sigma=1"},
+  {"hgauss", "resolved", "sigma_v=1000"},
+  {"hcgauss", "resolved", "sigma_v=1000"},
+  {"hegauss", "resolved", "sigma_v=1000"},
+  {"hecgauss", "resolved", "sigma_v=1000"},
+  {"negauss", "resolved", "sigma_v=1000"},
+  {"necgauss", "resolved", "sigma_v=1000"},
+  {"vwgauss", "resolved", "sigma_v=1000"},
+  {"vwcgauss", "resolved", "sigma_v=1000"},
+  {"wgauss", "resolved", "sigma_l=50"},
+  {"vwlorent", "resolved", "gamma_v=1000"},
+  {"vwcloren", "resolved", "gamma_v=1000"},
+  {"wlorentz", "resolved", "gamma_l=50"},
+  {"gratprof", "resolved", "sigma_l=10 gamma_l=10"},
+  {"gratproe", "resolved", "sigma_e=5.e-4 gamma_e=5.e-4"},
+  {"gratpr2", "resolved", "sigma_l=10 gamma_l1=10 gamma_l2=30"},
+  {"gratpr2e", "resolved", "sigma_e=5.e-4 gamma_e1=5.e-4 gamma_e2=1.5e-3"},
+  {"sxslsf", "tail", "ftail=0.1 felc=0.3"},
+  {"sxslsf2", "tail", "ftail=0.1 felc=0.3"}
+};
+
+static const size_t theNCases = sizeof (theCases) / sizeof (Case);
+
+/*-------------------timing----------------------*/
+
+struct Result
+{
+  vector<Real> itsSeconds;
+  size_t itsNAllocations;
+  size_t itsNBytes;
+  bool hasCounts;
+  size_t itsNIntegrations;
+  size_t itsNCalls;
+  size_t itsNFailures;
+  Real itsFluxSum;
+};
+
+static void resetCounts ()
+{
+#ifdef WINDPROF_PROFILE
+  size_t NIntegrations, NCalls, NFailures;
+  IntegrationProfiler::instance ().getTotals (NIntegrations, NCalls, NFailures);
+#endif
+  return;
+}
+
+/* One untimed call first, so that tables are loaded and caches are
+   warm; the counts are then per call, averaged over the repeats. */
+static void runCase
+(const Model& model, const RealArray& energy, const RealArray& parameter,
+ size_t NRepeats, Result& result)
+{
+  RealArray flux, fluxError;
+  string init (model.itsInit);
+  model.itsFunction (energy, parameter, 1, flux, fluxError, init);
+  resetCounts ();
+  size_t startAllocations = theNAllocations.load ();
+  size_t startBytes = theNBytes.load ();
+  result.itsSeconds.resize (NRepeats);
+  for (size_t i = 0; i < NRepeats; i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now ();
+    model.itsFunction (energy, parameter, 1, flux, fluxError, init);
+    chrono::duration<double> elapsed = chrono::steady_clock::now () - start;
+    result.itsSeconds[i] = elapsed.count ();
+  }
+  result.itsNAllocations = (theNAllocations.load () - startAllocations) / NRepeats;
+  result.itsNBytes = (theNBytes.load () - startBytes) / NRepeats;
+  result.hasCounts = false;
+  result.itsNIntegrations = 0;
+  result.itsNCalls = 0;
+  result.itsNFailures = 0;
+#ifdef WINDPROF_PROFILE
+  IntegrationProfiler::instance ().getTotals
+    (result.itsNIntegrations, result.itsNCalls, result.itsNFailures);
+  result.itsNIntegrations /= NRepeats;
+  result.itsNCalls /= NRepeats;
+  result.itsNFailures /= NRepeats;
+  result.hasCounts = true;
+#endif
+  result.itsFluxSum = 0.;
+  for (size_t i = 0; i < flux.size (); i++) result.itsFluxSum += flux[i];
+  return;
+}
+
+static Real getQuantile (const vector<Real>& sorted, Real fraction)
+{
+  Real position = fraction * (sorted.size () - 1);
+  size_t i = (size_t) position;
+  if (i + 1 >= sorted.size ()) return sorted.back ();
+  Real weight = position - i;
+  return (1. - weight) * sorted[i] + weight * sorted[i+1];
+}
+
+static void writeResult
+(ostream& out, const Model& model, const string& caseName, GridType type,
+ size_t NBins, const Result& result)
+{
+  vector<Real> ms (result.itsSeconds);
+  for (size_t i = 0; i < ms.size (); i++) ms[i] *= 1.e3;
+  vector<Real> sorted (ms);
+  sort (sorted.begin (), sorted.end ());
+  Real mean = 0.;
+  for (size_t i = 0; i < ms.size (); i++) mean += ms[i];
+  mean /= ms.size ();
+  out << "{\"model\": \"" << model.itsName << "\", \"case\": \"" << caseName
+      << "\", \"grid\": \"" << getGridName (type) << "\", \"bins\": " << NBins
+      << ", \"repeats\": " << ms.size () << setprecision (6)
+      << ", \"ms\": {\"min\": " << sorted.front ()
+      << ", \"median\": " << getQuantile (sorted, 0.5)
+      << ", \"p90\": " << getQuantile (sorted, 0.9)
+      << ", \"max\": " << sorted.back () << ", \"mean\": " << mean
+      << "}, \"samples_ms\": [";
+  for (size_t i = 0; i < ms.size (); i++) {
+    out << (i ? ", " : "") << ms[i];
+  }
+  out << "], \"allocations\": " << result.itsNAllocations
+      << ", \"bytes\": " << result.itsNBytes;
+  if (result.hasCounts) {
+    out << ", \"integrations\": " << result.itsNIntegrations
+	<< ", \"integrand_calls\": " << result.itsNCalls
+	<< ", \"failures\": " << result.itsNFailures;
+  } else {
+    out << ", \"integrations\": null, \"integrand_calls\": null"
+	<< ", \"failures\": null";
+  }
+  out << ", \"flux_sum\": " << setprecision (10) << result.itsFluxSum
+      << "}\n";
+  out.flush ();
+  return;
+}
+
+static void writeSkipped (ostream& out, const Model& model, const string& why)
+{
+  out << "{\"model\": \"" << model.itsName << "\", \"skipped\": \""
+      << why << "\"}\n";
+  return;
+}
+
+/*-------------------main----------------------*/
+
+static void usage ()
+{
+  cerr << "usage: benchmark [options]\n"
+       << "  --lmodel FILE      model definitions (default lmodel.dat)\n"
+       << "  --output FILE      JSON lines output (default stdout)\n"
+       << "  --repeat N         timed calls per case (default 10)\n"
+       << "  --model A,B,...    only these models (default all)\n"
+       << "  --grid TYPE        grating, calorimeter or all (default all)\n"
+       << "  --tables DIR       run the tabulated models, with\n"
+       << "                     WINDTABSDIRECTORY set to DIR\n"
+       << "  --xset KEY=VALUE   set an xset key (may be repeated)\n";
+  return;
+}
+
+int main (int argc, char** argv)
+{
+  string modelFile ("lmodel.dat");
+  string outputFile;
+  size_t NRepeats = 10;
+  string selection;
+  string gridSelection ("all");
+  bool hasTables = false;
+  for (int i = 1; i < argc; i++) {
+    string option (argv[i]);
+    if (i + 1 >= argc) {
+      usage ();
+      return 1;
+    }
+    string value (argv[++i]);
+    if (option == "--lmodel") {
+      modelFile = value;
+    } else if (option == "--output") {
+      outputFile = value;
+    } else if (option == "--repeat") {
+      NRepeats = atoi (value.c_str ());
+    } else if (option == "--model") {
+      selection = "," + value + ",";
+    } else if (option == "--grid") {
+      gridSelection = value;
+    } else if (option == "--tables") {
+      WindProfileConfig::instance ().set ("WINDTABSDIRECTORY", value);
+      hasTables = true;
+    } else if (option == "--xset") {
+      if (!setXspecKey (value)) {
+	usage ();
+	return 1;
+      }
+    } else {
+      usage ();
+      return 1;
+    }
+  }
+  if (NRepeats < 1) NRepeats = 1;
+
+  map<string, ParameterList> defaults;
+  if (!readModelFile (modelFile, defaults)) return 1;
+
+#ifdef WINDPROF_PROFILE
+  IntegrationProfiler::instance ().setMode ("quiet");
+#endif
+
+  ofstream file;
+  if (!outputFile.empty ()) file.open (outputFile.c_str ());
+  ostream& out = outputFile.empty () ? cout : file;
+
+  vector<GridType> grids = getGrids (gridSelection);
+
+  for (size_t m = 0; m < getNModels (); m++) {
+    const Model& model = getModel (m);
+    string name (model.itsName);
+    if (!selection.empty () && selection.find ("," + name + ",") == string::npos)
+      continue;
+    if (model.needsTables && !hasTables) {
+      writeSkipped (out, model, "no --tables directory");
+      continue;
+    }
+    map<string, ParameterList>::const_iterator found =
+      defaults.find (name);
+    if (found == defaults.end ()) {
+      writeSkipped (out, model, "not in " + modelFile);
+      continue;
+    }
+    vector<pair<string, string> > cases;
+    cases.push_back (make_pair (string ("default"), string ("")));
+    for (size_t c = 0; c < theNCases; c++) {
+      if (name == theCases[c].itsModel) {
+	cases.push_back (make_pair (string (theCases[c].itsName),
+				    string (theCases[c].itsChanges)));
+      }
+    }
+    for (size_t c = 0; c < cases.size (); c++) {
+      RealArray parameter;
+      string changes = string (model.itsSetup) + " " + cases[c].second;
+      if (!makeParameters (found->second, changes, parameter)) {
+	return 1;
+      }
+      for (size_t g = 0; g < grids.size (); g++) {
+	RealArray energy;
+	makeGrid (grids[g], model, energy);
+	Result result;
+	runCase (model, energy, parameter, NRepeats, result);
+	writeResult (out, model, cases[c].first, grids[g],
+		     energy.size () - 1, result);
+      }
+    }
+  }
+  return 0;
+}
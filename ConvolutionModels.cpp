@@ -0,0 +1,196 @@
+/***************************************************************************
+    ConvolutionModels.cpp - XSPEC convolution models that apply the
+      grating (gratprof, gratpr2) and calorimeter (sxslsf) line spread
+      functions to an arbitrary model spectrum.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <iostream>
+#include <map>
+#include <sstream>
+using namespace std;
+
+#include "xsTypes.h"
+#include "Utilities.h"
+#include "LSFConvolution.h"
+#include "isisCPPFunctionWrapper.h"
+
+static const size_t GRATCONV_N_PARAMETERS (3);
+static const size_t GRATCNV2_N_PARAMETERS (5);
+static const size_t SXSCONV_N_PARAMETERS (4);
+
+extern "C" void gratconv
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void gratcnv2
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void sxsconv
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void C_gratconv
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, GRATCONV_N_PARAMETERS, &gratconv);
+  return;
+}
+
+extern "C" void C_gratcnv2
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, GRATCNV2_N_PARAMETERS, &gratcnv2);
+  return;
+}
+
+extern "C" void C_sxsconv
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, SXSCONV_N_PARAMETERS, &sxsconv);
+  return;
+}
+
+/***************************/
+
+/* One cache per model component and spectrum, since the kernel
+   transform or band depends on both the grid and the parameters. */
+static LSFConvolution& getConvolution (const string& name, int spectrum)
+{
+  static map<string, LSFConvolution> convolution;
+  ostringstream key;
+  key << name << spectrum;
+  return convolution[key.str ()];
+}
+
+static bool checkEnergy (const RealArray& energy, const string& name)
+{
+  if ((energy.size () < 3) || isBackwards (energy) ||
+      (compare (energy[0], 0.) != 1)) {
+    cout << name << ": need an increasing energy grid above 0 keV\n";
+    return false;
+  }
+  return true;
+}
+
+/* The grating LSF has a constant width in wavelength, so it is
+   convolved on the wavelength grid (in increasing order). */
+static void gratingConvolution
+(const RealArray& energy, RealArray& flux, GratingKernel& kernel,
+ const RealArray& parameter, int spectrum, const string& name)
+{
+  if (!checkEnergy (energy, name)) return;
+  size_t esize = energy.size ();
+  size_t fsize = flux.size ();
+  RealArray wavelength (esize);
+  for (size_t i = 0; i < esize; i++) {
+    wavelength[i] = convert_A_keV (energy[esize - 1 - i]);
+  }
+  RealArray wflux (fsize);
+  for (size_t i = 0; i < fsize; i++) wflux[i] = flux[fsize - 1 - i];
+  getConvolution (name, spectrum).convolve
+    (wavelength, kernel, parameter, wflux);
+  for (size_t i = 0; i < fsize; i++) flux[i] = wflux[fsize - 1 - i];
+  return;
+}
+
+void gratconv
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  size_t i (0);
+  Real SigmaMA = parameter[i++];
+  Real GammaMA = parameter[i++];
+  Real GaussianFraction = parameter[i++];
+  GratingKernel kernel
+    (SigmaMA / 1.e3, GammaMA / 1.e3, GammaMA / 1.e3, GaussianFraction, 1.);
+  gratingConvolution (energy, flux, kernel, parameter, spectrum, "gratconv");
+  return;
+}
+
+void gratcnv2
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  size_t i (0);
+  Real SigmaMA = parameter[i++];
+  Real Gamma1MA = parameter[i++];
+  Real Gamma2MA = parameter[i++];
+  Real GaussianFraction = parameter[i++];
+  Real Ratio = parameter[i++];
+  GratingKernel kernel (SigmaMA / 1.e3, Gamma1MA / 1.e3, Gamma2MA / 1.e3,
+			GaussianFraction, Ratio);
+  gratingConvolution (energy, flux, kernel, parameter, spectrum, "gratcnv2");
+  return;
+}
+
+/* The line fractions are normalized as in sxslsf2: the Gaussian core
+   gets 1 - ftail - felc, the exponential tail ftail, and the flat
+   electron loss continuum felc spread evenly from 0 to the source
+   energy. The continuum is convolved separately, since its weight per
+   keV depends on the source energy. */
+void sxsconv
+(const RealArray& energy, const RealArray& parameter,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  if (!checkEnergy (energy, "sxsconv")) return;
+  size_t i (0);
+  Real SigmaKEV = parameter[i++] / 1.e3;
+  Real ETailKEV = parameter[i++] / 1.e3;
+  Real TailFraction = parameter[i++];
+  Real ContinuumFraction = parameter[i++];
+  Real CoreFraction = 1. - TailFraction - ContinuumFraction;
+  if (compare (CoreFraction, 0.) == -1) {
+    cout << "sxsconv: ftail + felc > 1\n";
+    CoreFraction = 0.;
+  }
+  size_t fsize = flux.size ();
+  RealArray cflux (fsize);
+  for (size_t j = 0; j < fsize; j++) {
+    Real center = 0.5 * (energy[j] + energy[j+1]);
+    cflux[j] = flux[j] * ContinuumFraction / center;
+  }
+  CalorimeterKernel kernel (SigmaKEV, ETailKEV, CoreFraction, TailFraction);
+  getConvolution ("sxsconv", spectrum).convolve
+    (energy, kernel, parameter, flux);
+  if (compare (ContinuumFraction, 0.) == 1) {
+    CalorimeterContinuumKernel ContinuumKernel (SigmaKEV);
+    getConvolution ("sxsconv continuum", spectrum).convolve
+      (energy, ContinuumKernel, parameter, cflux);
+    flux += cflux;
+  }
+  return;
+}
@@ -0,0 +1,184 @@
+/***************************************************************************
+    Diagnostics.cpp - Severity levels, rate limiting and counters for the
+                      messages printed from inside the model evaluation.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "Diagnostics.h"
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// Messages written per site and model call (or session, outside calls)
+const size_t Diagnostics::MAXIMUM_PER_SITE = 3;
+
+Diagnostics::Site::Site (const char* name, DiagnosticLevel level)
+  : itsName (name), itsLevel (level), itsNCall (0), itsNTotal (0),
+    itsNext (NULL)
+{
+  Diagnostics::instance ().addSite (this);
+  return;
+}
+
+// Only the messages dropped outside a model call are left to count.
+Diagnostics::Site::~Site ()
+{
+  if (itsNCall > MAXIMUM_PER_SITE) {
+    cerr << "Diagnostics: " << itsNCall - MAXIMUM_PER_SITE
+	 << " more messages from " << itsName << " were not written.\n";
+  }
+  return;
+}
+
+/***************************/
+
+Diagnostics& Diagnostics::instance ()
+{
+  static Diagnostics diagnostics; // calls constructor
+  return diagnostics;
+}
+
+Diagnostics::Diagnostics ()
+  : itsLevel (diagnosticInfo), itsLock (), itsSites (NULL), itsDepth (0),
+    itsMessages (0)
+{
+  const char* level = getenv ("WINDPROFDIAGNOSTICS");
+  if (level) setLevel (level);
+  return;
+}
+
+void Diagnostics::setLevel (const string& level)
+{
+  if (level.empty ()) return;
+  string l (level);
+  for (size_t i = 0; i < l.size (); i++) l[i] = tolower (l[i]);
+  if (l == "debug") {
+    itsLevel = diagnosticDebug;
+  } else if (l == "info") {
+    itsLevel = diagnosticInfo;
+  } else if (l == "warning") {
+    itsLevel = diagnosticWarning;
+  } else if (l == "error") {
+    itsLevel = diagnosticError;
+  } else if (l == "off") {
+    itsLevel = diagnosticOff;
+  } else {
+    cerr << "Diagnostics: unknown level " << level << "; using info.\n";
+    itsLevel = diagnosticInfo;
+  }
+  return;
+}
+
+void Diagnostics::addSite (Site* site)
+{
+  lock_guard<mutex> guard (itsLock);
+  site->itsNext = itsSites;
+  itsSites = site;
+  return;
+}
+
+bool Diagnostics::accept (Site& site)
+{
+  site.itsNTotal++;
+  if (site.itsLevel < itsLevel) return false;
+  return (++site.itsNCall <= MAXIMUM_PER_SITE);
+}
+
+void Diagnostics::write (const Site& site, const string& message)
+{
+  lock_guard<mutex> guard (itsLock);
+  if (itsDepth == 0) {
+    print (site.itsLevel, message);
+    return;
+  }
+  Message m;
+  m.itsLevel = site.itsLevel;
+  m.itsText = message;
+  itsMessages.push_back (m);
+  return;
+}
+
+size_t Diagnostics::getCount (const string& name)
+{
+  lock_guard<mutex> guard (itsLock);
+  size_t count = 0;
+  for (Site* s = itsSites; s; s = s->itsNext) {
+    if (name == s->itsName) count += s->itsNTotal;
+  }
+  return count;
+}
+
+void Diagnostics::beginCall ()
+{
+  lock_guard<mutex> guard (itsLock);
+  if (itsDepth++ > 0) return;
+  for (Site* s = itsSites; s; s = s->itsNext) s->itsNCall = 0;
+  return;
+}
+
+// The messages kept during the call are written in the order they came,
+// each to its stream with a single write.
+void Diagnostics::endCall (const string& model)
+{
+  lock_guard<mutex> guard (itsLock);
+  if (--itsDepth > 0) return;
+  for (size_t i = 0; i < itsMessages.size (); i++) {
+    print (itsMessages[i].itsLevel, itsMessages[i].itsText);
+  }
+  itsMessages.clear ();
+  for (Site* s = itsSites; s; s = s->itsNext) {
+    if (s->itsNCall > MAXIMUM_PER_SITE) {
+      ostringstream text;
+      text << model << ": " << s->itsNCall - MAXIMUM_PER_SITE
+	   << " more messages from " << s->itsName
+	   << " were not written.";
+      print (s->itsLevel, text.str ());
+    }
+    s->itsNCall = 0;
+  }
+  return;
+}
+
+// Warnings and errors go to cerr, the rest to cout.
+void Diagnostics::print (DiagnosticLevel level, const string& text)
+{
+  ostream& out = (level >= diagnosticWarning) ? cerr : cout;
+  out << text << "\n";
+  out.flush ();
+  return;
+}
+
+/***************************/
+
+Diagnostics::ModelCall::ModelCall (const string& model, const string& level)
+  : itsModel (model)
+{
+  Diagnostics& D = Diagnostics::instance ();
+  D.setLevel (level);
+  D.beginCall ();
+  return;
+}
+
+Diagnostics::ModelCall::~ModelCall ()
+{
+  Diagnostics::instance ().endCall (itsModel);
+  return;
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+    Diagnostics.h   - Severity levels, rate limiting and counters for the
+                      messages printed from inside the model evaluation.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+/*
+  Messages from the hot paths (failed integrations, failed optical depth
+  rays, bad coordinates, per-call results) go through DIAGNOSE instead
+  of cout or cerr. Each place in the code that reports is a site, with
+  a fixed severity:
+  debug     - for development only (e.g. the sxslsf component totals)
+  info      - results worth seeing (e.g. the radwind transmitted fraction)
+  warning   - something failed, and the result may be inaccurate
+  error     - the result is wrong (e.g. invalid coordinates)
+
+  Messages below the level set by the xset key WINDPROFDIAGNOSTICS
+  (debug, info, warning, error or off; default info), or by the
+  environment variable of the same name (e.g. for ISIS or
+  PyWindProfile), are only counted, without formatting their text.
+
+  During a model call (see DIAGNOSTICS_MODEL_CALL), at most
+  MAXIMUM_PER_SITE messages of each site are kept, and they are written
+  together at the end of the call, followed by a count of the ones that
+  were dropped; so a fit that fails the same integral in every bin
+  writes a few lines per call rather than thousands. Outside a model
+  call, messages are written at once, and the limit applies to the
+  whole session; the count of dropped messages is written at exit.
+*/
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum DiagnosticLevel {diagnosticDebug, diagnosticInfo, diagnosticWarning,
+		      diagnosticError, diagnosticOff};
+
+// Singleton
+class Diagnostics
+{
+ public:
+  // One for each place that reports (declared by DIAGNOSE).
+  class Site {
+   public:
+    Site (const char* name, DiagnosticLevel level);
+    ~Site ();
+    const char* getName () const {return itsName;}
+    DiagnosticLevel getLevel () const {return itsLevel;}
+   private:
+    friend class Diagnostics;
+    const char* itsName;
+    DiagnosticLevel itsLevel;
+    atomic<size_t> itsNCall; // since the start of the model call
+    atomic<size_t> itsNTotal; // since the start of the session
+    Site* itsNext;
+  };
+  static const size_t MAXIMUM_PER_SITE;
+  static Diagnostics& instance ();
+  // Accepts debug, info, warning, error or off (case insensitive); an
+  // empty string leaves the level as it is.
+  void setLevel (const string& level);
+  // Counts one message, and says whether it is to be written.
+  bool accept (Site& site);
+  void write (const Site& site, const string& message);
+  // Number of messages from the site with this name since the start
+  // of the session, including those that were not written.
+  size_t getCount (const string& name);
+  // Sets the level at the start of a model call, and writes the
+  // messages kept during the call at its end.
+  class ModelCall {
+   public:
+    ModelCall (const string& model, const string& level);
+    ~ModelCall ();
+   private:
+    string itsModel;
+  };
+ private:
+  struct Message {
+    DiagnosticLevel itsLevel;
+    string itsText;
+  };
+  Diagnostics ();
+  atomic<int> itsLevel;
+  mutex itsLock;
+  Site* itsSites;
+  size_t itsDepth; // nested model calls
+  vector<Message> itsMessages; // kept during a model call
+  void addSite (Site* site);
+  void beginCall ();
+  void endCall (const string& model);
+  static void print (DiagnosticLevel level, const string& text);
+  // To prevent copying and assignment:
+  Diagnostics (const Diagnostics& D);
+  Diagnostics operator = (const Diagnostics& D);
+};
+
+#define DIAGNOSE(level, site, message) \
+  do { \
+    static Diagnostics::Site diagnosticSite (site, level); \
+    if (Diagnostics::instance ().accept (diagnosticSite)) { \
+      ostringstream diagnosticText; \
+      diagnosticText << message; \
+      Diagnostics::instance ().write (diagnosticSite, diagnosticText.str ()); \
+    } \
+  } while (0)
+#define DIAGNOSTICS_MODEL_CALL(model, level) \
+  Diagnostics::ModelCall diagnosticsModelCall (model, level)
+
+#endif//DIAGNOSTICS_H
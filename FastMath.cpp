@@ -0,0 +1,37 @@
+/***************************************************************************
+    FastMath.cpp   - Approximate exp, log, pow and exprel for the innermost
+                     integrands, and the switch that selects them.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "FastMath.h"
+
+static bool isFastMath = false;
+
+void setFastMath (bool fast)
+{
+  isFastMath = fast;
+  return;
+}
+
+bool getFastMath ()
+{
+  return isFastMath;
+}
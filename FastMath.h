@@ -0,0 +1,113 @@
+/***************************************************************************
+    FastMath.h   - Approximate exp, log, pow and exprel for the innermost
+                   integrands, and the switch that selects them.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include "xsTypes.h"
+
+/*
+  The classes that use these read getFastMath () when they are
+  constructed, so it must be set before a model is set up (windprof.cpp
+  does this from the xset key WINDPROFFASTMATH). The default is off, 
+  which uses libm and GSL exactly as before.
+
+  The approximations are straight-line polynomial code with no table 
+  lookups and no data-dependent branches in the normal range, so that
+  loops over arrays of arguments can be vectorized by the compiler.
+  fastExp and fastExprel have a relative error below about 5.e-10, and
+  fastLog an absolute error below about 5.e-11, so that fastPow has a
+  relative error below about 5.e-10 * (1 + |y log x|). This is far below
+  the integration tolerances.
+*/
+
+void setFastMath (bool fast);
+bool getFastMath ();
+
+// exp (x) by x = k ln 2 + r, |r| <= ln 2 / 2, and a degree 8 Taylor 
+// polynomial for exp (r). Underflows to 0 below x = -708.
+inline Real fastExp (Real x)
+{
+  if (x < -708.) return 0.;
+  if (x > 709.) x = 709.;
+  const Real Log2e = 1.4426950408889634;
+  const Real Ln2Hi = 6.93147180369123816490e-01;
+  const Real Ln2Lo = 1.90821492927058770002e-10;
+  const Real Round = 6755399441055744.; // 1.5 * 2^52
+  Real k = (x * Log2e + Round) - Round; // nearest integer
+  Real r = (x - k * Ln2Hi) - k * Ln2Lo;
+  Real r2 = r * r;
+  Real p = (1. + r) + r2 * ((1./2. + r * 1./6.) + r2 * ((1./24. + r * 1./120.)
+	   + r2 * ((1./720. + r * 1./5040.) + r2 * (1./40320.))));
+  int64_t bits = ((int64_t) k + 1023) << 52;
+  Real scale;
+  memcpy (&scale, &bits, sizeof (scale));
+  return p * scale;
+}
+
+// log (x) for normal x > 0 by x = 2^e m, sqrt(1/2) <= m < sqrt(2), and
+// the series log (m) = 2 atanh (s), s = (m - 1) / (m + 1), |s| < 0.172.
+inline Real fastLog (Real x)
+{
+  int64_t bits;
+  memcpy (&bits, &x, sizeof (bits));
+  int64_t e = ((bits >> 52) & 0x7ff) - 1023;
+  bits = (bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL;
+  Real m;
+  memcpy (&m, &bits, sizeof (m));
+  if (m > 1.4142135623730951) {
+    m *= 0.5;
+    e++;
+  }
+  const Real Ln2 = 6.93147180559945309417e-01;
+  Real s = (m - 1.) / (m + 1.);
+  Real s2 = s * s;
+  Real series = 1. + s2 * (1./3. + s2 * (1./5. + s2 * (1./7. + s2 * (1./9.
+		+ s2 * (1./11.)))));
+  return e * Ln2 + 2. * s * series;
+}
+
+// x^y for x >= 0.
+inline Real fastPow (Real x, Real y)
+{
+  if (x <= 0.) return (y == 0.) ? 1. : 0.;
+  return fastExp (y * fastLog (x));
+}
+
+// (exp (x) - 1) / x, as gsl_sf_exprel; Taylor series near 0.
+inline Real fastExprel (Real x)
+{
+  if (x < -708.) return -1. / x;
+  if (fabs (x) < 0.5) {
+    return 1. + x * (1./2. + x * (1./6. + x * (1./24. + x * (1./120. 
+	   + x * (1./720. + x * (1./5040. + x * (1./40320. + x * (1./362880.
+	   + x * (1./3628800. + x * (1./39916800. + x * (1./479001600.
+	   + x * (1./6227020800.))))))))))));
+  }
+  return (fastExp (x) - 1.) / x;
+}
+
+#endif//FAST_MATH_H
@@ -27,7 +27,7 @@ using namespace std;
 
 #include "xsTypes.h"
 #include "Lorentzian.h"
-#include "Gaussian.h"
+#include "MultiGaussian.h"
 #include "Utilities.h"
 #include "isisCPPFunctionWrapper.h"
 
@@ -133,24 +133,22 @@ void gratpr2
 
 /***************************/
 
+/* The components are accumulated directly into flux (zeroed by the
+   caller), with no intermediate arrays. */
 void gratingProfile
 (const RealArray& energy, RealArray& flux, Real LineEnergy, Real Sigma, 
  Real Gamma, Real GaussianFraction)
 {
-  RealArray Lflux (flux.size (), 0.);
-  RealArray Gflux (flux.size (), 0.);
-  Lorentzian L (energy, LineEnergy, Gamma);
-  Gaussian G (energy, LineEnergy, Sigma);
+  MultiGaussian G (energy);
+  G.addLine (LineEnergy, Sigma, GaussianFraction);
   if (G.checkOutOfBounds ()) {
     cout << "gratingProfile: Line energy (" << LineEnergy << 
       " keV) is close to or out of bounds\n";
     return;
   }
-  L.getFlux (Lflux);
-  G.getFlux (Gflux);
-  Lflux *= (1. - GaussianFraction);
-  Gflux *= GaussianFraction;
-  flux = (Lflux + Gflux);
+  Lorentzian L (energy, LineEnergy, Gamma);
+  G.addFlux (flux);
+  L.addFlux (flux, 1. - GaussianFraction);
   return;
 }
 
@@ -160,26 +158,18 @@ void gratingProfile2 (const RealArray& energy, RealArray& flux,
 		      Real Gamma1, Real Gamma2, 
 		      Real GaussianFraction, Real Ratio)
 {
-
-  RealArray L1flux (flux.size (), 0.);
-  RealArray L2flux (flux.size (), 0.);
-  RealArray Gflux (flux.size (), 0.);
-
-  Lorentzian L1 (energy, LineEnergy, Gamma1);
-  Lorentzian L2 (energy, LineEnergy, Gamma2);
-  Gaussian G (energy, LineEnergy, Sigma);
+  MultiGaussian G (energy);
+  G.addLine (LineEnergy, Sigma, GaussianFraction);
   if (G.checkOutOfBounds ()) {
     cout << "gratingProfile2: Line energy (" << LineEnergy << 
       " keV) is outside of the response range. \n";
     return;
   }
-  L1.getFlux (L1flux);
-  L2.getFlux (L2flux);
-  G.getFlux (Gflux);
-  Gflux *= GaussianFraction;
-  L1flux *= Ratio * (1. - GaussianFraction) / (1. + Ratio);
-  L2flux *= (1. - GaussianFraction) / (1. + Ratio);
-  flux = (L1flux + L2flux + Gflux);
+  Lorentzian L1 (energy, LineEnergy, Gamma1);
+  Lorentzian L2 (energy, LineEnergy, Gamma2);
+  G.addFlux (flux);
+  L1.addFlux (flux, Ratio * (1. - GaussianFraction) / (1. + Ratio));
+  L2.addFlux (flux, (1. - GaussianFraction) / (1. + Ratio));
   return;
 }
 
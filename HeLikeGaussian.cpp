@@ -22,7 +22,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "HeLikeGaussian.h"
-#include "Gaussian.h"
+#include "MultiGaussian.h"
 #include "Utilities.h"
 #include "AtomicParameters.h"
 #include <iostream>
@@ -68,27 +68,23 @@ void HeLikeGaussian::extractParameters (const RealArray& parameter)
 void HeLikeGaussian::getFlux (RealArray& flux)
 {
   size_t Nflux = itsEnergyArray.size () - 1;
-  flux.resize (Nflux);
-  MatrixValue heflux (Nlines); 
-  /* MatrixValue is from xsTypes.h - should work like an array of RealArrays */
-  Gaussian G (itsEnergyArray, itsEnergy[0], itsSigma);
-  for (size_t i = 0; i < Nlines; i++) {
-    heflux[i].resize (Nflux);
-    G.setParameters (itsEnergy[i], itsSigma);
-    if (G.checkOutOfBounds ()) {
-      cout << "HeLikeGaussian:getFlux () - one or more lines have "
-	   << "energies outside the response range; "
-	   << "setting model flux to zero.\n";
-      return;
-    }
-    G.getFlux (heflux[i]);
-  }
   RealArray Normalization (Nlines);
   Normalization[0] = 1. / (1. + itsG);
   Real iNormalization = itsG * Normalization[0] / (1. + itsR);
   Normalization[3] = itsR * iNormalization;
   Normalization[1] = itsXFraction * iNormalization;
   Normalization[2] = (1. - itsXFraction) * iNormalization;
-  for (size_t i = 0; i < Nlines; i++) flux += heflux[i] * Normalization [i];
+  MultiGaussian G (itsEnergyArray);
+  for (size_t i = 0; i < Nlines; i++) {
+    G.addLine (itsEnergy[i], itsSigma, Normalization[i]);
+  }
+  if (G.checkOutOfBounds ()) {
+    cout << "HeLikeGaussian:getFlux () - one or more lines have "
+	 << "energies outside the response range; "
+	 << "setting model flux to zero.\n";
+    flux.resize (Nflux);
+    return;
+  }
+  G.getFlux (flux);
   return;
 }
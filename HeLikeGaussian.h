@@ -36,7 +36,7 @@ class HeLikeGaussian
   void getFlux (RealArray& flux);
  private:
   const static size_t Nlines = 4;
-  const RealArray itsEnergyArray;
+  const RealArray& itsEnergyArray;
   Real itsR;
   Real itsG;
   Real itsSigma;
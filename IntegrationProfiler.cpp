@@ -0,0 +1,353 @@
+/***************************************************************************
+    IntegrationProfiler.cpp - Opt-in profile of the nested integrals:
+                              calls, integrand evaluations, wall time,
+                              failures and subintervals per Integral class.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "IntegrationProfiler.h"
+
+#ifdef WINDPROF_PROFILE
+
+#include "mal_integration.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+using namespace std;
+
+struct IntegrationProfiler::Node
+{
+  Node (const string& name, Node* parent);
+  ~Node ();
+  Node* getChild (const type_info& type);
+  void add (const Node& other);
+  void clear ();
+  void sum (size_t& NIntegrations, size_t& NCalls, size_t& NFailures) const;
+  void print (ostream& out, size_t depth) const;
+  string itsName;
+  Node* itsParent;
+  map<type_index, Node*> itsChildren;
+  size_t itsNIntegrations;
+  size_t itsNCalls; // integrand evaluations
+  size_t itsNFailures; // nonzero status
+  size_t itsNIntervals; // subintervals of the adaptive routines
+  double itsSeconds;
+ private:
+  Node (const Node& N);
+  Node operator = (const Node& N);
+};
+
+/* The tree of one thread. It is handed on to itsRetired when the
+   thread exits (e.g. at the end of a WindProfileBatch). */
+struct IntegrationProfiler::ThreadTree
+{
+  ThreadTree ();
+  ~ThreadTree ();
+  Node itsRoot;
+  Node* itsCurrent;
+};
+
+static string demangle (const char* name)
+{
+#ifdef __GNUG__
+  int status = 0;
+  char* readable = abi::__cxa_demangle (name, NULL, NULL, &status);
+  if (status == 0 && readable) {
+    string answer (readable);
+    free (readable);
+    return answer;
+  }
+#endif
+  return string (name);
+}
+
+IntegrationProfiler::Node::Node (const string& name, Node* parent)
+  : itsName (name), itsParent (parent), itsChildren (),
+    itsNIntegrations (0), itsNCalls (0), itsNFailures (0),
+    itsNIntervals (0), itsSeconds (0.)
+{
+  return;
+}
+
+IntegrationProfiler::Node::~Node ()
+{
+  map<type_index, Node*>::iterator it;
+  for (it = itsChildren.begin (); it != itsChildren.end (); it++) {
+    delete it->second;
+  }
+  return;
+}
+
+IntegrationProfiler::Node* IntegrationProfiler::Node::getChild
+(const type_info& type)
+{
+  type_index key (type);
+  map<type_index, Node*>::iterator found = itsChildren.find (key);
+  if (found != itsChildren.end ()) return found->second;
+  Node* child = new Node (demangle (type.name ()), this);
+  itsChildren[key] = child;
+  return child;
+}
+
+void IntegrationProfiler::Node::add (const Node& other)
+{
+  itsNIntegrations += other.itsNIntegrations;
+  itsNCalls += other.itsNCalls;
+  itsNFailures += other.itsNFailures;
+  itsNIntervals += other.itsNIntervals;
+  itsSeconds += other.itsSeconds;
+  map<type_index, Node*>::const_iterator it;
+  for (it = other.itsChildren.begin (); it != other.itsChildren.end (); it++) {
+    Node*& child = itsChildren[it->first];
+    if (!child) child = new Node (it->second->itsName, this);
+    child->add (*it->second);
+  }
+  return;
+}
+
+// The structure is kept, since itsCurrent may point into it.
+void IntegrationProfiler::Node::clear ()
+{
+  itsNIntegrations = 0;
+  itsNCalls = 0;
+  itsNFailures = 0;
+  itsNIntervals = 0;
+  itsSeconds = 0.;
+  map<type_index, Node*>::iterator it;
+  for (it = itsChildren.begin (); it != itsChildren.end (); it++) {
+    it->second->clear ();
+  }
+  return;
+}
+
+void IntegrationProfiler::Node::sum
+(size_t& NIntegrations, size_t& NCalls, size_t& NFailures) const
+{
+  NIntegrations += itsNIntegrations;
+  NCalls += itsNCalls;
+  NFailures += itsNFailures;
+  map<type_index, Node*>::const_iterator it;
+  for (it = itsChildren.begin (); it != itsChildren.end (); it++) {
+    it->second->sum (NIntegrations, NCalls, NFailures);
+  }
+  return;
+}
+
+void IntegrationProfiler::Node::print (ostream& out, size_t depth) const
+{
+  if (depth > 0 && itsNIntegrations > 0) {
+    double children = 0.;
+    map<type_index, Node*>::const_iterator it;
+    for (it = itsChildren.begin (); it != itsChildren.end (); it++) {
+      children += it->second->itsSeconds;
+    }
+    string name = string (2 * (depth - 1), ' ') + itsName;
+    out << left << setw (32) << name << right
+	<< setw (12) << itsNIntegrations << setw (14) << itsNCalls
+	<< setw (10) << itsNFailures << setw (12) << itsNIntervals
+	<< setw (12) << setprecision (4) << itsSeconds
+	<< setw (12) << setprecision (4) << max (itsSeconds - children, 0.)
+	<< "\n";
+  }
+  // most expensive first
+  vector<pair<double, const Node*> > order;
+  map<type_index, Node*>::const_iterator it;
+  for (it = itsChildren.begin (); it != itsChildren.end (); it++) {
+    order.push_back (make_pair (-1. * it->second->itsSeconds, it->second));
+  }
+  sort (order.begin (), order.end ());
+  for (size_t i = 0; i < order.size (); i++) {
+    order[i].second->print (out, depth + 1);
+  }
+  return;
+}
+
+/***************************/
+
+IntegrationProfiler::ThreadTree::ThreadTree ()
+  : itsRoot ("", NULL), itsCurrent (&itsRoot)
+{
+  IntegrationProfiler::instance ().addTree (this);
+  return;
+}
+
+IntegrationProfiler::ThreadTree::~ThreadTree ()
+{
+  IntegrationProfiler::instance ().removeTree (this);
+  return;
+}
+
+/***************************/
+
+IntegrationProfiler& IntegrationProfiler::instance ()
+{
+  static IntegrationProfiler integrationProfiler; // calls constructor
+  return integrationProfiler;
+}
+
+IntegrationProfiler::IntegrationProfiler ()
+  : itsMode (profileOff), itsLock (), itsTrees (0),
+    itsRetired (new Node ("", NULL))
+{
+  const char* mode = getenv ("WINDPROFPROFILE");
+  if (mode) setMode (mode);
+  return;
+}
+
+IntegrationProfiler::~IntegrationProfiler ()
+{
+  if (itsMode == profileSession) report (cout, "session");
+  delete itsRetired;
+  return;
+}
+
+void IntegrationProfiler::setMode (const string& mode)
+{
+  if (mode.empty ()) return;
+  string m (mode);
+  for (size_t i = 0; i < m.size (); i++) m[i] = tolower (m[i]);
+  if (m == "0" || m == "off") {
+    itsMode = profileOff;
+  } else if (m == "call") {
+    itsMode = profileCall;
+  } else if (m == "session") {
+    itsMode = profileSession;
+  } else if (m == "quiet") {
+    itsMode = profileQuiet;
+  } else {
+    cerr << "IntegrationProfiler: unknown mode " << mode
+	 << "; profiling is off.\n";
+    itsMode = profileOff;
+  }
+  return;
+}
+
+void IntegrationProfiler::addTree (ThreadTree* tree)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsTrees.push_back (tree);
+  return;
+}
+
+void IntegrationProfiler::removeTree (ThreadTree* tree)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsRetired->add (tree->itsRoot);
+  itsTrees.erase (remove (itsTrees.begin (), itsTrees.end (), tree),
+		  itsTrees.end ());
+  return;
+}
+
+void IntegrationProfiler::collect (Node& total)
+{
+  lock_guard<mutex> guard (itsLock);
+  total.add (*itsRetired);
+  itsRetired->clear ();
+  for (size_t i = 0; i < itsTrees.size (); i++) {
+    total.add (itsTrees[i]->itsRoot);
+    itsTrees[i]->itsRoot.clear ();
+  }
+  return;
+}
+
+void IntegrationProfiler::report (ostream& out, const string& title)
+{
+  Node total ("", NULL);
+  collect (total);
+  if (total.itsChildren.empty ()) return;
+  out << "Integration profile (" << title << ")\n"
+      << left << setw (32) << "integral" << right
+      << setw (12) << "integrals" << setw (14) << "integrand"
+      << setw (10) << "failures" << setw (12) << "intervals"
+      << setw (12) << "time (s)" << setw (12) << "self (s)" << "\n";
+  total.print (out, 0);
+  out.flush ();
+  return;
+}
+
+void IntegrationProfiler::getTotals
+(size_t& NIntegrations, size_t& NCalls, size_t& NFailures)
+{
+  Node total ("", NULL);
+  collect (total);
+  NIntegrations = 0;
+  NCalls = 0;
+  NFailures = 0;
+  total.sum (NIntegrations, NCalls, NFailures);
+  return;
+}
+
+/***************************/
+
+IntegrationProfiler::ThreadTree& IntegrationProfiler::getThreadTree ()
+{
+  thread_local IntegrationProfiler::ThreadTree tree;
+  return tree;
+}
+
+IntegrationProfiler::Scope::Scope (const Integral* integral, bool adaptive)
+  : itsIntegral (integral), isAdaptive (adaptive), itsTree (NULL),
+    itsNode (NULL), itsStartCalls (0)
+{
+  if (!IntegrationProfiler::instance ().getEnabled ()) return;
+  itsTree = &getThreadTree ();
+  itsNode = itsTree->itsCurrent->getChild (typeid (*integral));
+  itsTree->itsCurrent = itsNode;
+  itsStartCalls = integral->getNCalls ();
+  itsStart = chrono::steady_clock::now ();
+  return;
+}
+
+IntegrationProfiler::Scope::~Scope ()
+{
+  if (!itsNode) return;
+  chrono::duration<double> elapsed = chrono::steady_clock::now () - itsStart;
+  itsNode->itsSeconds += elapsed.count ();
+  itsNode->itsNIntegrations++;
+  itsNode->itsNCalls += itsIntegral->getNCalls () - itsStartCalls;
+  if (itsIntegral->getStatus ()) itsNode->itsNFailures++;
+  if (isAdaptive) itsNode->itsNIntervals += itsIntegral->getNIntervals ();
+  itsTree->itsCurrent = itsNode->itsParent;
+  return;
+}
+
+/***************************/
+
+IntegrationProfiler::ModelCall::ModelCall
+(const string& model, const string& mode)
+  : itsModel (model)
+{
+  IntegrationProfiler::instance ().setMode (mode);
+  return;
+}
+
+IntegrationProfiler::ModelCall::~ModelCall ()
+{
+  IntegrationProfiler& P = IntegrationProfiler::instance ();
+  if (P.itsMode == profileCall) P.report (cout, itsModel);
+  return;
+}
+
+#endif//WINDPROF_PROFILE
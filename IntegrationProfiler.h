@@ -0,0 +1,133 @@
+/***************************************************************************
+    IntegrationProfiler.h   - Opt-in profile of the nested integrals:
+                              calls, integrand evaluations, wall time,
+                              failures and subintervals per Integral class.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef INTEGRATION_PROFILER_H
+#define INTEGRATION_PROFILER_H
+
+/*
+  The profiler is only compiled in with -DWINDPROF_PROFILE. Otherwise
+  the macros below expand to nothing, so there is no cost at all.
+
+  When it is compiled in, it is switched on by the xset key
+  WINDPROFPROFILE, or by the environment variable of the same name
+  (e.g. for ISIS or PyWindProfile, which have no xset):
+  0 or off  - nothing is recorded (default)
+  call      - a report is printed after each model call
+  session   - a report is printed at exit
+  quiet     - recorded but never printed; the totals are read with
+              getTotals (e.g. by the benchmark in Benchmark/)
+
+  Each integration (one call to qag, qagp, qts, ...) is recorded under
+  the class of the Integral doing it, and nested under the integral
+  whose integrand it was called from, e.g. FluxIntegral > Lx >
+  NumericalOpticalDepthZ. Each thread keeps its own tree, so the
+  WindProfileBatch threads do not contend; the trees are summed for
+  the report, which should only be made while no model is being
+  evaluated. Time is wall time, including the nested integrals; the
+  self time excludes them.
+*/
+
+#ifdef WINDPROF_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+class Integral;
+
+// Singleton
+class IntegrationProfiler
+{
+  struct Node;
+  struct ThreadTree;
+ public:
+  static IntegrationProfiler& instance ();
+  ~IntegrationProfiler ();
+  // Accepts 0, off, call, session or quiet (case insensitive); an
+  // empty string leaves the mode as it is.
+  void setMode (const string& mode);
+  bool getEnabled () const {return itsMode != profileOff;}
+  // Prints the sum of the trees of all threads, and zeroes them.
+  void report (ostream& out, const string& title);
+  // The totals over all integral classes and threads since the last
+  // report or getTotals, which are then zeroed.
+  void getTotals (size_t& NIntegrations, size_t& NCalls, size_t& NFailures);
+  // Records one integration for as long as it is in scope.
+  class Scope {
+   public:
+    Scope (const Integral* integral, bool isAdaptive);
+    ~Scope ();
+   private:
+    const Integral* itsIntegral;
+    bool isAdaptive;
+    ThreadTree* itsTree;
+    Node* itsNode;
+    size_t itsStartCalls;
+    chrono::steady_clock::time_point itsStart;
+  };
+  // Sets the mode at the start of a model call, and reports at its
+  // end in call mode.
+  class ModelCall {
+   public:
+    ModelCall (const string& model, const string& mode);
+    ~ModelCall ();
+   private:
+    string itsModel;
+  };
+ private:
+  enum ProfileMode {profileOff, profileCall, profileSession, profileQuiet};
+  IntegrationProfiler ();
+  atomic<int> itsMode;
+  mutex itsLock;
+  vector<ThreadTree*> itsTrees;
+  Node* itsRetired; // trees of threads that have exited
+  static ThreadTree& getThreadTree ();
+  void addTree (ThreadTree* tree);
+  void removeTree (ThreadTree* tree);
+  void collect (Node& total);
+  // To prevent copying and assignment:
+  IntegrationProfiler (const IntegrationProfiler& P);
+  IntegrationProfiler operator = (const IntegrationProfiler& P);
+};
+
+#define PROFILE_INTEGRATION(isAdaptive) \
+  IntegrationProfiler::Scope profileScope (this, isAdaptive)
+#define PROFILE_MODEL_CALL(model, mode) \
+  IntegrationProfiler::ModelCall profileModelCall (model, mode)
+
+#else
+
+#define PROFILE_INTEGRATION(isAdaptive)
+#define PROFILE_MODEL_CALL(model, mode)
+
+#endif//WINDPROF_PROFILE
+
+#endif//INTEGRATION_PROFILER_H
@@ -0,0 +1,298 @@
+/***************************************************************************
+    LSFConvolution.cpp   - Convolves a binned model spectrum with a line
+                           spread function (grating or calorimeter).
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "LSFConvolution.h"
+#include "Utilities.h"
+#include <iostream>
+#include <math.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+
+using namespace std;
+
+const Real LSFKernel::TRUNCATION = 1.e-4;
+const Real LSFKernel::N_SIGMA = 8.;
+
+// Relative variation of the bin width allowed for the FFT.
+const Real LSFConvolution::UNIFORM_TOLERANCE = 1.e-6;
+
+/***************************/
+
+GratingKernel::GratingKernel (Real Sigma, Real Gamma1, Real Gamma2,
+			      Real GaussianFraction, Real Ratio)
+  : itsSigma (Sigma), itsGamma1 (Gamma1), itsGamma2 (Gamma2),
+    itsGaussianFraction (GaussianFraction), itsRatio (Ratio)
+{
+  return;
+}
+
+// Step for zero width. The offset of -1/2 keeps the values small.
+static Real getGaussianCDF (Real x, Real Sigma)
+{
+  if (compare (Sigma, 0.) != 1) return (0.5 * GSL_SIGN (x));
+  return (0.5 * erf (x / (Sigma * M_SQRT2)));
+}
+
+static Real getLorentzianCDF (Real x, Real Gamma)
+{
+  if (compare (Gamma, 0.) != 1) return (0.5 * GSL_SIGN (x));
+  return (atan (x / Gamma) / M_PI);
+}
+
+Real GratingKernel::getCDF (Real x)
+{
+  Real LorentzianFraction = 1. - itsGaussianFraction;
+  return (itsGaussianFraction * getGaussianCDF (x, itsSigma)
+	  + LorentzianFraction * itsRatio / (1. + itsRatio)
+	  * getLorentzianCDF (x, itsGamma1)
+	  + LorentzianFraction / (1. + itsRatio)
+	  * getLorentzianCDF (x, itsGamma2));
+}
+
+/* The weight of a Lorentzian beyond +/- x is about 2 Gamma / (pi x). */
+Real GratingKernel::getHalfWidth ()
+{
+  Real HalfWidth = N_SIGMA * itsSigma;
+  if (compare (itsGaussianFraction, 1.) == -1) {
+    Real Gamma = GSL_MAX_DBL (itsGamma1, itsGamma2);
+    HalfWidth = GSL_MAX_DBL (HalfWidth, 2. * Gamma / (M_PI * TRUNCATION));
+  }
+  return HalfWidth;
+}
+
+/***************************/
+
+CalorimeterKernel::CalorimeterKernel (Real Sigma, Real ETail,
+				      Real CoreFraction, Real TailFraction)
+  : itsSigma (Sigma), itsETail (ETail), itsCoreFraction (CoreFraction),
+    itsTailFraction (TailFraction), itsLSF (Sigma, ETail, 1., 1.)
+{
+  return;
+}
+
+/* calorimeterLSF uses deltaE = E0 - E = -x, and returns the tail CDF
+   minus 1 for deltaE > 0. */
+Real CalorimeterKernel::getCDF (Real x)
+{
+  Real TailCDF = itsLSF.getTailCDF (-1. * x);
+  if (x < 0.) TailCDF += 1.;
+  return (itsCoreFraction * getGaussianCDF (x, itsSigma)
+	  - itsTailFraction * TailCDF);
+}
+
+Real CalorimeterKernel::getHalfWidth ()
+{
+  return (N_SIGMA * itsSigma - itsETail * log (TRUNCATION));
+}
+
+/***************************/
+
+CalorimeterContinuumKernel::CalorimeterContinuumKernel (Real Sigma)
+  : itsSigma (Sigma), itsLSF (Sigma, 0., 1., 1.)
+{
+  return;
+}
+
+Real CalorimeterContinuumKernel::getCDF (Real x)
+{
+  return (-1. * itsLSF.getFlatCDF (-1. * x));
+}
+
+Real CalorimeterContinuumKernel::getHalfWidth ()
+{
+  return (N_SIGMA * itsSigma);
+}
+
+/***************************/
+
+LSFConvolution::LSFConvolution ()
+  : itsCoordinate (0), itsKey (0), isUniform (false), itsFFTSize (0),
+    itsKernelTransform (0), itsLowerSlope (0.)
+{
+  return;
+}
+
+void LSFConvolution::convolve (const RealArray& coordinate,
+			       LSFKernel& kernel, const RealArray& key,
+			       RealArray& flux)
+{
+  if (coordinate.size () != flux.size () + 1) {
+    cerr << "LSFConvolution: grid size " << coordinate.size ()
+	 << " does not match flux size " << flux.size () << "\n";
+    return;
+  }
+  if (flux.size () < 2) return;
+  if (!isCached (coordinate, key)) {
+    itsCoordinate.resize (coordinate.size ());
+    itsCoordinate = coordinate;
+    itsKey.resize (key.size ());
+    itsKey = key;
+    checkUniform ();
+    if (isUniform) {
+      buildTransform (kernel);
+    } else {
+      buildBand (kernel);
+    }
+  }
+  if (isUniform) {
+    convolveFFT (flux);
+  } else {
+    convolveDirect (flux);
+  }
+  return;
+}
+
+bool LSFConvolution::isCached
+(const RealArray& coordinate, const RealArray& key)
+{
+  if ((coordinate.size () != itsCoordinate.size ()) ||
+      (key.size () != itsKey.size ())) return false;
+  for (size_t i = 0; i < key.size (); i++) {
+    if (key[i] != itsKey[i]) return false;
+  }
+  for (size_t i = 0; i < coordinate.size (); i++) {
+    if (coordinate[i] != itsCoordinate[i]) return false;
+  }
+  return true;
+}
+
+void LSFConvolution::checkUniform ()
+{
+  size_t N = itsCoordinate.size () - 1;
+  Real h = (itsCoordinate[N] - itsCoordinate[0]) / N;
+  isUniform = true;
+  for (size_t i = 0; i < N; i++) {
+    Real width = itsCoordinate[i+1] - itsCoordinate[i];
+    if (fabs (width - h) > UNIFORM_TOLERANCE * h) {
+      isUniform = false;
+      return;
+    }
+  }
+  return;
+}
+
+/* Kernel weights k_m for an offset of m bins, m = -(N-1) ... N-1,
+   wrapped into an array of length 2^n >= 2N, and transformed. */
+void LSFConvolution::buildTransform (LSFKernel& kernel)
+{
+  size_t N = itsCoordinate.size () - 1;
+  Real h = (itsCoordinate[N] - itsCoordinate[0]) / N;
+  itsFFTSize = 1;
+  while (itsFFTSize < 2 * N) itsFFTSize *= 2;
+  itsKernelTransform.resize (itsFFTSize, 0.);
+  itsKernelTransform = 0.;
+  Real previous = kernel.getCDF ((0.5 - N) * h);
+  for (size_t k = 0; k < 2 * N - 1; k++) {
+    int m = (int) k - (int) N + 1;
+    Real current = kernel.getCDF ((m + 0.5) * h);
+    size_t index = (m < 0) ? itsFFTSize - (size_t) (-1 * m) : (size_t) m;
+    itsKernelTransform[index] = current - previous;
+    previous = current;
+  }
+  gsl_fft_real_radix2_transform (&itsKernelTransform[0], 1, itsFFTSize);
+  return;
+}
+
+void LSFConvolution::convolveFFT (RealArray& flux)
+{
+  size_t N = flux.size ();
+  RealArray data (0., itsFFTSize);
+  for (size_t i = 0; i < N; i++) data[i] = flux[i];
+  gsl_fft_real_radix2_transform (&data[0], 1, itsFFTSize);
+  // multiply in half-complex storage: r0 r1 ... r(n/2) i(n/2-1) ... i1
+  size_t half = itsFFTSize / 2;
+  data[0] *= itsKernelTransform[0];
+  data[half] *= itsKernelTransform[half];
+  for (size_t k = 1; k < half; k++) {
+    Real ar = data[k];
+    Real ai = data[itsFFTSize - k];
+    Real br = itsKernelTransform[k];
+    Real bi = itsKernelTransform[itsFFTSize - k];
+    data[k] = ar * br - ai * bi;
+    data[itsFFTSize - k] = ar * bi + ai * br;
+  }
+  gsl_fft_halfcomplex_radix2_inverse (&data[0], 1, itsFFTSize);
+  for (size_t i = 0; i < N; i++) flux[i] = data[i];
+  return;
+}
+
+/* For source bin j at center c, the band is the output bins with
+   upper edge above c - HalfWidth and lower edge below c + HalfWidth. */
+void LSFConvolution::buildBand (LSFKernel& kernel)
+{
+  size_t N = itsCoordinate.size () - 1;
+  Real HalfWidth = kernel.getHalfWidth ();
+  itsLowerSlope = kernel.getLowerSlope ();
+  itsBandStart.resize (N);
+  itsBandWeight.resize (N);
+  size_t first = 0;
+  size_t last = 0;
+  for (size_t j = 0; j < N; j++) {
+    Real center = 0.5 * (itsCoordinate[j] + itsCoordinate[j+1]);
+    while ((first < j) && (itsCoordinate[first+1] <= center - HalfWidth)) {
+      first++;
+    }
+    if (last < j) last = j;
+    while ((last < N - 1) && (itsCoordinate[last+1] < center + HalfWidth)) {
+      last++;
+    }
+    itsBandStart[j] = first;
+    itsBandWeight[j].resize (last - first + 1);
+    Real previous = kernel.getCDF (itsCoordinate[first] - center);
+    for (size_t i = first; i <= last; i++) {
+      Real current = kernel.getCDF (itsCoordinate[i+1] - center);
+      itsBandWeight[j][i - first] = current - previous;
+      previous = current;
+    }
+  }
+  return;
+}
+
+/* Output bins below the band of a source get LowerSlope times their
+   width; that is summed with the total flux of the sources whose band
+   starts above them. */
+void LSFConvolution::convolveDirect (RealArray& flux)
+{
+  size_t N = flux.size ();
+  RealArray answer (0., N);
+  RealArray StartingFlux (0., N + 1);
+  for (size_t j = 0; j < N; j++) {
+    const RealArray& weight = itsBandWeight[j];
+    size_t first = itsBandStart[j];
+    for (size_t k = 0; k < weight.size (); k++) {
+      answer[first + k] += flux[j] * weight[k];
+    }
+    StartingFlux[first] += flux[j];
+  }
+  if (compare (itsLowerSlope, 0.) != 0) {
+    Real above = 0.;
+    for (size_t i = N; i > 0; i--) {
+      Real width = itsCoordinate[i] - itsCoordinate[i-1];
+      answer[i-1] += itsLowerSlope * width * above;
+      above += StartingFlux[i-1];
+    }
+  }
+  flux = answer;
+  return;
+}
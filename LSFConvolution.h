@@ -0,0 +1,139 @@
+/***************************************************************************
+    LSFConvolution.h   - Convolves a binned model spectrum with a line
+                         spread function (grating or calorimeter).
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef LSF_CONVOLUTION_H
+#define LSF_CONVOLUTION_H
+
+#include <vector>
+#include "xsTypes.h"
+#include "calorimeterLSF.h"
+
+using namespace std;
+
+/*
+  A kernel is given by its cumulative weight getCDF (x) as a function of
+  the offset x = (output coordinate - source coordinate); only
+  differences of getCDF are used, so it may have any constant offset.
+  Beyond +/- getHalfWidth () the kernel is treated as constant above, and
+  as having the constant slope getLowerSlope () below (for a flat
+  continuum extending to low energy); the weight neglected in the direct
+  convolution is then below about TRUNCATION.
+*/
+class LSFKernel
+{
+ public:
+  virtual ~LSFKernel () {}
+  virtual Real getCDF (Real x) = 0;
+  virtual Real getHalfWidth () = 0;
+  virtual Real getLowerSlope () {return 0.;}
+ protected:
+  static const Real TRUNCATION;
+  static const Real N_SIGMA;
+};
+
+/* Gaussian plus two Lorentzians, as in gratpr2; x and widths in A.
+   Gamma is the half width at half maximum, as in Lorentzian. */
+class GratingKernel : public LSFKernel
+{
+ public:
+  GratingKernel (Real Sigma, Real Gamma1, Real Gamma2,
+		 Real GaussianFraction, Real Ratio);
+  Real getCDF (Real x);
+  Real getHalfWidth ();
+ private:
+  Real itsSigma;
+  Real itsGamma1;
+  Real itsGamma2;
+  Real itsGaussianFraction;
+  Real itsRatio;
+};
+
+/* Gaussian core and exponential tail to low energy, as in sxslsf;
+   x and widths in keV. */
+class CalorimeterKernel : public LSFKernel
+{
+ public:
+  CalorimeterKernel (Real Sigma, Real ETail, Real CoreFraction,
+		     Real TailFraction);
+  Real getCDF (Real x);
+  Real getHalfWidth ();
+ private:
+  Real itsSigma;
+  Real itsETail;
+  Real itsCoreFraction;
+  Real itsTailFraction;
+  calorimeterLSF itsLSF;
+};
+
+/* Flat electron loss continuum below the source energy, with unit
+   density per keV; the caller scales each source bin by felc / E. */
+class CalorimeterContinuumKernel : public LSFKernel
+{
+ public:
+  CalorimeterContinuumKernel (Real Sigma);
+  Real getCDF (Real x);
+  Real getHalfWidth ();
+  Real getLowerSlope () {return 1.;}
+ private:
+  Real itsSigma;
+  calorimeterLSF itsLSF;
+};
+
+/*
+  The flux of each source bin is placed at its center. On a grid that is
+  uniform in the coordinate, the convolution is done exactly by FFT
+  (zero-padded, so flux convolved off the grid is lost rather than
+  wrapped around). Otherwise it is done directly, using for each source
+  bin the band of output bins within the kernel half width.
+  The kernel transform or band weights are cached, and only recomputed
+  when the coordinate grid or the kernel parameters (key) change, so a
+  convolution model whose parameters are frozen costs only the
+  convolution itself on later calls.
+  The coordinate must increase with index.
+*/
+class LSFConvolution
+{
+ public:
+  LSFConvolution ();
+  void convolve (const RealArray& coordinate, LSFKernel& kernel,
+		 const RealArray& key, RealArray& flux);
+  bool getUniform () const {return isUniform;}
+ private:
+  static const Real UNIFORM_TOLERANCE;
+  RealArray itsCoordinate;
+  RealArray itsKey;
+  bool isUniform;
+  size_t itsFFTSize;
+  RealArray itsKernelTransform;
+  Real itsLowerSlope;
+  vector<size_t> itsBandStart;
+  vector<RealArray> itsBandWeight;
+  bool isCached (const RealArray& coordinate, const RealArray& key);
+  void checkUniform ();
+  void buildTransform (LSFKernel& kernel);
+  void buildBand (LSFKernel& kernel);
+  void convolveFFT (RealArray& flux);
+  void convolveDirect (RealArray& flux);
+};
+
+#endif//LSF_CONVOLUTION_H
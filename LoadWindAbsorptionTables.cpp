@@ -24,11 +24,9 @@
 #include <iostream>
 //#include "Utilities.h"
 #include "LoadWindAbsorptionTables.h"
-#include "XspecUtilities.h"
+#include "WindProfileConfig.h"
 //#include "xsFortran.h"
 //#include "FunctionUtility.h"
-#include <XSFunctions/Utilities/FunctionUtility.h>
-#include <XSFunctions/functionMap.h>
 
 // Uncomment this for debugging output
 //#define LOADWINDABSTBLS_DEBUG 1
@@ -87,8 +85,8 @@ const RealArray KappaData::getKappaVV (RealArray RelativeAbundances,
   Real sum = 0.;
   for (size_t i=0; i<itsNZ; i++) {
     size_t Z = i + 1;
-    MassFractions[i] = FunctionUtility::getAbundance (Z) * itsAtomicMass[i] *
-      RelativeAbundances[i];
+    MassFractions[i] = WindProfileConfig::instance ().getAbundance (Z) *
+      itsAtomicMass[i] * RelativeAbundances[i];
     sum += MassFractions[i];
   }
   if (sum > 0.) {
@@ -169,14 +167,14 @@ bool KappaData::checkStatus2D ()
 void KappaData::getFilenames ()
 {
   // Get data directory from XSPEC xset variables
-  string windtabsDirectory = getXspecVariable ("WINDTABSDIRECTORY", "./");
+  string windtabsDirectory = getConfigVariable ("WINDTABSDIRECTORY", "./");
   // Get filenames from XSPEC xset variables
   itsFilename = windtabsDirectory + "/" +
-    getXspecVariable ("KAPPAFILENAME", "kappa.fits");
+    getConfigVariable ("KAPPAFILENAME", "kappa.fits");
   itsFilenameHeII = windtabsDirectory + "/" +
-    getXspecVariable ("KAPPAHEIIFILENAME", "kappaHeII.fits");
+    getConfigVariable ("KAPPAHEIIFILENAME", "kappaHeII.fits");
   itsFilename2D = windtabsDirectory + "/" +
-     getXspecVariable ("KAPPAZFILENAME", "kappa.fits");
+     getConfigVariable ("KAPPAZFILENAME", "kappa.fits");
   // perhaps would be best to completely disable default filenames
   // to prevent dumb mistakes, but leave it for now
 }
@@ -377,10 +375,10 @@ bool TransmissionData::checkStatus ()
 void TransmissionData::getFilename ()
 {
   // Get data directory from XSPEC xset variables
-  string windtabsDirectory = getXspecVariable ("WINDTABSDIRECTORY", "./");
+  string windtabsDirectory = getConfigVariable ("WINDTABSDIRECTORY", "./");
   // Get filename from XSPEC xset variables  
   itsFilename = windtabsDirectory + "/" +
-    getXspecVariable ("TRANSMISSIONFILENAME", "tau_transmission_HeII.fits");
+    getConfigVariable ("TRANSMISSIONFILENAME", "tau_transmission_HeII.fits");
 }
 
 void TransmissionData::loadData ()
@@ -459,10 +457,10 @@ bool TransmissionData2D::checkStatus ()
 void TransmissionData2D::getFilename ()
 {
   // Get data directory from XSPEC xset variables
-  string windtabsDirectory = getXspecVariable ("WINDTABSDIRECTORY", "./");
+  string windtabsDirectory = getConfigVariable ("WINDTABSDIRECTORY", "./");
   // Get filename from XSPEC xset variables  
   itsFilename = windtabsDirectory + "/" +
-    getXspecVariable ("TRANSMISSIONFILENAME2D", "tau_transmission.fits");
+    getConfigVariable ("TRANSMISSIONFILENAME2D", "tau_transmission.fits");
   return;
 }
 
@@ -27,10 +27,11 @@
 
 using namespace std;
 
-const Real Lorentzian::itsNumberOfGammas = 5.0;
+const Real Lorentzian::itsNumberOfGammas = 50.0;
 
 Lorentzian::Lorentzian (const RealArray& energy, Real LineEnergyKEV, Real GammaC) 
   : itsEnergyArray (energy), itsLineEnergy (LineEnergyKEV), itsGamma (GammaC), 
+    itsWindow (itsNumberOfGammas),
     itsEnergySize (energy.size()), itsFluxSize (itsEnergySize - 1), 
     itsCentralBin (itsFluxSize / 2), itsMinimumBin (0), 
     itsMaximumBin (itsFluxSize), isBackwards (true), isOutsideRange (true), 
@@ -57,12 +58,19 @@ void Lorentzian::checkInput ()
   /* 3. Check that gamma > 0. */
   isUnresolved = true;
   if (itsGamma > 0.) isUnresolved = false;
+  /* 4. Find the window in which atan is evaluated directly.
+     I am not bothering to check for aliasing problems in the core of the
+     profile because I am assuming that anytime you would bother to use a
+     Lorentzian instead of a Gaussian, it's because the Lorentzian is
+     broad enough that you care about the wings. */
+  itsMinimumBin = 0;
+  itsMaximumBin = itsFluxSize;
+  if (!isOutsideRange && !isUnresolved) {
+    Real HalfWidth = itsWindow * itsGamma;
+    itsMinimumBin = BinarySearch (itsEnergyArray, itsLineEnergy * (1. - HalfWidth));
+    itsMaximumBin = BinarySearch (itsEnergyArray, itsLineEnergy * (1. + HalfWidth));
+  }
   return;
-  /* Note that minimum and maximum bin are currently unused. I am not 
-     bothering to check for aliasing problems in the core of the profile 
-     because I am assuming that anytime you would bother to use a Lorentzian 
-     instead of a Gaussian, it's because the Lorentzian is broad enough 
-     that you care about the wings. */
 }
 
 void Lorentzian::setParameters (Real LineEnergyKEV, Real GammaC)
@@ -73,10 +81,23 @@ void Lorentzian::setParameters (Real LineEnergyKEV, Real GammaC)
   return;
 }
 
+void Lorentzian::setWindow (Real NumberOfGammas)
+{
+  itsWindow = NumberOfGammas;
+  checkInput ();
+  return;
+}
+
 void Lorentzian::getFlux (RealArray& flux)
 {
   /* 1. Initialize flux. */
   flux.resize(itsFluxSize, 0.);
+  addFlux (flux, 1.);
+  return;
+}
+
+void Lorentzian::addFlux (RealArray& flux, Real Weight)
+{
   /* 2. If response backwards, bail. */
   if (isBackwards) { 
     cout << "Lorentzian::getFlux: Backwards response not supported.\n";
@@ -88,57 +109,90 @@ void Lorentzian::getFlux (RealArray& flux)
       " keV) is outside response range.\n";
     return;
   }
+  if (compare (Weight, 0.) == 0) return;
   /* 4. If width is zero, put flux in central bin. */
   if (isUnresolved) { 
-    Real binCenterEnergy = (itsEnergyArray[itsCentralBin+1] + 
-			    itsEnergyArray[itsCentralBin]) / 2.;
-    Real binWidth = itsEnergyArray[itsCentralBin+1] - 
-      itsEnergyArray[itsCentralBin];
-    Real centeringFraction = (itsLineEnergy - binCenterEnergy) / binWidth;
-    flux[itsCentralBin] = 1. - fabs (centeringFraction);
-    if (centeringFraction > 0.) {
-      if (itsCentralBin < (itsFluxSize - 1)) {
-	flux[itsCentralBin + 1] = centeringFraction;
-      }
-    } else { /* centeringFraction < 0. */
-      if (itsCentralBin > 0) {
-	flux[itsCentralBin - 1] = fabs (centeringFraction);
-      }
+    addUnresolvedFlux (flux, Weight);
+  } else {
+    addResolvedFlux (flux, Weight);
+  }
+  return;
+}
+
+void Lorentzian::addUnresolvedFlux (RealArray& flux, Real Weight)
+{
+  Real binCenterEnergy = (itsEnergyArray[itsCentralBin+1] + 
+			  itsEnergyArray[itsCentralBin]) / 2.;
+  Real binWidth = itsEnergyArray[itsCentralBin+1] - 
+    itsEnergyArray[itsCentralBin];
+  Real centeringFraction = (itsLineEnergy - binCenterEnergy) / binWidth;
+  flux[itsCentralBin] += Weight * (1. - fabs (centeringFraction));
+  if (centeringFraction > 0.) {
+    if (itsCentralBin < (itsFluxSize - 1)) {
+      flux[itsCentralBin + 1] += Weight * centeringFraction;
     }
-    return;
+  } else { /* centeringFraction < 0. */
+    if (itsCentralBin > 0) {
+      flux[itsCentralBin - 1] += Weight * fabs (centeringFraction);
+    }
+  }
+  return;
+}
+
+/* The mass beyond |x| in one wing is atan (u) / pi with u = 1 / |x|;
+   for u < 1 / 10 this series is accurate to 1.e-11 relative. */
+static inline Real getTailAtan (Real u)
+{
+  Real u2 = u * u;
+  return (u * (1. + u2 * (-1./3. + u2 * (1./5. + u2 * (-1./7. + u2 * (1./9.))))));
+}
+
+/* 5. Calculate Lorentzian.
+   The Lorentzian is split into two parts so that each half can be
+   computed in such a way as to minimize rounding errors.
+   Note that the flux goes out to the end of the response matrix, 
+   unlike the Gaussian, since the Lorentzian wings are broad. However,
+   at some point if the Lorentzian is sufficiently broad, the idea of a
+   "non-relativistic" velocity shift is not valid.
+   Within itsWindow half widths of the center, bins are computed from
+   differences of atan of the argument, as before. Beyond that, the bin
+   flux is the difference in the tail mass beyond its edges, from the
+   series above; those loops have no transcendental calls or carried
+   dependencies, so they vectorize, and the number of atan calls does
+   not grow with the number of bins in the wings. */
+void Lorentzian::addResolvedFlux (RealArray& flux, Real Weight)
+{
+  const Real* energy = &itsEnergyArray[0];
+  Real* f = &flux[0];
+  Real E0 = itsLineEnergy;
+  Real Gamma = itsGamma;
+  Real Norm = Weight / M_PI;
+  size_t lower = (itsMinimumBin < itsCentralBin) ? itsMinimumBin : itsCentralBin;
+  size_t upper = (itsMaximumBin + 1 > itsCentralBin + 1) ? itsMaximumBin + 1 : itsCentralBin + 1;
+  if (upper > itsFluxSize) upper = itsFluxSize;
+
+  for (size_t i = 0; i < lower; i++) {
+    Real u1 = Gamma / (1. - energy[i] / E0);
+    Real u2 = Gamma / (1. - energy[i+1] / E0);
+    f[i] += Norm * (getTailAtan (u2) - getTailAtan (u1));
   }
-  /* 5. Calculate Lorentzian. */
-
-  /*
-    The Lorentzian is split into two parts so that each half can be computed 
-    in such a way as to minimize rounding errors.
-  */
-  RealArray LorentzianArgument (itsEnergySize);
-  LorentzianArgument = 
-    (itsEnergyArray / itsLineEnergy - 1.) / itsGamma;
-
-  /* 
-     Note that the loops go out to the end of the response matrix, 
-     unlike the Gaussian,
-     since the Lorentzian wings are broad, and the computation 
-     of the profile is not expensive. However, at some point
-     if the Lorentzian is sufficiently broad, the idea of a
-     "non-relativistic" velocity shift is not valid.
-  */
-  Real previous = atan (fabs(LorentzianArgument[0]));
-  for (size_t i = 0; i < itsCentralBin; i++) {
-    Real current = atan (fabs(LorentzianArgument[i+1]));
-    flux[i] = fabs (current - previous) / M_PI; 
+  Real previous = atan (fabs ((energy[lower] / E0 - 1.) / Gamma));
+  for (size_t i = lower; i < itsCentralBin; i++) {
+    Real current = atan (fabs ((energy[i+1] / E0 - 1.) / Gamma));
+    f[i] += Norm * fabs (current - previous); 
     previous = current;
   }
 
-  previous = atan (LorentzianArgument[itsEnergySize - 1]);
-  for (size_t i = itsFluxSize; i > itsCentralBin; i--) {
-    Real current = atan (LorentzianArgument [i-1]);
-    flux[i-1] = fabs (current - previous) / M_PI; 
+  previous = atan ((energy[upper] / E0 - 1.) / Gamma);
+  for (size_t i = upper; i > itsCentralBin; i--) {
+    Real current = atan ((energy[i-1] / E0 - 1.) / Gamma);
+    f[i-1] += Norm * fabs (current - previous); 
     previous = current;
   }
-
+  for (size_t i = upper; i < itsFluxSize; i++) {
+    Real u1 = Gamma / (energy[i] / E0 - 1.);
+    Real u2 = Gamma / (energy[i+1] / E0 - 1.);
+    f[i] += Norm * (getTailAtan (u1) - getTailAtan (u2));
+  }
   return;
 }
-
@@ -31,12 +31,19 @@ class Lorentzian {
   ~Lorentzian ();
   void setParameters (Real LineEnergyKEV, Real GammaC);
   void getFlux (RealArray& flux);
+  /* Adds Weight times the profile to flux, which must already have the
+     size of the flux grid. */
+  void addFlux (RealArray& flux, Real Weight);
+  /* Number of half widths within which atan is evaluated; beyond it the
+     tail mass is computed from its series (should be at least 10). */
+  void setWindow (Real NumberOfGammas);
   bool checkOutOfBounds () {return isOutsideRange;}
  private:
   static const Real itsNumberOfGammas;
   const RealArray& itsEnergyArray;
   Real itsLineEnergy;
   Real itsGamma;
+  Real itsWindow;
   size_t itsEnergySize;
   size_t itsFluxSize;
   size_t itsCentralBin;
@@ -46,7 +53,8 @@ class Lorentzian {
   bool isOutsideRange; /* True if line center is outside response range. */
   bool isUnresolved; /* True if gamma = 0. */
   void checkInput ();
-  Real getLorentzianArgument (int n);
+  void addUnresolvedFlux (RealArray& flux, Real Weight);
+  void addResolvedFlux (RealArray& flux, Real Weight);
 };
 
 #endif//LORENTZIAN_H
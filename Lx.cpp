@@ -21,6 +21,8 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "Lx.h"
+#include "FastMath.h"
+#include "Diagnostics.h"
 #include <iostream>
 
 using namespace std;
@@ -88,12 +90,17 @@ void Lx::checkInput ()
     itsBeta = 1.;
   }
   if (itsHeLikeRatio != 0) isHeLike = true;
+  isQZero = (compare (itsQ, 0.) == 0);
+  isFastMath = getFastMath ();
   return;
 }
 
 void Lx::allocateClasses ()
 {
   itsUxRoot = new UxRoot (itsVelocity, 0.5);
+  // Use tanh-sinh for the u^q singularity at u = 0. Not for RAD, since
+  // the narrow resonance in the integrand is not an endpoint singularity.
+  setTanhSinh ((compare (itsQ, 0.) == -1) && isRADTransparent);
 }
 
 Lx::~Lx ()
@@ -141,14 +148,18 @@ Real Lx::getLx (Real x)
   /* If Umin > 0., ignore convergence issues (see below), 
      since the Umin cutoff will likely solve the problem. */
   if (compare (itsUmin, 0.) == 1) {
-    answer = qagp (itsUmin, Ux);
+    answer = qendpoints (itsUmin, Ux);
     return answer;
   }
-  /* Split the integral for q < -0.5, since it seems to have trouble 
-     converging sometimes (esp. for small tau_* and small x).
+  /* Tanh-sinh handles the u^q singularity at u = 0 directly.
+     With qagp, split the integral for q < -0.5, since it seems to have 
+     trouble converging sometimes (esp. for small tau_* and small x).
      The convergence problem occurs as u->0, so a small part of that end
-     of the integral is split off. */
-  if (compare (itsQ, -0.5) == -1) {
+     of the integral is split off. Those are also the cases where
+     tanh-sinh may not converge, so they fall back on the split. */
+  if (getTanhSinh () && tryTanhSinh (0., Ux)) {
+    answer = getResult ();
+  } else if (compare (itsQ, -0.5) == -1) {
     double answer1 = qagp (Ux/10., Ux);
     double answer2 = qagp (0., Ux/10.);
     answer = answer1 + answer2;
@@ -156,7 +167,7 @@ Real Lx::getLx (Real x)
     answer = qagp (0., Ux);
   }
   if (getStatus ()) {
-    cout << "Lx error report:" << itsX << "\n";
+    DIAGNOSE (diagnosticWarning, "Lx::getLx", "Lx error report:" << itsX);
   }
   return answer;
   //return qagp (0., Ux);
@@ -171,6 +182,15 @@ Real Lx::getLx (Real x)
   */
 }
 
+void Lx::setTolerance (Real epsrel)
+{
+  setEpsRel (epsrel);
+  itsOpticalDepth->setTolerance (epsrel);
+  if (isHeII) itsOpticalDepthHeII->setTolerance (epsrel);
+  if (itsRAD_OpticalDepth != NULL) itsRAD_OpticalDepth->setTolerance (epsrel);
+  return;
+}
+
 Real Lx::getXKink ()
 {
   return -1. * pow (1. - itsU0, itsBeta);
@@ -194,11 +214,18 @@ double Lx::integrand (double u)
   if (!isTransparent) {
     // Transparent is a flag to allow for easy
     // calculation of a profile with zero optical depth
-    Real tau = itsOpticalDepth->getOpticalDepth (p, z);
-    if (isHeII) { // opacity from He++ recombining to He+
-      tau += itsKappaRatio * itsOpticalDepthHeII->getOpticalDepth (p, z);
+    Real tau = 0.;
+    if (isHeII && itsOpticalDepthHeII->getCombinable (itsOpticalDepth)) {
+      // both in one integral
+      tau = itsOpticalDepthHeII->getCombinedOpticalDepth 
+	(p, z, itsKappaRatio);
+    } else {
+      tau = itsOpticalDepth->getOpticalDepth (p, z);
+      if (isHeII) { // opacity from He++ recombining to He+
+	tau += itsKappaRatio * itsOpticalDepthHeII->getOpticalDepth (p, z);
+      }
     }
-    Transmission = exp (-1. * tau);
+    Transmission = isFastMath ? fastExp (-1. * tau) : exp (-1. * tau);
   }
   /*
     This should be recoded so that HeLikeType is checked only for a He-like
@@ -219,9 +246,11 @@ double Lx::integrand (double u)
   Real RADTransmission = 1.;
   if (!isRADTransparent) {
     Real RADtau = itsRAD_OpticalDepth->getOpticalDepth (p,z);
-    RADTransmission = exp (-1. * RADtau);
+    RADTransmission = 
+      isFastMath ? fastExp (-1. * RADtau) : exp (-1. * RADtau);
   }
-  double Integrand = pow (u, itsQ) / gsl_pow_3 (w); // emission
+  double Integrand = 1. / gsl_pow_3 (w); // emission
+  if (!isQZero) Integrand *= isFastMath ? fastPow (u, itsQ) : pow (u, itsQ);
   Integrand *= Transmission; // absorption
   Integrand *= HeLikeFactor; // radial dependence of f/i ratio
   Integrand *= EscapeProbability; // resonance scattering
@@ -50,6 +50,8 @@ class Lx : public Integral
   void notTransparent () {isTransparent = false; return;}
   void setRADTransparent () {isRADTransparent = true; return;}
   void notRADTransparent () {isRADTransparent = false; return;}
+  // relative tolerance for the u integral and the nested optical depths
+  void setTolerance (Real epsrel);
   Real getLx (Real x);
   Real getXKink ();
   Real getXOcc ();
@@ -73,6 +75,8 @@ class Lx : public Integral
   OpticalDepth* itsOpticalDepthHeII;
   RAD_OpticalDepth* itsRAD_OpticalDepth;
   UxRoot* itsUxRoot;
+  bool isQZero;
+  bool isFastMath;
   double integrand0 ();
   void checkInput ();
   void allocateClasses ();
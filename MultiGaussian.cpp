@@ -0,0 +1,193 @@
+/***************************************************************************
+    MultiGaussian.cpp - computes the sum of several weighted Gaussian line
+                        profiles for XSPEC in one pass over the energy grid.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "MultiGaussian.h"
+#include "Utilities.h"
+#include <iostream>
+#include <algorithm>
+#include <utility>
+#include <math.h>
+
+using namespace std;
+
+const Real MultiGaussian::itsNumberOfSigmas = 6.0;
+
+MultiGaussian::MultiGaussian (const RealArray& energy)
+  : itsEnergyArray (energy), itsEnergySize (energy.size ()),
+    itsFluxSize (itsEnergySize - 1), itsLine (0), isLocated (false)
+{
+  return;
+}
+
+MultiGaussian::~MultiGaussian ()
+{
+  return;
+}
+
+void MultiGaussian::addLine (Real LineEnergyKEV, Real SigmaC, Real Weight)
+{
+  Line line;
+  line.itsEnergy = LineEnergyKEV;
+  line.itsSigma = SigmaC;
+  line.itsWeight = Weight;
+  line.itsCentralBin = itsFluxSize / 2;
+  line.itsMinimumBin = 0;
+  line.itsMaximumBin = itsFluxSize;
+  line.isOutsideRange = true;
+  line.isUnresolved = true;
+  itsLine.push_back (line);
+  isLocated = false;
+  return;
+}
+
+void MultiGaussian::clearLines ()
+{
+  itsLine.clear ();
+  isLocated = false;
+  return;
+}
+
+bool MultiGaussian::checkOutOfBounds ()
+{
+  if (!isLocated) locateWindows ();
+  for (size_t j = 0; j < itsLine.size (); j++) {
+    if (itsLine[j].isOutsideRange) return true;
+  }
+  return false;
+}
+
+/* The window edges of all lines are sorted, and then found by walking
+   a single cursor up the grid; each gives the same index as
+   BinarySearch, i.e. the last grid point below the value (or 0). */
+void MultiGaussian::locateWindows ()
+{
+  vector<pair<Real, size_t*> > query;
+  query.reserve (3 * itsLine.size ());
+  for (size_t j = 0; j < itsLine.size (); j++) {
+    Line& line = itsLine[j];
+    line.isOutsideRange = ((line.itsEnergy < itsEnergyArray[0]) ||
+			   (itsEnergyArray[itsEnergySize - 1] < line.itsEnergy));
+    query.push_back (make_pair (line.itsEnergy, &line.itsCentralBin));
+    if (!line.isOutsideRange) {
+      Real HalfWidth = itsNumberOfSigmas * line.itsSigma;
+      query.push_back (make_pair (line.itsEnergy * (1. - HalfWidth),
+				  &line.itsMinimumBin));
+      query.push_back (make_pair (line.itsEnergy * (1. + HalfWidth),
+				  &line.itsMaximumBin));
+    }
+  }
+  sort (query.begin (), query.end ());
+  size_t cursor = 0;
+  for (size_t k = 0; k < query.size (); k++) {
+    while ((cursor + 1 < itsEnergySize) &&
+	   (query[k].first > itsEnergyArray[cursor + 1])) cursor++;
+    *query[k].second = cursor;
+  }
+  for (size_t j = 0; j < itsLine.size (); j++) {
+    Line& line = itsLine[j];
+    line.isUnresolved = ((line.itsSigma <= 0.) ||
+			 ((line.itsMaximumBin - line.itsMinimumBin) < 3));
+  }
+  isLocated = true;
+  return;
+}
+
+void MultiGaussian::getFlux (RealArray& flux)
+{
+  if (flux.size () != itsFluxSize) {
+    flux.resize (itsFluxSize);
+  } else {
+    flux = 0.;
+  }
+  addFlux (flux);
+  return;
+}
+
+void MultiGaussian::addFlux (RealArray& flux)
+{
+  if (isBackwards (itsEnergyArray)) {
+    cout << "MultiGaussian::getFlux: Backwards response not supported.\n";
+    return;
+  }
+  if (!isLocated) locateWindows ();
+  for (size_t j = 0; j < itsLine.size (); j++) {
+    const Line& line = itsLine[j];
+    if (line.isOutsideRange) {
+      cout << "MultiGaussian::getFlux: rest energy (" << line.itsEnergy
+	   << " keV) is outside response range.\n";
+      continue;
+    }
+    if (compare (line.itsWeight, 0.) == 0) continue;
+    if (line.isUnresolved) {
+      addUnresolvedLine (line, flux);
+    } else {
+      addResolvedLine (line, flux);
+    }
+  }
+  return;
+}
+
+/* Put the flux in the central bin, shared linearly with the nearest
+   neighbouring bin. */
+void MultiGaussian::addUnresolvedLine (const Line& line, RealArray& flux)
+{
+  size_t n = line.itsCentralBin;
+  Real binCenterEnergy = (itsEnergyArray[n+1] + itsEnergyArray[n]) / 2.;
+  Real binWidth = itsEnergyArray[n+1] - itsEnergyArray[n];
+  Real centeringFraction = (line.itsEnergy - binCenterEnergy) / binWidth;
+  flux[n] += line.itsWeight * (1. - fabs (centeringFraction));
+  if (centeringFraction > 0.) {
+    if (n < (itsFluxSize - 1)) {
+      flux[n+1] += line.itsWeight * centeringFraction;
+    }
+  } else {
+    if (n > 0) flux[n-1] += line.itsWeight * fabs (centeringFraction);
+  }
+  return;
+}
+
+/* As in Gaussian, each half is computed from the erfc of the distance
+   from the center, to minimize rounding errors in the wings. */
+void MultiGaussian::addResolvedLine (const Line& line, RealArray& flux)
+{
+  Real InverseWidth = 1. / (line.itsSigma * M_SQRT2);
+  Real HalfWeight = 0.5 * line.itsWeight;
+  Real E0 = line.itsEnergy;
+
+  Real previous =
+    erfc (fabs ((itsEnergyArray[line.itsMinimumBin] / E0 - 1.) * InverseWidth));
+  for (size_t i = line.itsMinimumBin; i < line.itsCentralBin; i++) {
+    Real current =
+      erfc (fabs ((itsEnergyArray[i+1] / E0 - 1.) * InverseWidth));
+    flux[i] += HalfWeight * fabs (current - previous);
+    previous = current;
+  }
+
+  previous = erfc ((itsEnergyArray[line.itsMaximumBin] / E0 - 1.) * InverseWidth);
+  for (size_t i = line.itsMaximumBin; i > line.itsCentralBin; i--) {
+    Real current = erfc ((itsEnergyArray[i-1] / E0 - 1.) * InverseWidth);
+    flux[i-1] += HalfWeight * fabs (current - previous);
+    previous = current;
+  }
+  return;
+}
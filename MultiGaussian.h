@@ -0,0 +1,73 @@
+/***************************************************************************
+    MultiGaussian.h - computes the sum of several weighted Gaussian line
+                      profiles for XSPEC in one pass over the energy grid.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef MULTI_GAUSSIAN_H
+#define MULTI_GAUSSIAN_H
+
+#include <vector>
+#include "xsTypes.h"
+
+using namespace std;
+
+/*
+  Each line is computed exactly as by Gaussian (same 6 sigma window and
+  treatment of unresolved lines; SigmaC is relative to the line energy),
+  but the windows of all lines are located in a single merge over the
+  energy grid, erfc is evaluated once per bin edge inside each window,
+  and the weighted bin fluxes are accumulated directly into the output.
+*/
+class MultiGaussian {
+ public:
+  MultiGaussian (const RealArray& Energy);
+  ~MultiGaussian ();
+  void addLine (Real LineEnergyKEV, Real SigmaC, Real Weight);
+  void clearLines ();
+  /* True if any line center is outside the response range. */
+  bool checkOutOfBounds ();
+  void getFlux (RealArray& flux);
+  /* Adds the lines to flux, which must already have the size of the
+     flux grid. */
+  void addFlux (RealArray& flux);
+ private:
+  struct Line {
+    Real itsEnergy;
+    Real itsSigma;
+    Real itsWeight;
+    size_t itsCentralBin;
+    size_t itsMinimumBin;
+    size_t itsMaximumBin;
+    bool isOutsideRange;
+    bool isUnresolved;
+  };
+  static const Real itsNumberOfSigmas;
+  const RealArray& itsEnergyArray;
+  size_t itsEnergySize;
+  size_t itsFluxSize;
+  vector<Line> itsLine;
+  bool isLocated;
+  void locateWindows ();
+  void addResolvedLine (const Line& line, RealArray& flux);
+  void addUnresolvedLine (const Line& line, RealArray& flux);
+};
+
+#endif//MULTI_GAUSSIAN_H
@@ -22,7 +22,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "NeLikeGaussian.h"
-#include "Gaussian.h"
+#include "MultiGaussian.h"
 #include "Utilities.h"
 #include "AtomicParameters.h"
 #include <iostream>
@@ -73,25 +73,21 @@ void NeLikeGaussian::extractParameters (const RealArray& parameter)
 void NeLikeGaussian::getFlux (RealArray& flux)
 {
   size_t Nflux = itsEnergyArray.size () - 1;
-  flux.resize (Nflux);
-  MatrixValue neflux (Nlines); 
-  /* MatrixValue is from xsTypes.h - should work like an array of RealArrays */
-  Gaussian G (itsEnergyArray, itsEnergy[0], itsSigma);
-  for (size_t i = 0; i < Nlines; i++) {
-    neflux[i].resize (Nflux);
-    G.setParameters (itsEnergy[i], itsSigma);
-    if (G.checkOutOfBounds ()) {
-      cout << "HeLikeGaussian:getFlux () - one or more lines have "
-	   << "energies outside the response range; "
-	   << "setting model flux to zero.\n";
-      return;
-    }
-    G.getFlux (neflux[i]);
-  }
   RealArray Normalization (Nlines);
   Normalization[0] = its3F;
   Normalization[1] = (1. - its3F) / (1. + itsM2_3G);
   Normalization[2] = itsM2_3G * Normalization[1];
-  for (size_t i = 0; i < Nlines; i++) flux += neflux[i] * Normalization [i];
+  MultiGaussian G (itsEnergyArray);
+  for (size_t i = 0; i < Nlines; i++) {
+    G.addLine (itsEnergy[i], itsSigma, Normalization[i]);
+  }
+  if (G.checkOutOfBounds ()) {
+    cout << "NeLikeGaussian:getFlux () - one or more lines have "
+	 << "energies outside the response range; "
+	 << "setting model flux to zero.\n";
+    flux.resize (Nflux);
+    return;
+  }
+  G.getFlux (flux);
   return;
 }
@@ -36,7 +36,7 @@ class NeLikeGaussian
   void getFlux (RealArray& flux);
  private:
   const static size_t Nlines = 3; 
-  const RealArray itsEnergyArray;
+  const RealArray& itsEnergyArray;
   Real its3F; // ratio of 3F / (3F+3G+M2)
   Real itsM2_3G; // ratio of M2/3G
   Real itsSigma;
@@ -23,6 +23,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "NumericalOpticalDepth.h"
+#include "Diagnostics.h"
 #include <iostream>
 
 using namespace std;
@@ -50,7 +51,8 @@ NumericalOpticalDepth::NumericalOpticalDepth
   : itsP (0.), itsTauStar (TauStar), isTransparent (false), 
     isPorous (false), itsPorosity (P), itsVelocity (V), 
     itsNumericalOpticalDepthZ (NULL), itsNumericalOpticalDepthU  (NULL),
-    isHeII (HeII), nButterworth (3), uButterworth (0.2)
+    isHeII (HeII), isCombined (false), itsKappaRatio (0.),
+    nButterworth (3), uButterworth (0.2)
 {
   /* enable this for debug:
   if (isHeII) {
@@ -114,6 +116,13 @@ void NumericalOpticalDepth::setTauStar (Real TauStar)
   // Note that the Porosity class will also be changed by the OpticalDepth class.
 }
 
+void NumericalOpticalDepth::setTolerance (Real epsrel)
+{
+  itsNumericalOpticalDepthZ->setEpsRel (epsrel);
+  itsNumericalOpticalDepthU->setEpsRel (epsrel);
+  return;
+}
+
 void NumericalOpticalDepth::allocateNumericalOpticalDepthZU ()
 {
   itsNumericalOpticalDepthZ = new NumericalOpticalDepthZ (this);
@@ -154,22 +163,43 @@ Real NumericalOpticalDepth::getOpticalDepth (Real p, Real z)
     t = itsNumericalOpticalDepthU->getOpticalDepth (p, z);
     status = itsNumericalOpticalDepthU->getStatus ();
     if (status) {
-      cout << "NumericalOpticalDepth: NumericalOpticalDepthU returned status code " << status << "\n";
+      DIAGNOSE (diagnosticWarning, "NumericalOpticalDepth::getOpticalDepth",
+		"NumericalOpticalDepth: NumericalOpticalDepthU returned "
+		<< "status code " << status);
     }
   } else {
     if (compare (p, LARGE_P) == 1) {
-      return itsTauStar * (M_PI_2 + atan (z / p)) / p;
+      return itsTauStar * HeIIFilter (0.) * (M_PI_2 - atan (z / p)) / p;
     }
     t = itsNumericalOpticalDepthZ->getOpticalDepth (p,z);
     status = itsNumericalOpticalDepthZ->getStatus ();
     if (status) {
-      cout << "NumericalOpticalDepth: NumericalOpticalDepthZ returned status code " << status << "\n";
+      DIAGNOSE (diagnosticWarning, "NumericalOpticalDepth::getOpticalDepth",
+		"NumericalOpticalDepth: NumericalOpticalDepthZ returned "
+		<< "status code " << status);
     }
   }
   return itsTauStar * t;
 }
 
+Real NumericalOpticalDepth::getCombinedOpticalDepth 
+(Real p, Real z, Real kappaRatio)
+{
+  if (!isHeII) {
+    DIAGNOSE (diagnosticError,
+	      "NumericalOpticalDepth::getCombinedOpticalDepth",
+	      "NumericalOpticalDepth: combined optical depth without HeII.");
+    return getOpticalDepth (p, z);
+  }
+  isCombined = true;
+  itsKappaRatio = kappaRatio;
+  Real tau = getOpticalDepth (p, z);
+  isCombined = false;
+  return tau;
+}
+
 // Approximate the He ionization fraction with a Butterworth filter
+// (for the combined optical depth, 1 + kappaRatio times the filter)
 Real NumericalOpticalDepth::HeIIFilter (Real u) 
 {
   Real answer = 1.;
@@ -177,6 +207,7 @@ Real NumericalOpticalDepth::HeIIFilter (Real u)
     Real u2n = pow (u, 2*nButterworth); 
     Real ub2n = pow (uButterworth, 2*nButterworth);
     answer = 1. - sqrt (u2n / (u2n + ub2n)); 
+    if (isCombined) answer = 1. + itsKappaRatio * answer;
   }
   return answer;
 } 
@@ -74,7 +74,13 @@ class NumericalOpticalDepth
   ~NumericalOpticalDepth ();
   void setParameters (Real TauStar, Porosity* P, Velocity* V);
   void setTauStar (Real TauStar);
+  void setTolerance (Real epsrel);
   Real getOpticalDepth (Real p, Real z);
+  // tau + kappaRatio tau_HeII, for an object made with HeII: both
+  // integrands are summed along the ray (see HeIIFilter), so they
+  // share one integral. The plain optical depth must have the same
+  // TauStar, porosity and velocity, as in WindParameter.
+  Real getCombinedOpticalDepth (Real p, Real z, Real kappaRatio);
   friend double NumericalOpticalDepthZ::integrand (double z);
   friend double NumericalOpticalDepthU::integrand (double u);
  private:
@@ -94,6 +100,8 @@ class NumericalOpticalDepth
   void freeNumericalOpticalDepthZU ();
   // for He II optical depth
   bool isHeII;
+  bool isCombined; // during getCombinedOpticalDepth
+  Real itsKappaRatio;
   // The Butterworth filter parameters are hardcoded for now.
   int nButterworth; 
   Real uButterworth; 
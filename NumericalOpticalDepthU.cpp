@@ -26,6 +26,8 @@
 NumericalOpticalDepthU::NumericalOpticalDepthU (NumericalOpticalDepth* A)
   : Integral (), itsP (0.), itsNumericalOpticalDepth (A)
 {
+  // The integrand goes as 1/mu, which diverges at the upper limit for z = 0.
+  setTanhSinh (true);
   return;
 }
 
@@ -33,7 +35,7 @@ Real NumericalOpticalDepthU::getOpticalDepth (Real p, Real z)
 {
   itsP = p;
   Real u = 1. / hypot (itsP, z);
-  return qag (0., u);
+  return qendpoints (0., u);
 }
 
 double NumericalOpticalDepthU::integrand (double u)
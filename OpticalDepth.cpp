@@ -22,11 +22,28 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "OpticalDepth.h"
+#include "Diagnostics.h"
+#include <cmath>
 #include <iostream>
 using namespace std;
 
 const Real OpticalDepth::MINIMUM_VELOCITY = 0.001;
 
+// The probes are away from the photosphere and off the grid of
+// TabulatedOpticalDepth; mu < 0 also checks the symmetry about z = 0.
+// The tolerance is above the integration error of the numerical
+// optical depth at its default tolerance, and above the effect of its
+// minimum velocity (about MINIMUM_VELOCITY / w, 0.4% at u = 0.8),
+// which the analytic optical depth does not have; so it catches
+// backends that do not compute the same thing, not the last digits.
+const size_t OpticalDepth::N_PROBE_U = 3;
+const size_t OpticalDepth::N_PROBE_MU = 3;
+const Real OpticalDepth::PROBE_U[] = {0.15, 0.45, 0.8};
+const Real OpticalDepth::PROBE_MU[] = {-0.35, 0.1, 0.7};
+const Real OpticalDepth::PROBE_TOLERANCE = 1.e-2;
+
+bool OpticalDepth::isAutomatic = false;
+
 /*OpticalDepth::OpticalDepth 
 (Real TauStar, Real h, Real beta, bool numerical, bool anisotropic, 
  bool rosseland, bool expansion)
@@ -48,9 +65,12 @@ const Real OpticalDepth::MINIMUM_VELOCITY = 0.001;
 OpticalDepth::OpticalDepth 
 (Real TauStar, Real h, Real beta, bool numerical, bool anisotropic, 
  bool prolate, bool rosseland, bool expansion, bool HeII)
-  : isNumerical (numerical), isHeII (HeII),
-    itsVelocity (NULL), itsPorosity (NULL),
-    itsAnalyticOpticalDepth (NULL), itsNumericalOpticalDepth (NULL)
+  : isNumerical (numerical), isHeII (HeII), isSelected (false),
+    itsBeta (beta), isAnisotropic (anisotropic), isRosseland (rosseland),
+    itsBackend (numerical ? numericalBackend : analyticBackend),
+    itsReason (), itsVelocity (NULL), itsPorosity (NULL),
+    itsAnalyticOpticalDepth (NULL), itsNumericalOpticalDepth (NULL),
+    itsTabulatedOpticalDepth (NULL)
 {
   /* 
      need to save information on h if tauclump is to be varied! 
@@ -67,6 +87,7 @@ OpticalDepth::OpticalDepth
     allocateVelocity (beta);
     allocatePorosity (TauStar, h, anisotropic, prolate, rosseland);
     allocateNumericalOpticalDepth (TauStar);
+    selectBackend (TauStar, h);
   } else {
     allocateAnalyticOpticalDepth (TauStar, h, anisotropic, expansion);
     if (isHeII) {
@@ -84,24 +105,147 @@ OpticalDepth::~OpticalDepth ()
 
 Real OpticalDepth::getOpticalDepth (Real p, Real z)
 {
-  if (isNumerical) {
-    return itsNumericalOpticalDepth->getOpticalDepth (p, z);
-  } else {
+  switch (itsBackend) {
+  case analyticBackend:
     return itsAnalyticOpticalDepth->getOpticalDepth (p, z);
+  case tabulatedBackend:
+    return itsTabulatedOpticalDepth->getOpticalDepth (p, z);
+  default:
+    return itsNumericalOpticalDepth->getOpticalDepth (p, z);
   }
 }
 
+Real OpticalDepth::getCombinedOpticalDepth (Real p, Real z, Real kappaRatio)
+{
+  return itsNumericalOpticalDepth->getCombinedOpticalDepth (p, z, kappaRatio);
+}
+
+/* Tau may have been made analytic, or its backend selected
+   automatically, in which case it is cheaper than the He II one. */
+bool OpticalDepth::getCombinable (const OpticalDepth* Tau) const
+{
+  return isHeII && (itsBackend == numericalBackend) && !Tau->isHeII &&
+    (Tau->itsBackend == numericalBackend);
+}
+
 void OpticalDepth::setParameters (Real TauStar, Real h)
 {
   if (isNumerical) {
     itsPorosity->setParameters (TauStar * h);
     itsNumericalOpticalDepth->setTauStar (TauStar);
+    selectBackend (TauStar, h);
   } else {
     itsAnalyticOpticalDepth->setParameters (TauStar, h);
   }
   // This version should work correctly.
 }
 
+void OpticalDepth::setTolerance (Real epsrel)
+{
+  if (isNumerical) {
+    itsNumericalOpticalDepth->setTolerance (epsrel);
+  }
+  return;
+}
+
+const char* OpticalDepth::getBackendName (OpticalDepthBackend backend)
+{
+  switch (backend) {
+  case analyticBackend: return "analytic";
+  case tabulatedBackend: return "tabulated";
+  default: return "numerical";
+  }
+}
+
+void OpticalDepth::reportBackend () const
+{
+  if (isSelected && (itsBackend == numericalBackend)) {
+    DIAGNOSE (diagnosticInfo, "optical depth numerical",
+	      "OpticalDepth: integrating numerically (" << itsReason << ")");
+  } else {
+    DIAGNOSE (diagnosticDebug, "optical depth backend",
+	      "OpticalDepth: " << getBackendName (itsBackend)
+	      << (isSelected ? " (selected automatically)" : ""));
+  }
+  return;
+}
+
+/* See OpticalDepth.h. The numerical objects are kept in any case:
+   they are the reference for the probes, and TabulatedOpticalDepth
+   falls back on them near the photosphere. */
+void OpticalDepth::selectBackend (Real TauStar, Real h)
+{
+  delete itsAnalyticOpticalDepth;
+  itsAnalyticOpticalDepth = NULL;
+  delete itsTabulatedOpticalDepth;
+  itsTabulatedOpticalDepth = NULL;
+  itsBackend = numericalBackend;
+  isSelected = isAutomatic;
+  if (!isSelected) return;
+  bool isBetaOne = (compare (itsBeta, 1.) == 0);
+  bool isPorous = itsPorosity->getPorous ();
+  if (isHeII) {
+    itsReason = "He II";
+    return;
+  }
+  if (isBetaOne && (!isPorous || (!isAnisotropic && isRosseland))) {
+    itsAnalyticOpticalDepth = 
+      new AnalyticOpticalDepth (TauStar, isPorous ? h : 0., false, false);
+    itsBackend = analyticBackend;
+  } else if (!isPorous) {
+    itsTabulatedOpticalDepth = new TabulatedOpticalDepth 
+      (TauStar, itsBeta, MINIMUM_VELOCITY, itsNumericalOpticalDepth);
+    if (!itsTabulatedOpticalDepth->isValid ()) {
+      delete itsTabulatedOpticalDepth;
+      itsTabulatedOpticalDepth = NULL;
+      itsReason = "the table could not be made";
+      return;
+    }
+    itsBackend = tabulatedBackend;
+  } else {
+    if (!isBetaOne) {
+      itsReason = "porous, beta != 1";
+    } else if (isAnisotropic) {
+      itsReason = "porous, anisotropic";
+    } else {
+      itsReason = "porous, exponential bridging law";
+    }
+    return;
+  }
+  if (!verifyBackend ()) {
+    DIAGNOSE (diagnosticWarning, "OpticalDepth::selectBackend",
+	      "OpticalDepth: the " << getBackendName (itsBackend)
+	      << " optical depth does not match the numerical one (beta = "
+	      << itsBeta << ", TauStar = " << TauStar << ", h = " << h
+	      << "); integrating numerically");
+    delete itsAnalyticOpticalDepth;
+    itsAnalyticOpticalDepth = NULL;
+    delete itsTabulatedOpticalDepth;
+    itsTabulatedOpticalDepth = NULL;
+    itsBackend = numericalBackend;
+    itsReason = "failed the probes";
+  }
+  return;
+}
+
+bool OpticalDepth::verifyBackend ()
+{
+  for (size_t i = 0; i < N_PROBE_U; i++) {
+    for (size_t j = 0; j < N_PROBE_MU; j++) {
+      Real u = PROBE_U[i];
+      Real mu = PROBE_MU[j];
+      Real p = sqrt (1. - mu * mu) / u;
+      Real z = mu / u;
+      Real reference = itsNumericalOpticalDepth->getOpticalDepth (p, z);
+      Real tau = getOpticalDepth (p, z);
+      if (!(fabs (tau - reference) <= PROBE_TOLERANCE * reference)) {
+	return false;
+      }
+    }
+  }
+  return true;
+}
+
 void OpticalDepth::allocateVelocity (Real beta)
 {
   itsVelocity = new Velocity (beta, MINIMUM_VELOCITY);
@@ -132,7 +276,11 @@ void OpticalDepth::allocateAnalyticOpticalDepth
 
 void OpticalDepth::freeClasses ()
 {
+  delete itsTabulatedOpticalDepth;
+  itsTabulatedOpticalDepth = NULL;
   if (isNumerical) {
+    delete itsAnalyticOpticalDepth;
+    itsAnalyticOpticalDepth = NULL;
     delete itsNumericalOpticalDepth;
     itsNumericalOpticalDepth = NULL;
     delete itsPorosity;
@@ -25,11 +25,17 @@
 #define OPTICAL_DEPTH_H
 
 #include <stdbool.h>
+#include <string>
 #include "xsTypes.h"
 #include "Utilities.h"
 #include "Porosity.h"
 #include "AnalyticOpticalDepth.h"
 #include "NumericalOpticalDepth.h"
+#include "TabulatedOpticalDepth.h"
+
+using namespace std;
+
+enum OpticalDepthBackend {analyticBackend, tabulatedBackend, numericalBackend};
 
 /***********************************************************************\
 
@@ -42,6 +48,17 @@ so that one may grid over parameters, beta must remain constant,
 and the booleans are fixed. Thus, to study different optical depth 
 formulations, one must instantiate a new OpticalDepth.
 
+With automatic selection (setAutomatic), a numerical OpticalDepth is
+evaluated by the fastest backend that gives the same optical depth:
+AnalyticOpticalDepth if beta = 1 and the wind is smooth, or porous
+with isotropic clumps and the Rosseland bridging law (the stretch
+form of AnalyticOpticalDepth); otherwise TabulatedOpticalDepth if the
+wind is smooth; otherwise NumericalOpticalDepth, which is also always
+used for He II. The choice is checked against NumericalOpticalDepth
+at PROBE_U x PROBE_MU, to PROBE_TOLERANCE relative, and is made again
+by setParameters. An OpticalDepth that is not numerical is always
+analytic, as chosen.
+
 \***********************************************************************/
 class OpticalDepth {
  public:
@@ -55,15 +72,46 @@ class OpticalDepth {
      bool HeII = false);
   ~OpticalDepth ();
   Real getOpticalDepth (Real p, Real z);
+  // For a He II OpticalDepth: tau + kappaRatio tau_HeII, where tau is
+  // that of the plain OpticalDepth with the same parameters, if it is
+  // integrated numerically too (see getCombinable); the two integrals
+  // are done as one (see NumericalOpticalDepth).
+  Real getCombinedOpticalDepth (Real p, Real z, Real kappaRatio);
+  bool getCombinable (const OpticalDepth* Tau) const;
   void setParameters (Real TauStar, Real h);
+  void setTolerance (Real epsrel); // only matters for numerical
+  OpticalDepthBackend getBackend () const {return itsBackend;}
+  static const char* getBackendName (OpticalDepthBackend backend);
+  // Reports the backend in use (see Diagnostics.h): at info if the
+  // numerical one was selected automatically, otherwise at debug.
+  void reportBackend () const;
+  // For the OpticalDepth objects made after this; like FastMath, it is
+  // set for each model call.
+  static void setAutomatic (bool automatic) {isAutomatic = automatic; return;}
+  static bool getAutomatic () {return isAutomatic;}
  private:
   static const Real MINIMUM_VELOCITY; // scaled velocity at R*
+  static const size_t N_PROBE_U;
+  static const size_t N_PROBE_MU;
+  static const Real PROBE_U[];
+  static const Real PROBE_MU[];
+  static const Real PROBE_TOLERANCE;
+  static bool isAutomatic;
   bool isNumerical;
   bool isHeII;
+  bool isSelected; // the backend was selected automatically
+  Real itsBeta;
+  bool isAnisotropic;
+  bool isRosseland;
+  OpticalDepthBackend itsBackend;
+  string itsReason; // why a selected backend is numerical
   Velocity* itsVelocity;
   Porosity* itsPorosity;
   AnalyticOpticalDepth* itsAnalyticOpticalDepth;
   NumericalOpticalDepth* itsNumericalOpticalDepth;
+  TabulatedOpticalDepth* itsTabulatedOpticalDepth;
+  void selectBackend (Real TauStar, Real h);
+  bool verifyBackend ();
   // allocators and deallocators
   void allocateVelocity (Real beta);
   void allocatePorosity 
@@ -22,6 +22,7 @@
 
 #include "Porosity.h"
 #include <iostream>
+#include "FastMath.h"
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf_exp.h>
 
@@ -31,7 +32,7 @@ Porosity::Porosity
 (Real TauClump0, bool Anisotropic, bool Prolate, bool Rosseland)
   : itsTauClump0 (TauClump0), isAnisotropic (Anisotropic),
     isProlate (Prolate),
-    isRosseland (Rosseland), isPorous (false)
+    isRosseland (Rosseland), isPorous (false), isFastMath (getFastMath ())
 {
   checkInput ();
 }
@@ -104,6 +105,7 @@ Real Porosity::getPorosityFactor (Real u, Real mu)
 	TauClump /= mu;
       }
     } 
+    if (isFastMath) return fastExprel (-1. * TauClump);
     return gsl_sf_exprel (-1. * TauClump); // (1 - e^-t) / t
   }
 }
@@ -43,6 +43,7 @@ class Porosity {
   bool isProlate;
   bool isRosseland;
   bool isPorous;
+  bool isFastMath;
   Real getTauClump (Real u);
   void checkInput ();
 };
@@ -0,0 +1,190 @@
+/***************************************************************************
+    PrecisionSchedule.cpp   - Decides how much to loosen the accuracy goal
+                              of the windprof family during a fit, based on
+                              the size of the successive parameter steps.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "PrecisionSchedule.h"
+#include "mal_integration.h"
+#include <iostream>
+#include <gsl/gsl_math.h>
+
+using namespace std;
+
+// Largest loosening of the accuracy goal (1e-4 -> 1e-2 by default).
+const Real PrecisionSchedule::COARSE_FACTOR = 100.;
+
+// Steps between points at or below this give full precision; the
+// factor scales linearly with the step above this, up to COARSE_FACTOR.
+const Real PrecisionSchedule::FINE_STEP = 1.e-4;
+
+// A step larger than this is taken to start a new fit.
+const Real PrecisionSchedule::RESET_STEP = 0.3;
+
+// Each new point whose step does not tighten the factor divides it by
+// this. Near convergence the steps between points stop shrinking fast
+// enough, so without this a fit could end at a loose factor; with it,
+// the third point after COARSE_FACTOR (the trial step of the second
+// iteration of a fit) is at full precision.
+const Real PrecisionSchedule::STALL_RATIO = 10.;
+
+// Largest change of a parameter that is taken as a derivative (XSPEC
+// steps by about 1.e-2 of the parameter value).
+const Real PrecisionSchedule::DERIVATIVE_STEP = 0.05;
+
+PrecisionSchedule& PrecisionSchedule::instance ()
+{
+  static PrecisionSchedule precisionSchedule; // calls constructor
+  return precisionSchedule;
+}
+
+PrecisionSchedule::PrecisionSchedule ()
+  : itsMode (fullPrecision)
+{
+  return;
+}
+
+// Accepts full, progressive, coarse or reference (case insensitive).
+// Reference precision is switched on or off for all integrals here.
+void PrecisionSchedule::setMode (const string& mode)
+{
+  string m (mode);
+  for (size_t i = 0; i < m.size (); i++) m[i] = tolower (m[i]);
+  if (m == "full") {
+    itsMode = fullPrecision;
+  } else if (m == "progressive") {
+    itsMode = progressivePrecision;
+  } else if (m == "coarse") {
+    itsMode = coarsePrecision;
+  } else if (m == "reference") {
+    itsMode = referencePrecision;
+  } else {
+    cerr << "PrecisionSchedule: unknown mode " << mode 
+	 << "; using full precision.\n";
+    itsMode = fullPrecision;
+  }
+  Integral::setReference (itsMode == referencePrecision);
+  return;
+}
+
+Real PrecisionSchedule::getFactor 
+(const string& model, ConstRealSpan parameter)
+{
+  if ((itsMode == fullPrecision) || (itsMode == referencePrecision)) {
+    // forget the history, so that a later progressive fit starts coarse
+    itsFit.erase (model);
+    return 1.;
+  }
+  if (itsMode == coarsePrecision) return COARSE_FACTOR;
+  map<string, Fit>::iterator found = itsFit.find (model);
+  if ((found == itsFit.end ()) || 
+      (found->second.itsLastParameter.size () != parameter.size ())) {
+    // first call of a fit
+    Fit& fit = itsFit[model];
+    fit.itsLastParameter.resize (parameter.size ());
+    startPoint (fit, parameter);
+    fit.itsFactor = COARSE_FACTOR;
+    return COARSE_FACTOR;
+  }
+  Fit& fit = found->second;
+  Real step = getStep (fit.itsLastParameter, parameter);
+  for (size_t i = 0; i < parameter.size (); i++) {
+    fit.itsLastParameter[i] = parameter[i];
+  }
+  if (compare (step, 0.) == 0) {
+    // same parameters as the previous call: probably the final evaluation
+    fit.itsFactor = 1.;
+    return 1.;
+  }
+  if (compare (step, RESET_STEP) == 1) {
+    startPoint (fit, parameter);
+    fit.itsFactor = COARSE_FACTOR;
+    return COARSE_FACTOR;
+  }
+  if (isDerivative (fit, parameter)) return fit.itsFactor;
+  // A new point: only tighten, since the derivatives of the next points
+  // use steps of about the same size throughout the fit.
+  Real stepFactor = GSL_MAX_DBL (getStep (fit.itsPoint, parameter) / FINE_STEP,
+				 1.);
+  if (stepFactor < fit.itsFactor) {
+    fit.itsFactor = stepFactor;
+  } else {
+    fit.itsFactor = GSL_MAX_DBL (fit.itsFactor / STALL_RATIO, 1.);
+  }
+  startPoint (fit, parameter);
+  return fit.itsFactor;
+}
+
+Real PrecisionSchedule::getLastFactor (const string& model) const
+{
+  map<string, Fit>::const_iterator found = itsFit.find (model);
+  return (found == itsFit.end ()) ? 1. : found->second.itsFactor;
+}
+
+void PrecisionSchedule::startPoint (Fit& fit, ConstRealSpan parameter)
+{
+  fit.itsPoint.resize (parameter.size ());
+  for (size_t i = 0; i < parameter.size (); i++) {
+    fit.itsLastParameter[i] = parameter[i];
+    fit.itsPoint[i] = parameter[i];
+  }
+  fit.isVaried.assign (parameter.size (), false);
+  return;
+}
+
+/* A derivative changes one parameter of the point, by at most
+   DERIVATIVE_STEP, and one that no earlier derivative of the point has
+   changed. Anything else (e.g. the trial step of a fit with one free
+   parameter, which changes the same parameter again) is a new point.
+   A trial step that changes a single parameter the first time is taken
+   as a derivative, which only delays the tightening: the derivatives
+   around it then change two parameters of the point. */
+bool PrecisionSchedule::isDerivative (Fit& fit, ConstRealSpan parameter)
+{
+  size_t NChanged = 0;
+  size_t changed = 0;
+  for (size_t i = 0; i < parameter.size (); i++) {
+    if (parameter[i] != fit.itsPoint[i]) {
+      NChanged++;
+      changed = i;
+    }
+  }
+  if ((NChanged != 1) || fit.isVaried[changed]) return false;
+  Real scale = GSL_MAX_DBL (fabs (fit.itsPoint[changed]), 1.);
+  if (fabs (parameter[changed] - fit.itsPoint[changed]) / scale >
+      DERIVATIVE_STEP) {
+    return false;
+  }
+  fit.isVaried[changed] = true;
+  return true;
+}
+
+// Largest change of any parameter, relative to its size (or absolute 
+// for parameters smaller than 1, such as the shift or q near 0).
+Real PrecisionSchedule::getStep (const RealArray& p1, ConstRealSpan p2)
+{
+  Real step = 0.;
+  for (size_t i = 0; i < p1.size (); i++) {
+    Real scale = GSL_MAX_DBL (fabs (p1[i]), 1.);
+    step = GSL_MAX_DBL (step, fabs (p2[i] - p1[i]) / scale);
+  }
+  return step;
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+    PrecisionSchedule.h   - Decides how much to loosen the accuracy goal of
+                            the windprof family during a fit, based on the 
+                            size of the successive parameter steps.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef PRECISION_SCHEDULE_H
+#define PRECISION_SCHEDULE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Utilities.h"
+#include "Span.h"
+
+using namespace std;
+
+/*
+  Modes (set from the xset key WINDPROFPRECISION):
+  full        - always full precision (default). Use this before 
+                error, steppar, etc., and for the final fit.
+  progressive - the accuracy goal starts out loose by COARSE_FACTOR and 
+                tightens at each new point of the fit (a call that is
+                not a derivative of the last one), by STALL_RATIO or to
+                the size of the step if that is smaller, so that from
+                the third point of a fit on (the trial step of its
+                second iteration), every call is at full precision. The
+                derivatives of a point (calls that each change another
+                one of its parameters, by at most DERIVATIVE_STEP) get the
+                factor of the point, so that the differences are made
+                at one precision. The goal never loosens again during a
+                fit, except after a large jump in the parameters (e.g.
+                newpar), which is taken as the start of a new fit. A
+                repeated call with identical parameters is always done
+                at full precision.
+  coarse      - always loose by COARSE_FACTOR, for exploring.
+  reference   - every integral at Integral::REFERENCE_EPSREL, without
+                the tolerance budget or the fast approximations; very
+                slow, and only meant for checking the other modes.
+  The state is kept separately for each model name.
+*/
+
+enum PrecisionMode {fullPrecision, progressivePrecision, coarsePrecision,
+		    referencePrecision};
+
+// Singleton
+class PrecisionSchedule
+{
+ public:
+  static PrecisionSchedule& instance ();
+  void setMode (const string& mode);
+  PrecisionMode getMode () const {return itsMode;}
+  // Factor (>= 1) by which to multiply the accuracy goal for this call.
+  Real getFactor (const string& model, ConstRealSpan parameter);
+  // The factor of the last call for this model (1 if there is none in
+  // progressive mode), for checking the schedule.
+  Real getLastFactor (const string& model) const;
+ private:
+  PrecisionSchedule ();
+  static const Real COARSE_FACTOR;
+  static const Real FINE_STEP;
+  static const Real RESET_STEP;
+  static const Real STALL_RATIO;
+  static const Real DERIVATIVE_STEP;
+  // The fit of one model: the last call, the last point that was not a
+  // derivative, which parameters its derivatives have changed so far,
+  // and its factor.
+  struct Fit
+  {
+    RealArray itsLastParameter;
+    RealArray itsPoint;
+    vector<bool> isVaried;
+    Real itsFactor;
+  };
+  PrecisionMode itsMode;
+  map<string, Fit> itsFit;
+  void startPoint (Fit& fit, ConstRealSpan parameter);
+  bool isDerivative (Fit& fit, ConstRealSpan parameter);
+  Real getStep (const RealArray& p1, ConstRealSpan p2);
+  // To prevent copying and assignment:
+  PrecisionSchedule (const PrecisionSchedule& P);
+  PrecisionSchedule operator = (const PrecisionSchedule& P);
+};
+
+#endif//PRECISION_SCHEDULE_H
@@ -0,0 +1,399 @@
+/***************************************************************************
+    ProfileGrid.cpp - A grid of parameters of windprof, hwind or hewind,
+                      and the x bins their profiles are computed on, as
+                      used by the table models and the emulator.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <cmath>
+#include <iostream>
+#include <gsl/gsl_math.h>
+#include "ProfileGrid.h"
+#include "WindProfile.h"
+#include "ToleranceBudget.h"
+#include "Diagnostics.h"
+
+using namespace std;
+
+ProfileGrid::ProfileGrid ()
+  : itsModel (), itsModelType (general), itsNames (), itsBase (),
+    isApplied (), itsGrid (), itsX ()
+{
+  setXGrid (1.05, 400);
+  return;
+}
+
+bool ProfileGrid::getModelType (const string& model, ModelType& type)
+{
+  if (model == "windprof") {
+    type = general;
+  } else if (model == "hwind") {
+    type = hlike;
+  } else if (model == "hewind") {
+    type = helike;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ProfileGrid::setModel
+(const string& model, const vector<string>& names, ConstRealSpan base)
+{
+  ModelType type;
+  if (!getModelType (model, type)) {
+    cerr << "ProfileGrid: no profile grid for " << model << "\n";
+    return false;
+  }
+  if (names.size () != base.size ()) {
+    cerr << "ProfileGrid: " << names.size () << " names for "
+	 << base.size () << " parameters\n";
+    return false;
+  }
+  itsModel = model;
+  itsModelType = type;
+  itsNames = names;
+  itsBase.resize (base.size ());
+  for (size_t i = 0; i < base.size (); i++) itsBase[i] = base[i];
+  WindParameter W (base, type);
+  isApplied.assign (names.size (), false);
+  for (size_t i = 0; i < names.size (); i++) {
+    isApplied[i] = W.isMappingParameter (i) || (names[i] == "verbose") ||
+      (names[i] == "norm") || ((type == helike) && (names[i] == "G"));
+  }
+  itsGrid.clear ();
+  return true;
+}
+
+bool ProfileGrid::addGrid
+(const string& name, const RealArray& values, bool isLog)
+{
+  size_t index = 0;
+  while ((index < itsNames.size ()) && (itsNames[index] != name)) index++;
+  if (index == itsNames.size ()) {
+    cerr << "ProfileGrid: " << itsModel << " has no parameter "
+	 << name << "\n";
+    return false;
+  }
+  if (isApplied[index]) {
+    cerr << "ProfileGrid: " << name
+	 << " is applied at lookup, and is not on the grid\n";
+    return false;
+  }
+  if (values.size () == 0) {
+    cerr << "ProfileGrid: no values for " << name << "\n";
+    return false;
+  }
+  for (size_t i = 0; i < values.size (); i++) {
+    if ((i > 0) && (compare (values[i], values[i-1]) != 1)) {
+      cerr << "ProfileGrid: the values of " << name << " must increase\n";
+      return false;
+    }
+    if (isLog && (compare (values[i], 0.) != 1)) {
+      cerr << "ProfileGrid: logarithmic grid for " << name
+	   << " through " << values[i] << "\n";
+      return false;
+    }
+  }
+  Grid grid;
+  grid.itsName = name;
+  grid.itsIndex = index;
+  grid.itsValues.resize (values.size ());
+  grid.itsValues = values;
+  grid.isLog = isLog;
+  itsGrid.push_back (grid);
+  return true;
+}
+
+void ProfileGrid::setXGrid (Real xMaximum, size_t NBins)
+{
+  itsX.resize (NBins + 1);
+  for (size_t i = 0; i <= NBins; i++) {
+    itsX[i] = xMaximum * (2. * Real (i) / Real (NBins) - 1.);
+  }
+  return;
+}
+
+void ProfileGrid::setX (const RealArray& x)
+{
+  itsX.resize (x.size ());
+  itsX = x;
+  return;
+}
+
+size_t ProfileGrid::getNPoints () const
+{
+  size_t N = 1;
+  for (size_t k = 0; k < itsGrid.size (); k++) {
+    N *= itsGrid[k].itsValues.size ();
+  }
+  return N;
+}
+
+size_t ProfileGrid::getNComponents () const
+{
+  return WindProfile::getNumberOfComponents (itsModelType);
+}
+
+void ProfileGrid::getParameters (size_t point, RealArray& parameter) const
+{
+  parameter.resize (itsBase.size ());
+  parameter = itsBase;
+  for (size_t k = itsGrid.size (); k-- > 0; ) {
+    size_t N = itsGrid[k].itsValues.size ();
+    parameter[itsGrid[k].itsIndex] = itsGrid[k].itsValues[point % N];
+    point /= N;
+  }
+  return;
+}
+
+// The lower grid point of the cell around p, and where p is in the
+// cell (0 to 1).
+size_t ProfileGrid::getLower (size_t k, Real p, Real& fraction) const
+{
+  const RealArray& values = itsGrid[k].itsValues;
+  size_t N = values.size ();
+  fraction = 0.;
+  if (N == 1) return 0;
+  size_t j = BinarySearch (values, p);
+  if (j > N - 2) j = N - 2;
+  Real t = 0.;
+  if (itsGrid[k].isLog && (compare (p, 0.) == 1)) {
+    t = log (p / values[j]) / log (values[j+1] / values[j]);
+  } else {
+    t = (p - values[j]) / (values[j+1] - values[j]);
+  }
+  fraction = GSL_MAX_DBL (0., GSL_MIN_DBL (1., t));
+  return j;
+}
+
+/*
+   Multilinear interpolation between the 2^n grid points around the
+   parameters.
+*/
+void ProfileGrid::getCorners
+(ConstRealSpan parameter, vector<size_t>& point, vector<Real>& weight) const
+{
+  size_t NGrid = itsGrid.size ();
+  vector<size_t> lower (NGrid), stride (NGrid);
+  vector<Real> fraction (NGrid, 0.);
+  size_t s = 1;
+  for (size_t k = NGrid; k-- > 0; ) {
+    stride[k] = s;
+    s *= itsGrid[k].itsValues.size ();
+  }
+  for (size_t k = 0; k < NGrid; k++) {
+    const RealArray& values = itsGrid[k].itsValues;
+    Real p = parameter[itsGrid[k].itsIndex];
+    size_t N = values.size ();
+    if ((compare (p, values[0]) == -1) ||
+	(compare (p, values[N-1]) == 1)) {
+      DIAGNOSE (diagnosticWarning, "ProfileGrid::getCorners",
+		itsModel << " grid: " << itsGrid[k].itsName << " = " << p
+		<< " is outside [" << values[0] << ", " << values[N-1]
+		<< "]");
+    }
+    lower[k] = getLower (k, p, fraction[k]);
+  }
+  point.clear ();
+  weight.clear ();
+  for (size_t corner = 0; corner < (size_t (1) << NGrid); corner++) {
+    Real w = 1.;
+    size_t j = 0;
+    for (size_t k = 0; k < NGrid; k++) {
+      bool isUpper = (corner >> k) & 1;
+      if (isUpper && (itsGrid[k].itsValues.size () == 1)) {
+	w = 0.;
+	break;
+      }
+      w *= isUpper ? fraction[k] : 1. - fraction[k];
+      j += (lower[k] + (isUpper ? 1 : 0)) * stride[k];
+    }
+    if (w == 0.) continue;
+    point.push_back (j);
+    weight.push_back (w);
+  }
+  return;
+}
+
+bool ProfileGrid::isInside (ConstRealSpan parameter) const
+{
+  for (size_t k = 0; k < itsGrid.size (); k++) {
+    const RealArray& values = itsGrid[k].itsValues;
+    Real p = parameter[itsGrid[k].itsIndex];
+    if ((compare (p, values[0]) == -1) ||
+	(compare (p, values[values.size () - 1]) == 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The first parameter that is neither on the grid nor applied at
+// lookup, and differs from its value for the grid; or the number of
+// parameters if there is none.
+size_t ProfileGrid::findChangedParameter (ConstRealSpan parameter) const
+{
+  for (size_t i = 0; i < itsBase.size (); i++) {
+    if (isApplied[i]) continue;
+    bool isGrid = false;
+    for (size_t k = 0; k < itsGrid.size (); k++) {
+      if (itsGrid[k].itsIndex == i) isGrid = true;
+    }
+    if (!isGrid && compare (parameter[i], itsBase[i])) return i;
+  }
+  return itsBase.size ();
+}
+
+bool ProfileGrid::hasFixedParameters (ConstRealSpan parameter) const
+{
+  return (findChangedParameter (parameter) == itsBase.size ());
+}
+
+bool ProfileGrid::checkFixedParameters (ConstRealSpan parameter) const
+{
+  size_t i = findChangedParameter (parameter);
+  if (i == itsBase.size ()) return true;
+  DIAGNOSE (diagnosticWarning, "ProfileGrid::checkFixedParameters",
+	    itsModel << " grid: " << itsNames[i] << " = " << parameter[i]
+	    << ", but the grid was made with " << itsBase[i]);
+  return false;
+}
+
+size_t ProfileGrid::getNCells () const
+{
+  size_t N = 1;
+  for (size_t k = 0; k < itsGrid.size (); k++) {
+    N *= GSL_MAX (itsGrid[k].itsValues.size (), size_t (2)) - 1;
+  }
+  return N;
+}
+
+size_t ProfileGrid::getCell (ConstRealSpan parameter) const
+{
+  size_t cell = 0;
+  for (size_t k = 0; k < itsGrid.size (); k++) {
+    size_t N = GSL_MAX (itsGrid[k].itsValues.size (), size_t (2)) - 1;
+    Real fraction;
+    cell = cell * N + getLower (k, parameter[itsGrid[k].itsIndex], fraction);
+  }
+  return cell;
+}
+
+// The middle of the cell, in the log for a logarithmic grid.
+void ProfileGrid::getCellCentre (size_t cell, RealArray& parameter) const
+{
+  parameter.resize (itsBase.size ());
+  parameter = itsBase;
+  for (size_t k = itsGrid.size (); k-- > 0; ) {
+    const RealArray& values = itsGrid[k].itsValues;
+    size_t N = GSL_MAX (values.size (), size_t (2)) - 1;
+    size_t j = cell % N;
+    cell /= N;
+    Real p = values[0];
+    if (values.size () > 1) {
+      p = itsGrid[k].isLog ? sqrt (values[j] * values[j+1]) :
+	0.5 * (values[j] + values[j+1]);
+    }
+    parameter[itsGrid[k].itsIndex] = p;
+  }
+  return;
+}
+
+/* The energy grid only sets the number of bins here: each component is
+   integrated over its own x bins, from high to low x as for increasing
+   energy, and stored in increasing x. */
+void ProfileGrid::computeComponents
+(const RealArray& parameter, Real target, vector<RealArray>& component)
+  const
+{
+  size_t NBins = getNBins ();
+  WindParameter W (parameter, itsModelType);
+  RealArray x (NBins + 1), energy (NBins + 1);
+  for (size_t i = 0; i <= NBins; i++) {
+    x[i] = itsX[NBins - i];
+    energy[i] = W.getRestEnergy () / (1. + W.getVelocity () * x[i]);
+  }
+  WindProfile profile (energy, parameter, itsModelType);
+  profile.setTargetAccuracy (target);
+  component.resize (getNComponents ());
+  RealArray flux (NBins);
+  for (size_t c = 0; c < component.size (); c++) {
+    ToleranceBudget budget;
+    profile.setComponentBudget (c, x, budget);
+    profile.getComponentFlux (c, x, budget, 0, NBins, flux);
+    component[c].resize (NBins);
+    for (size_t i = 0; i < NBins; i++) component[c][i] = flux[NBins - 1 - i];
+  }
+  return;
+}
+
+/*
+   Each component is mapped from x onto the energy grid through its
+   cumulative flux (the flux is taken to be uniform within each x bin),
+   and the components are combined as in WindProfile::combineComponents.
+*/
+void ProfileGrid::mapComponents
+(const vector<RealArray>& component, ConstRealSpan energy,
+ ConstRealSpan parameter, RealSpan flux) const
+{
+  size_t NFlux = energy.size () - 1;
+  for (size_t i = 0; i < NFlux; i++) flux[i] = 0.;
+  WindParameter W (parameter, itsModelType);
+  Real v = W.getVelocity ();
+  Real G = (itsModelType == helike) ? W.getG () : 0.;
+  RealArray cumulative (itsX.size ());
+  for (size_t c = 0; c < component.size (); c++) {
+    Real RestEnergy =
+      W.getRestEnergy (WindProfile::getComponentType (itsModelType, c));
+    cumulative[0] = 0.;
+    for (size_t i = 1; i < itsX.size (); i++) {
+      cumulative[i] = cumulative[i-1] + component[c][i-1];
+    }
+    Real weight = (c == 0) ? 1. / (1. + G) : G / (1. + G);
+    Real previous =
+      getCumulative (cumulative, (RestEnergy / energy[0] - 1.) / v);
+    for (size_t i = 0; i < NFlux; i++) {
+      Real next =
+	getCumulative (cumulative, (RestEnergy / energy[i+1] - 1.) / v);
+      flux[i] += weight * (previous - next);
+      previous = next;
+    }
+  }
+  Real total = flux.sum ();
+  if (compare (total, 0.) == 1) {
+    for (size_t i = 0; i < NFlux; i++) flux[i] /= total;
+  } else {
+    DIAGNOSE (diagnosticWarning, "ProfileGrid::mapComponents",
+	      "Can't renormalize; total flux is zero.");
+  }
+  return;
+}
+
+// The cumulative flux at x, linear within each bin.
+Real ProfileGrid::getCumulative (const RealArray& cumulative, Real x) const
+{
+  size_t N = itsX.size ();
+  if (x <= itsX[0]) return 0.;
+  if (x >= itsX[N-1]) return cumulative[N-1];
+  size_t i = BinarySearch (itsX, x);
+  Real t = (x - itsX[i]) / (itsX[i+1] - itsX[i]);
+  return cumulative[i] + t * (cumulative[i+1] - cumulative[i]);
+}
@@ -0,0 +1,132 @@
+/***************************************************************************
+    ProfileGrid.h   - A grid of parameters of windprof, hwind or hewind,
+                      and the x bins their profiles are computed on, as
+                      used by the table models and the emulator.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef PROFILE_GRID_H
+#define PROFILE_GRID_H
+
+/*
+  The profile components (one for windprof and hwind; r, i and f for
+  hewind) only depend on the line position and the terminal velocity
+  through x = (E0 / E - 1) / v (see WindParameter::mapX). So they can
+  be computed once on bins in x, for every point of a grid of the other
+  parameters, and mapped onto the energy grid of a call with the
+  wavelength, shift and velocity of that call. G (hewind) only enters
+  the combination of the components, and the normalization is applied
+  by the caller, so these are not on the grid either. The other
+  parameters that are not on the grid must have the values the grid
+  was made with.
+
+  Between grid points the profiles are interpolated linearly, or in the
+  log of the parameter for a logarithmic grid, as in XSPEC. A cell is
+  the box between neighbouring grid points.
+*/
+
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+#include "WindParameter.h"
+
+using namespace std;
+
+class ProfileGrid
+{
+ public:
+  ProfileGrid ();
+  // windprof, hwind or hewind; false for any other model.
+  static bool getModelType (const string& model, ModelType& type);
+  // The parameters of the model in the order of lmodel.dat, with the
+  // normalization last (as the model gets them), and their values
+  // outside the grid.
+  bool setModel
+    (const string& model, const vector<string>& names, ConstRealSpan base);
+  // Fails for a parameter that is applied at lookup (see above), or
+  // for a logarithmic grid through values <= 0. The values must
+  // increase.
+  bool addGrid (const string& name, const RealArray& values, bool isLog);
+  // NBins bins of equal width from -xMaximum to xMaximum.
+  void setXGrid (Real xMaximum, size_t NBins);
+  // Any increasing bin edges.
+  void setX (const RealArray& x);
+  const string& getModelName () const {return itsModel;}
+  ModelType getModelType () const {return itsModelType;}
+  const vector<string>& getNames () const {return itsNames;}
+  const RealArray& getBase () const {return itsBase;}
+  size_t getNGrids () const {return itsGrid.size ();}
+  const string& getGridName (size_t k) const {return itsGrid[k].itsName;}
+  size_t getGridIndex (size_t k) const {return itsGrid[k].itsIndex;}
+  const RealArray& getGridValues (size_t k) const
+  {return itsGrid[k].itsValues;}
+  bool isGridLog (size_t k) const {return itsGrid[k].isLog;}
+  size_t getNPoints () const;
+  size_t getNBins () const {return itsX.size () - 1;}
+  size_t getNComponents () const;
+  const RealArray& getX () const {return itsX;}
+  // The parameters of a point of the grid; the last grid parameter
+  // changes fastest.
+  void getParameters (size_t point, RealArray& parameter) const;
+  // The grid points around the parameters and their interpolation
+  // weights; outside the grid the nearest values are used.
+  void getCorners (ConstRealSpan parameter, vector<size_t>& point,
+		   vector<Real>& weight) const;
+  bool isInside (ConstRealSpan parameter) const;
+  // False (with a warning) if a parameter that is not on the grid
+  // differs from its value for the grid.
+  bool checkFixedParameters (ConstRealSpan parameter) const;
+  // The same without the warning.
+  bool hasFixedParameters (ConstRealSpan parameter) const;
+  size_t getNCells () const;
+  size_t getCell (ConstRealSpan parameter) const;
+  void getCellCentre (size_t cell, RealArray& parameter) const;
+  // The components on the x bins, integrated as WindProfile does, with
+  // the accuracy goal target (see WindProfile::setTargetAccuracy).
+  void computeComponents
+    (const RealArray& parameter, Real target,
+     vector<RealArray>& component) const;
+  // Maps the components from the x bins onto the energy grid for the
+  // parameters of the call, combines them as WindProfile does, and
+  // renormalizes.
+  void mapComponents
+    (const vector<RealArray>& component, ConstRealSpan energy,
+     ConstRealSpan parameter, RealSpan flux) const;
+ private:
+  struct Grid {
+    string itsName;
+    size_t itsIndex; // in the model parameters
+    RealArray itsValues;
+    bool isLog;
+  };
+  string itsModel;
+  ModelType itsModelType;
+  vector<string> itsNames;
+  RealArray itsBase;
+  vector<bool> isApplied; // at lookup, not on the grid (see above)
+  vector<Grid> itsGrid;
+  RealArray itsX; // bin edges
+  size_t getLower (size_t k, Real p, Real& fraction) const;
+  size_t findChangedParameter (ConstRealSpan parameter) const;
+  Real getCumulative (const RealArray& cumulative, Real x) const;
+};
+
+#endif//PROFILE_GRID_H
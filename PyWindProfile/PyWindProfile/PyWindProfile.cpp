@@ -1,5 +1,6 @@
 /***************************************************************************
-    PyWindProfile.cpp   - Provides a python interface for Lx and OpticalDepth.
+    PyWindProfile.cpp   - Provides a python interface for Lx and OpticalDepth,
+                          and for the full windprof family of spectra.
 
                              -------------------
     begin				: Winter 2009
@@ -29,6 +30,14 @@
 #include "../../OpticalDepth.h"
 #include "../../Lx.h"
 #include "../../RAD_OpticalDepth.h"
+#include "../../FastMath.h"
+#include "../../WindProfile.h"
+#include "../../WindProfileBatch.h"
+#include "../../ThreadPool.h"
+#include "../../NParameters.h"
+#include "../../TableTransmission.h"
+#include "../../Span.h"
+#include <string.h>
 
 static PyObject* Py_OpticalDepth (PyObject* obj, PyObject* args)
 {
@@ -401,6 +410,425 @@ static PyObject* Py_Lx (PyObject* obj, PyObject* args)
   return NULL;
 }
 
+/*
+  Full spectra. These are the XSPEC models without XSPEC: the energy
+  grid is a numpy array of bin edges, and the flux (normalized to unit
+  total, as in XSPEC) is written directly into a numpy array. All
+  python objects are converted before the GIL is released, so the
+  model evaluation runs without it. The batch forms spread the rows of
+  a 2D parameter array over a pool of threads (see WindProfileBatch);
+  nothing is shared between threads but read-only grids and the
+  FastMath switch, which should be set beforehand.
+*/
+
+// The tolerance has the same meaning and default as WINDPROFTOLERANCE.
+static const Real DEFAULT_TOLERANCE = 1.e-4;
+
+static bool getModelType
+(const char* model, ModelType& type, size_t& NParameters)
+{
+  if (strcmp (model, "windprof") == 0) {
+    type = general;
+    NParameters = WINDPROF_N_PARAMETERS;
+  } else if (strcmp (model, "hwind") == 0) {
+    type = hlike;
+    NParameters = HWIND_N_PARAMETERS;
+  } else if (strcmp (model, "hewind") == 0) {
+    type = helike;
+    NParameters = HEWIND_N_PARAMETERS;
+  } else if (strcmp (model, "radwind") == 0) {
+    type = rad;
+    NParameters = RADWIND_N_PARAMETERS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* The parameter vectors are as in lmodel.dat; WindParameter also
+   expects the normalization at the end of each (as passed by XSPEC), so
+   it is appended if it was left out. It does not affect the normalized
+   profile. Returns the rows as WindProfile takes them. */
+static ConstRealSpan padParameters
+(ConstRealSpan parameter, size_t NRows, size_t NParameters, RealArray& padded)
+{
+  if (parameter.size () == NRows * (NParameters + 1)) return parameter;
+  padded.resize (NRows * (NParameters + 1), 1.);
+  for (size_t row = 0; row < NRows; row++) {
+    for (size_t i = 0; i < NParameters; i++) {
+      padded[row * (NParameters + 1) + i] = parameter[row * NParameters + i];
+    }
+  }
+  return ConstRealSpan (padded);
+}
+
+/* Returns a C-contiguous float64 output array of shape dims, either
+   newly allocated or the caller's array oOut, if it has that shape and
+   is writable. */
+static PyArrayObject* getOutputArray
+(PyObject* oOut, int ndim, npy_intp* dims, const char* name)
+{
+  if ((oOut == NULL) || (oOut == Py_None)) {
+    PyArray_Descr *descriptor = PyArray_DescrFromType (NPY_FLOAT64);
+    return (PyArrayObject*) PyArray_Zeros (ndim, dims, descriptor, 0);
+  }
+  if (!PyArray_Check (oOut) ||
+      (PyArray_TYPE ((PyArrayObject*) oOut) != NPY_FLOAT64) ||
+      !PyArray_IS_C_CONTIGUOUS ((PyArrayObject*) oOut) ||
+      !PyArray_ISWRITEABLE ((PyArrayObject*) oOut) ||
+      (PyArray_NDIM ((PyArrayObject*) oOut) != ndim)) {
+    PyErr_Format (PyExc_ValueError, "%s: out must be a writable, "
+		  "C-contiguous float64 array with %d dimensions.", name, ndim);
+    return NULL;
+  }
+  for (int d = 0; d < ndim; d++) {
+    if (PyArray_DIM ((PyArrayObject*) oOut, d) != dims[d]) {
+      PyErr_Format (PyExc_ValueError, "%s: out has the wrong shape.", name);
+      return NULL;
+    }
+  }
+  Py_INCREF (oOut);
+  return (PyArrayObject*) oOut;
+}
+
+static bool checkEnergy (PyArrayObject* energy, const char* name)
+{
+  if (PyArray_DIM (energy, 0) < 2) {
+    PyErr_Format (PyExc_ValueError,
+		  "%s: energy must have at least two bin edges.", name);
+    return false;
+  }
+  return true;
+}
+
+static PyObject* Py_Spectrum (PyObject* obj, PyObject* args)
+{
+  const char* model = NULL;
+  PyObject *oE = NULL, *oParameter = NULL, *oOut = NULL;
+  PyArrayObject *energy = NULL, *parameter = NULL, *flux = NULL;
+  Real tolerance = DEFAULT_TOLERANCE;
+  ModelType type = general;
+  size_t NParameters = 0;
+  npy_intp fsize = 0;
+  npy_intp psize = 0;
+
+  if (!PyArg_ParseTuple (args, "sOO|dO", &model, &oE, &oParameter,
+			 &tolerance, &oOut)) {
+    PyErr_SetString (PyExc_ValueError,
+		     "Spectrum: Invalid number of parameters.");
+    return NULL;
+  }
+  if (!getModelType (model, type, NParameters)) {
+    PyErr_Format (PyExc_ValueError, "Spectrum: unknown model %s "
+		  "(use windprof, hwind, hewind or radwind).", model);
+    return NULL;
+  }
+  energy = (PyArrayObject*) PyArray_ContiguousFromAny (oE, NPY_FLOAT64, 1, 1);
+  if (!energy || !checkEnergy (energy, "Spectrum")) goto _fail;
+  parameter = (PyArrayObject*) PyArray_ContiguousFromAny
+    (oParameter, NPY_FLOAT64, 1, 1);
+  if (!parameter) goto _fail;
+  psize = PyArray_DIM (parameter, 0);
+  if ((psize != (npy_intp) NParameters) &&
+      (psize != (npy_intp) NParameters + 1)) {
+    PyErr_Format (PyExc_ValueError, "Spectrum: %s takes %d parameters.",
+		  model, (int) NParameters);
+    goto _fail;
+  }
+  fsize = PyArray_DIM (energy, 0) - 1;
+  flux = getOutputArray (oOut, 1, &fsize, "Spectrum");
+  if (!flux) goto _fail;
+
+  { // braces protect the spans from goto
+    ConstRealSpan E ((Real*) PyArray_DATA (energy), fsize + 1);
+    ConstRealSpan P ((Real*) PyArray_DATA (parameter), psize);
+    RealSpan F ((Real*) PyArray_DATA (flux), fsize);
+    RealArray padded;
+    Py_BEGIN_ALLOW_THREADS
+    WindProfile W (E, padParameters (P, 1, NParameters, padded), type);
+    W.setTargetAccuracy (tolerance);
+    W.getModelFlux (F);
+    Py_END_ALLOW_THREADS
+  } // end protect braces
+  Py_DECREF (parameter);
+  Py_DECREF (energy);
+  return PyArray_Return (flux);
+ _fail:
+  Py_XDECREF (parameter);
+  Py_XDECREF (energy);
+  Py_XDECREF (flux);
+  return NULL;
+}
+
+static PyObject* Py_SpectrumBatch (PyObject* obj, PyObject* args)
+{
+  const char* model = NULL;
+  PyObject *oE = NULL, *oParameter = NULL, *oOut = NULL;
+  PyArrayObject *energy = NULL, *parameter = NULL, *flux = NULL;
+  Real tolerance = DEFAULT_TOLERANCE;
+  int nthreads = 0;
+  ModelType type = general;
+  size_t NParameters = 0;
+  npy_intp fdims[2] = {0, 0};
+  npy_intp psize = 0;
+
+  if (!PyArg_ParseTuple (args, "sOO|diO", &model, &oE, &oParameter,
+			 &tolerance, &nthreads, &oOut)) {
+    PyErr_SetString (PyExc_ValueError,
+		     "SpectrumBatch: Invalid number of parameters.");
+    return NULL;
+  }
+  if (!getModelType (model, type, NParameters)) {
+    PyErr_Format (PyExc_ValueError, "SpectrumBatch: unknown model %s "
+		  "(use windprof, hwind, hewind or radwind).", model);
+    return NULL;
+  }
+  energy = (PyArrayObject*) PyArray_ContiguousFromAny (oE, NPY_FLOAT64, 1, 1);
+  if (!energy || !checkEnergy (energy, "SpectrumBatch")) goto _fail;
+  parameter = (PyArrayObject*) PyArray_ContiguousFromAny
+    (oParameter, NPY_FLOAT64, 2, 2);
+  if (!parameter) goto _fail;
+  psize = PyArray_DIM (parameter, 1);
+  if ((psize != (npy_intp) NParameters) &&
+      (psize != (npy_intp) NParameters + 1)) {
+    PyErr_Format (PyExc_ValueError,
+		  "SpectrumBatch: %s takes %d parameters per row.",
+		  model, (int) NParameters);
+    goto _fail;
+  }
+  fdims[0] = PyArray_DIM (parameter, 0);
+  fdims[1] = PyArray_DIM (energy, 0) - 1;
+  flux = getOutputArray (oOut, 2, fdims, "SpectrumBatch");
+  if (!flux) goto _fail;
+
+  { // braces protect the spans from goto
+    size_t Nrows = (size_t) fdims[0];
+    size_t fsize = (size_t) fdims[1];
+    ConstRealSpan E ((Real*) PyArray_DATA (energy), fsize + 1);
+    ConstRealSpan P ((Real*) PyArray_DATA (parameter), Nrows * psize);
+    RealSpan F ((Real*) PyArray_DATA (flux), Nrows * fsize);
+    RealArray padded;
+    Py_BEGIN_ALLOW_THREADS
+    WindProfileBatch B (E, type, (nthreads > 0) ? (size_t) nthreads : 0);
+    B.setTargetAccuracy (tolerance);
+    B.getModelFlux (padParameters (P, Nrows, NParameters, padded), Nrows, F);
+    Py_END_ALLOW_THREADS
+  } // end protect braces
+  Py_DECREF (parameter);
+  Py_DECREF (energy);
+  return PyArray_Return (flux);
+ _fail:
+  Py_XDECREF (parameter);
+  Py_XDECREF (energy);
+  Py_XDECREF (flux);
+  return NULL;
+}
+
+static PyObject* Py_SpectrumStencil (PyObject* obj, PyObject* args)
+{
+  const char* model = NULL;
+  PyObject *oE = NULL, *oParameter = NULL, *oIndex = NULL, *oDelta = NULL;
+  PyObject *oOut = NULL;
+  PyArrayObject *energy = NULL, *parameter = NULL, *index = NULL;
+  PyArrayObject *delta = NULL, *flux = NULL;
+  Real tolerance = DEFAULT_TOLERANCE;
+  int nthreads = 0;
+  ModelType type = general;
+  size_t NParameters = 0;
+  npy_intp fdims[2] = {0, 0};
+  npy_intp psize = 0;
+  npy_intp NSteps = 0;
+
+  if (!PyArg_ParseTuple (args, "sOOOO|diO", &model, &oE, &oParameter,
+			 &oIndex, &oDelta, &tolerance, &nthreads, &oOut)) {
+    PyErr_SetString (PyExc_ValueError,
+		     "SpectrumStencil: Invalid number of parameters.");
+    return NULL;
+  }
+  if (!getModelType (model, type, NParameters)) {
+    PyErr_Format (PyExc_ValueError, "SpectrumStencil: unknown model %s "
+		  "(use windprof, hwind, hewind or radwind).", model);
+    return NULL;
+  }
+  energy = (PyArrayObject*) PyArray_ContiguousFromAny (oE, NPY_FLOAT64, 1, 1);
+  if (!energy || !checkEnergy (energy, "SpectrumStencil")) goto _fail;
+  parameter = (PyArrayObject*) PyArray_ContiguousFromAny
+    (oParameter, NPY_FLOAT64, 1, 1);
+  index = (PyArrayObject*) PyArray_ContiguousFromAny
+    (oIndex, NPY_INTP, 1, 1);
+  delta = (PyArrayObject*) PyArray_ContiguousFromAny
+    (oDelta, NPY_FLOAT64, 1, 1);
+  if (!parameter || !index || !delta) goto _fail;
+  psize = PyArray_DIM (parameter, 0);
+  if ((psize != (npy_intp) NParameters) &&
+      (psize != (npy_intp) NParameters + 1)) {
+    PyErr_Format (PyExc_ValueError, "SpectrumStencil: %s takes %d parameters.",
+		  model, (int) NParameters);
+    goto _fail;
+  }
+  NSteps = PyArray_DIM (index, 0);
+  if (PyArray_DIM (delta, 0) != NSteps) {
+    PyErr_SetString (PyExc_ValueError,
+		     "SpectrumStencil: index and delta differ in length.");
+    goto _fail;
+  }
+  for (npy_intp k = 0; k < NSteps; k++) {
+    npy_intp j = *((npy_intp*) PyArray_GETPTR1 (index, k));
+    if ((j < 0) || (j >= (npy_intp) NParameters)) {
+      PyErr_Format (PyExc_ValueError,
+		    "SpectrumStencil: parameter index %d out of range.", (int) j);
+      goto _fail;
+    }
+  }
+  fdims[0] = NSteps + 1;
+  fdims[1] = PyArray_DIM (energy, 0) - 1;
+  flux = getOutputArray (oOut, 2, fdims, "SpectrumStencil");
+  if (!flux) goto _fail;
+
+  { // braces protect the spans from goto
+    size_t fsize = (size_t) fdims[1];
+    ConstRealSpan E ((Real*) PyArray_DATA (energy), fsize + 1);
+    ConstRealSpan P ((Real*) PyArray_DATA (parameter), psize);
+    ConstRealSpan D ((Real*) PyArray_DATA (delta), NSteps);
+    RealSpan F ((Real*) PyArray_DATA (flux), fdims[0] * fsize);
+    vector<size_t> I (NSteps);
+    for (npy_intp k = 0; k < NSteps; k++) {
+      I[k] = (size_t) *((npy_intp*) PyArray_GETPTR1 (index, k));
+    }
+    RealArray padded;
+    Py_BEGIN_ALLOW_THREADS
+    WindProfileBatch B (E, type, (nthreads > 0) ? (size_t) nthreads : 0);
+    B.setTargetAccuracy (tolerance);
+    B.getStencilFlux (padParameters (P, 1, NParameters, padded), I, D, F);
+    Py_END_ALLOW_THREADS
+  } // end protect braces
+  Py_DECREF (delta);
+  Py_DECREF (index);
+  Py_DECREF (parameter);
+  Py_DECREF (energy);
+  return PyArray_Return (flux);
+ _fail:
+  Py_XDECREF (delta);
+  Py_XDECREF (index);
+  Py_XDECREF (parameter);
+  Py_XDECREF (energy);
+  Py_XDECREF (flux);
+  return NULL;
+}
+
+/* windtabs, with the tables passed in by the caller (e.g. read from the
+   FITS files with astropy) instead of loaded through xset. RhoRstar
+   may be a scalar, giving one spectrum, or a 1D array, giving one row
+   per value. */
+static PyObject* Py_Windtabs (PyObject* obj, PyObject* args)
+{
+  PyObject *oE = NULL, *oRho = NULL, *oKW = NULL, *oK = NULL, *oT = NULL,
+    *oTS = NULL, *oOut = NULL;
+  PyArrayObject *energy = NULL, *rho = NULL, *flux = NULL;
+  PyArrayObject *tables[4] = {NULL, NULL, NULL, NULL};
+  PyObject* oTables[4] = {NULL, NULL, NULL, NULL};
+  RealArray kappaWavelength, kappa, TauStar, Transmission;
+  RealArray* tableArrays[4] = {&kappaWavelength, &kappa, &TauStar,
+			       &Transmission};
+  int nthreads = 0;
+  int ndim = 0;
+  npy_intp fdims[2] = {0, 0};
+
+  if (!PyArg_ParseTuple (args, "OOOOOO|iO", &oE, &oRho, &oKW, &oK, &oTS, &oT,
+			 &nthreads, &oOut)) {
+    PyErr_SetString (PyExc_ValueError,
+		     "Windtabs: Invalid number of parameters.");
+    return NULL;
+  }
+  oTables[0] = oKW;
+  oTables[1] = oK;
+  oTables[2] = oTS;
+  oTables[3] = oT;
+  energy = (PyArrayObject*) PyArray_ContiguousFromAny (oE, NPY_FLOAT64, 1, 1);
+  if (!energy || !checkEnergy (energy, "Windtabs")) goto _fail;
+  rho = (PyArrayObject*) PyArray_ContiguousFromAny (oRho, NPY_FLOAT64, 0, 1);
+  if (!rho) goto _fail;
+  for (int t = 0; t < 4; t++) {
+    tables[t] = (PyArrayObject*) PyArray_ContiguousFromAny
+      (oTables[t], NPY_FLOAT64, 1, 1);
+    if (!tables[t] || (PyArray_DIM (tables[t], 0) < 1)) {
+      if (!PyErr_Occurred ()) {
+	PyErr_SetString (PyExc_ValueError, "Windtabs: empty table.");
+      }
+      goto _fail;
+    }
+    npy_intp tsize = PyArray_DIM (tables[t], 0);
+    tableArrays[t]->resize (tsize);
+    memcpy (&(*tableArrays[t])[0], PyArray_DATA (tables[t]),
+	    tsize * sizeof (Real));
+  }
+  if ((kappa.size () != kappaWavelength.size ()) ||
+      (Transmission.size () != TauStar.size ())) {
+    PyErr_SetString (PyExc_ValueError,
+		     "Windtabs: table columns have different sizes.");
+    goto _fail;
+  }
+  ndim = PyArray_NDIM (rho);
+  fdims[0] = (ndim == 1) ? PyArray_DIM (rho, 0) : 1;
+  fdims[1] = PyArray_DIM (energy, 0) - 1;
+  flux = getOutputArray (oOut, ndim + 1, fdims + 1 - ndim, "Windtabs");
+  if (!flux) goto _fail;
+
+  { // braces protect the spans from goto
+    size_t Nrows = (size_t) fdims[0];
+    size_t fsize = (size_t) fdims[1];
+    ConstRealSpan E ((Real*) PyArray_DATA (energy), fsize + 1);
+    const Real* R = (const Real*) PyArray_DATA (rho);
+    Real* F = (Real*) PyArray_DATA (flux);
+    Py_BEGIN_ALLOW_THREADS
+    ThreadPool pool ((nthreads > 0) ? (size_t) nthreads : 0);
+    pool.run (Nrows, [&] (size_t i, size_t /*worker*/) {
+	getTableTransmission (E, RealSpan (F + i * fsize, fsize), R[i],
+			      kappaWavelength, kappa, TauStar, Transmission);
+      });
+    Py_END_ALLOW_THREADS
+  } // end protect braces
+  for (int t = 0; t < 4; t++) Py_DECREF (tables[t]);
+  Py_DECREF (rho);
+  Py_DECREF (energy);
+  return PyArray_Return (flux);
+ _fail:
+  for (int t = 0; t < 4; t++) Py_XDECREF (tables[t]);
+  Py_XDECREF (rho);
+  Py_XDECREF (energy);
+  Py_XDECREF (flux);
+  return NULL;
+}
+
+// Select approximate (1) or libm/GSL (0) elementary functions for
+// objects constructed afterwards.
+static PyObject* Py_setFastMath (PyObject* obj, PyObject* args)
+{
+  int fast = 0;
+  if (!PyArg_ParseTuple (args, "i", &fast)) {
+    PyErr_SetString (PyExc_ValueError, 
+                     "setFastMath: Invalid number of parameters.");
+    return NULL;
+  }
+  setFastMath ((bool) fast);
+  Py_RETURN_NONE;
+}
+
+// Let a numerical optical depth be evaluated by a faster equivalent
+// (1; see OpticalDepth.h), or always integrate it (0), for objects
+// constructed afterwards.
+static PyObject* Py_setAutomaticOpticalDepth (PyObject* obj, PyObject* args)
+{
+  int automatic = 0;
+  if (!PyArg_ParseTuple (args, "i", &automatic)) {
+    PyErr_SetString (PyExc_ValueError, 
+                     "setAutomaticOpticalDepth: Invalid number of parameters.");
+    return NULL;
+  }
+  OpticalDepth::setAutomatic ((bool) automatic);
+  Py_RETURN_NONE;
+}
+
 static PyMethodDef PyWindProfileMethods[] = {
   {"OpticalDepth", Py_OpticalDepth, METH_VARARGS, "Calculate t(p,z), scalar"},
   {"OpticalDepth2d", Py_OpticalDepth2d, METH_VARARGS, "Calculate t(p,z), 2d"},
@@ -409,6 +837,18 @@ static PyMethodDef PyWindProfileMethods[] = {
   {"RAD_OpticalDepth_integrand", Py_RAD_OpticalDepth_integrand, METH_VARARGS,
    "Calculate RAD integrand (p,z0) on z array"},
   {"Lx", Py_Lx, METH_VARARGS, "Calculate Lx(x)"},
+  {"Spectrum", Py_Spectrum, METH_VARARGS,
+   "Calculate a windprof, hwind, hewind or radwind spectrum"},
+  {"SpectrumBatch", Py_SpectrumBatch, METH_VARARGS,
+   "Calculate one spectrum per parameter row, in parallel"},
+  {"SpectrumStencil", Py_SpectrumStencil, METH_VARARGS,
+   "Calculate a spectrum and its finite difference stencil"},
+  {"Windtabs", Py_Windtabs, METH_VARARGS,
+   "Calculate windtabs transmission from kappa and transmission tables"},
+  {"setFastMath", Py_setFastMath, METH_VARARGS, 
+   "Use approximate exp, log, pow and exprel (1) or libm/GSL (0)"},
+  {"setAutomaticOpticalDepth", Py_setAutomaticOpticalDepth, METH_VARARGS,
+   "Evaluate a numerical optical depth by a faster equivalent (1) or not (0)"},
   {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
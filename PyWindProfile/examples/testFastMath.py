@@ -0,0 +1,41 @@
+#!/usr/bin/env python
+from __future__ import print_function # for python 2 backwards compatibility
+
+# Checks that the approximate elementary functions (setFastMath (1))
+# reproduce the libm/GSL line profiles. Exits with an error if the
+# maximum deviation relative to the peak exceeds maxDeviation.
+
+import sys
+import numpy as np
+import PyWindProfile as wp
+
+maxDeviation = 1.e-8
+
+# set xgrid
+dx = 1.e-2
+x = np.arange (-1., 1.+0.1*dx, dx)
+
+# q, U0, beta, TauStar, h, Tau0Star, betaSobolev, isNumerical, isAnisotropic
+cases = [(0., 0.5, 1., 2., 0., 0., 0., 0, 0),
+         (0.3, 0.5, 1.7, 2., 0.5, 2., 0.5, 1, 0),
+         (-0.3, 0.6, 2., 1., 0., 0., 0., 1, 0),
+         (0., 0.5, 1., 2., 0.5, 0., 0., 0, 1),
+         (0., 0.5, 1.2, 5., 1., 10., 1., 1, 2)]
+
+worst = 0.
+for (q, U0, beta, TauStar, h, Tau0Star, betaSobolev, num, aniso) in cases:
+    flux = []
+    for fast in (0, 1):
+        wp.setFastMath (fast)
+        flux.append (wp.Lx\
+            (x, q, U0, 0., beta, TauStar, h, Tau0Star, betaSobolev, 0., \
+             0, num, aniso, 0, 0, 0))
+    wp.setFastMath (0)
+    deviation = np.max (np.abs (flux[1] - flux[0])) / np.max (flux[0])
+    print ('q = {}, beta = {}, TauStar = {}, h = {}, Tau0Star = {}: {:.3e}'\
+           .format (q, beta, TauStar, h, Tau0Star, deviation))
+    worst = max (worst, deviation)
+
+print ('maximum deviation {:.3e} (allowed {:.0e})'.format (worst, maxDeviation))
+if worst > maxDeviation:
+    sys.exit (1)
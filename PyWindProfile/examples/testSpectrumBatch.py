@@ -0,0 +1,40 @@
+#!/usr/bin/env python
+from __future__ import print_function # for python 2 backwards compatibility
+
+# Checks that SpectrumBatch reproduces Spectrum row by row, and compares
+# the time for a grid in q and TauStar. Exits with an error if any row
+# differs.
+
+import sys
+import time
+import numpy as np
+import PyWindProfile as wp
+
+# 300 bins around O VIII Ly alpha
+wavelength = 18.969
+energy = 12.3984193 / wavelength * (0.985 + 0.03 * np.arange (301) / 300.)
+
+# q TauStar U0 Umin h Tau0Star beta betaSobolev kappaRatio numerical
+# anisotropic rosseland expansion opticallyThick wavelength shift
+# vinfty verbose
+base = np.array ([0., 2., 0.5, 0., 0., 0., 1., 0., 0., 0., 0., 0., 0., 0.,
+                  wavelength, 0., 2000., 0.])
+q, TauStar = np.meshgrid (np.linspace (-0.5, 0.5, 8), np.linspace (0.1, 8., 8))
+parameters = np.tile (base, (q.size, 1))
+parameters[:,0] = q.ravel ()
+parameters[:,1] = TauStar.ravel ()
+
+start = time.time ()
+serial = np.array ([wp.Spectrum ('windprof', energy, p) for p in parameters])
+serialTime = time.time () - start
+
+flux = np.empty ((parameters.shape[0], energy.size - 1))
+start = time.time ()
+wp.SpectrumBatch ('windprof', energy, parameters, 1.e-4, 0, flux)
+batchTime = time.time () - start
+
+deviation = np.max (np.abs (flux - serial))
+print ('{} spectra: serial {:.2f} s, batch {:.2f} s, max deviation {:.3e}'\
+       .format (parameters.shape[0], serialTime, batchTime, deviation))
+if deviation > 0.:
+    sys.exit (1)
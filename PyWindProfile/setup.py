@@ -5,6 +5,7 @@ import numpy
 sourceFileList = ['PyWindProfile/PyWindProfile.cpp',\
                   '../Gaussian.cpp',\
                   '../Utilities.cpp',\
+                  '../FastMath.cpp',\
                   '../OpticalDepth.cpp',\
                   '../Porosity.cpp',\
                   '../AnalyticOpticalDepth.cpp',\
@@ -22,7 +23,18 @@ sourceFileList = ['PyWindProfile/PyWindProfile.cpp',\
                   '../ResonanceScattering.cpp',\
                   '../HeLikeRatio.cpp',\
                   '../mal_RootFinderNewton.cpp',\
-                  '../UxRoot.cpp']
+                  '../UxRoot.cpp',\
+                  '../AtomicParameters.cpp',\
+                  '../WindParameter.cpp',\
+                  '../FluxIntegral.cpp',\
+                  '../ToleranceBudget.cpp',\
+                  '../WindProfile.cpp',\
+                  '../TableTransmission.cpp',\
+                  '../TabulatedOpticalDepth.cpp',\
+                  '../ThreadPool.cpp',\
+                  '../WindProfileBatch.cpp',\
+                  '../IntegrationProfiler.cpp',\
+                  '../Diagnostics.cpp']
 
 libraryDirList = ['/opt/local/lib/']
 libraryNameList = ['gsl','gslcblas']
@@ -31,17 +31,29 @@ const Real RAD_OpticalDepth::LARGE_OPTICAL_DEPTH = 1.e6;
 
 const Real RAD_OpticalDepth::MU0 = 0.6;
 
+// Broader lines are integrated directly. The resonance is located to
+// a thousandth of the half width, so that the map, and so the optical
+// depth, varies smoothly from ray to ray.
+const Real RAD_OpticalDepth::NARROW_LINE = 0.1;
+const Real RAD_OpticalDepth::RESONANCE_TOLERANCE = 1.e-3;
+const size_t RAD_OpticalDepth::MAXIMUM_ITERATIONS = 100;
+// The line flux error measured with radwind was 0.75 Gamma / 2 over the
+// Doppler scale, at most.
+const Real RAD_OpticalDepth::SOBOLEV_ERROR = 1.;
+
 RAD_OpticalDepth::RAD_OpticalDepth (Velocity* V, Real DeltaE, Real Gamma,
 				    Real Tau0, Real Vinfty) :
   itsP (0.), itsZ0 (0.0), itsMu0 (0.0), itsU0 (0.0), itsW0 (0.0), itsWz0 (0.0),
   itsDeltaE (DeltaE), itsGamma (Gamma), itsTau0 (Tau0), itsVinfty (Vinfty),
-  isTransparent (false),
-  itsVelocity (V), itsRADODZ (NULL), itsRADODU (NULL)
+  isTransparent (false), isSobolev (false), isResonant (false),
+  itsZResonance (0.), itsResonanceWidth (0.), itsVelocity (V),
+  itsRADODZ (NULL), itsRADODU (NULL)
 
 {
   // need to check how vinfty, gamma, deltaE are passed to this function
   checkInput ();
   allocateRAD_OpticalDepthZU ();
+  checkSobolev (1.e-4); // the default tolerance of Integral
   return;
 }
 
@@ -67,6 +79,27 @@ void RAD_OpticalDepth::allocateRAD_OpticalDepthZU ()
   return;
 }
 
+void RAD_OpticalDepth::setTolerance (Real epsrel)
+{
+  itsRADODZ->setEpsRel (epsrel);
+  itsRADODU->setEpsRel (epsrel);
+  checkSobolev (epsrel);
+  return;
+}
+
+/* The Sobolev optical depth is used if its error estimate is within
+   the tolerance, and if some rays cross the resonance: it is in the
+   wind if 0 < -DeltaE / (1 - DeltaE) Vinfty < 2, the range of w mu. */
+void RAD_OpticalDepth::checkSobolev (Real epsrel)
+{
+  Real DopplerScale = (1. - itsDeltaE) * itsVinfty;
+  Real offset = -1. * itsDeltaE / DopplerScale;
+  isSobolev = !Integral::getReference () && (compare (itsGamma, 0.) == 1) &&
+    (compare (SOBOLEV_ERROR * itsGamma / 2., epsrel * DopplerScale) == -1) &&
+    (compare (offset, 0.) == 1) && (compare (offset, 2.) == -1);
+  return;
+}
+
 void RAD_OpticalDepth::freeRAD_OpticalDepthZU ()
 {
   delete itsRADODZ;
@@ -80,6 +113,8 @@ Real RAD_OpticalDepth::getOpticalDepth (Real p, Real z)
   if (isTransparent) return 0.;
 
   initialize (p, z);
+  findResonance ();
+  if (isSobolev && isResonant) return itsTau0 * getSobolevOpticalDepth ();
 
   Real t = 0.;
 
@@ -117,6 +152,75 @@ void RAD_OpticalDepth::initialize (Real p, Real z)
   return;
 }
 
+/* The resonance is where x = 0 in getPhi, i.e. w mu = wzres. Since
+   w mu increases along the ray, to 1 at infinity, it is bracketed by
+   z0 and infinity; it is found by the Illinois variant of false
+   position in atan (z), which keeps the bracket. */
+void RAD_OpticalDepth::findResonance ()
+{
+  isResonant = false;
+  Real halfWidth = itsGamma / 2.;
+  Real DopplerScale = (1. - itsDeltaE) * itsVinfty;
+  if ((compare (halfWidth, 0.) != 1) ||
+      (compare (halfWidth, NARROW_LINE * DopplerScale) != -1)) {
+    return;
+  }
+  Real wzres = itsWz0 - itsDeltaE / DopplerScale;
+  if ((compare (wzres, itsWz0) != 1) || (compare (wzres, 1.) != -1)) return;
+  Real tolerance = RESONANCE_TOLERANCE * halfWidth / DopplerScale;
+  Real low = atan (itsZ0);
+  Real high = M_PI_2;
+  Real fLow = itsWz0 - wzres;
+  Real fHigh = 1. - wzres;
+  int side = 0;
+  Real z = itsZ0;
+  for (size_t i = 0; i < MAXIMUM_ITERATIONS; i++) {
+    Real middle = (low * fHigh - high * fLow) / (fHigh - fLow);
+    z = tan (middle);
+    Real difference = getWz (z) - wzres;
+    if (fabs (difference) < tolerance) break;
+    if (difference < 0.) {
+      low = middle;
+      fLow = difference;
+      if (side == -1) fHigh /= 2.;
+      side = -1;
+    } else {
+      high = middle;
+      fHigh = difference;
+      if (side == 1) fLow /= 2.;
+      side = 1;
+    }
+  }
+  // the half width in z, from the local gradient of w mu
+  Real dz = 1.e-6 * GSL_MAX_DBL (1., fabs (z));
+  Real gradient = (getWz (z + dz) - getWz (z - dz)) / (2. * dz);
+  if (!(gradient > 0.)) return;
+  itsZResonance = z;
+  itsResonanceWidth = halfWidth / (DopplerScale * gradient);
+  isResonant = true;
+  return;
+}
+
+/* u^2 / w (the integrand of RAD_OpticalDepthZ without phi) over
+   dx / dz at the resonance, times the integral of phi over the range
+   of x along the ray, from DeltaE at z0 to its value where w mu = 1. */
+Real RAD_OpticalDepth::getSobolevOpticalDepth ()
+{
+  Real halfWidth = itsGamma / 2.;
+  Real DopplerScale = (1. - itsDeltaE) * itsVinfty;
+  Real u = uPZ (itsP, itsZResonance);
+  Real w = itsVelocity->getVelocity (u);
+  Real x0 = itsDeltaE / halfWidth;
+  Real x1 = (itsDeltaE + DopplerScale * (1. - itsWz0)) / halfWidth;
+  return u * u / w * itsResonanceWidth / halfWidth *
+    (atan (x1) - atan (x0)) / M_PI;
+}
+
+Real RAD_OpticalDepth::getWz (Real z)
+{
+  return itsVelocity->getVelocity (uPZ (itsP, z)) * muPZ (itsP, z);
+}
+
 // Lorentzian line profile used in both integrals
 Real RAD_OpticalDepth::getPhi (Real wz)
 {
@@ -126,9 +230,46 @@ Real RAD_OpticalDepth::getPhi (Real wz)
   return phi;
 }
 
+/*--------------------------RAD_MappedIntegral---------------------------*/
+
+const Real RAD_MappedIntegral::MAP_HALF_WIDTHS = 1000.;
+
+RAD_MappedIntegral::RAD_MappedIntegral ()
+  : Integral (), isMapped (false), itsCenter (0.), itsScale (1.)
+{
+  return;
+}
+
+double RAD_MappedIntegral::integrand (double x)
+{
+  if (!isMapped) return getIntegrand (x);
+  double t = tan (x);
+  return getIntegrand (itsCenter + itsScale * t) * itsScale * (1. + t * t);
+}
+
+Real RAD_MappedIntegral::integrate (Real a, Real b, Real center, Real scale)
+{
+  Real low = GSL_MIN_DBL (a, b);
+  Real high = GSL_MAX_DBL (a, b);
+  Real windowLow = GSL_MAX_DBL (low, center - MAP_HALF_WIDTHS * scale);
+  Real windowHigh = GSL_MIN_DBL (high, center + MAP_HALF_WIDTHS * scale);
+  isMapped = false;
+  if (!(windowLow < windowHigh)) return qag (a, b);
+  Real t = 0.;
+  if (low < windowLow) t += qag (low, windowLow);
+  if (windowHigh < high) t += qag (windowHigh, high);
+  isMapped = true;
+  itsCenter = center;
+  itsScale = scale;
+  t += qag (atan ((windowLow - center) / scale),
+	    atan ((windowHigh - center) / scale));
+  isMapped = false;
+  return (a < b) ? t : -1. * t;
+}
+
 /* allows exploring the behavior of the integrand in the dz integration
    using the python interface */
 double RAD_OpticalDepth::getZIntegrand (double z)
 {
-  return itsRADODZ->integrand (z);
+  return itsRADODZ->getIntegrand (z);
 }
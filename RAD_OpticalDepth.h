@@ -32,12 +32,36 @@
 
 class RAD_OpticalDepth;
 
-class RAD_OpticalDepthZ : public Integral {
+/* The integral of getIntegrand, with the arctan map about the
+   resonance (see RAD_OpticalDepth) within MAP_HALF_WIDTHS half widths
+   of it. Beyond that the map would crowd the Lorentzian wings (and
+   the curvature of x along the ray) against theta = +-pi/2, so the
+   rest of the range is integrated directly. */
+class RAD_MappedIntegral : public Integral {
+public:
+  RAD_MappedIntegral ();
+  virtual ~RAD_MappedIntegral () {return;}
+  double integrand (double x);
+  virtual double getIntegrand (double y) = 0; // not mapped
+protected:
+  // from a to b, mapped about center with half width scale
+  Real integrate (Real a, Real b, Real center, Real scale);
+private:
+  static const Real MAP_HALF_WIDTHS;
+  bool isMapped;
+  Real itsCenter;
+  Real itsScale;
+  // to prevent copying and assignment:
+  RAD_MappedIntegral (const RAD_MappedIntegral& A);
+  RAD_MappedIntegral operator = (const RAD_MappedIntegral& A);
+};
+
+class RAD_OpticalDepthZ : public RAD_MappedIntegral {
 public:
   RAD_OpticalDepthZ (RAD_OpticalDepth* A);
   ~RAD_OpticalDepthZ () {return;}
   Real getOpticalDepth (Real z1, Real z2);
-  double integrand (double z);
+  double getIntegrand (double z);
 private:
   RAD_OpticalDepth* itsRADOD;
   // to prevent copying and assignment:
@@ -45,36 +69,65 @@ private:
   RAD_OpticalDepthZ operator = (const RAD_OpticalDepthZ& A);
 };
 
-class RAD_OpticalDepthU : public Integral {
+class RAD_OpticalDepthU : public RAD_MappedIntegral {
 public:
   RAD_OpticalDepthU (RAD_OpticalDepth* A);
   ~RAD_OpticalDepthU () {return;}
   Real getOpticalDepth (Real z1, Real z2);
   Real getOpticalDepth (Real z);
-  double integrand (double z);
+  double getIntegrand (double u);
 private:
   bool isPositiveMu;
   RAD_OpticalDepth* itsRADOD;
+  bool getMapping (Real& center, Real& scale);
   // to prevent copying and assignment:
   RAD_OpticalDepthU (const RAD_OpticalDepthU & A);
   RAD_OpticalDepthU operator = (const RAD_OpticalDepthU& A);
 };
 
+/* If the line is narrow (Gamma / 2 < NARROW_LINE times the Doppler
+   scale (1 - DeltaE) Vinfty), the integrand is a spike where the ray
+   crosses the resonance. The projected velocity w mu increases
+   monotonically along the ray, so there is at most one resonance; it is
+   found by false position, and the integrals are done in the variable theta,
+   with z = zres + L tan (theta) (and likewise in u), where L is the
+   half width of the Lorentzian at the resonance. This is the arctan
+   map that makes the Lorentzian flat, so qag does not have to search
+   for the spike.
+
+   If the line is narrower still, so that the error of the Sobolev
+   approximation (about SOBOLEV_ERROR times Gamma / 2 over the Doppler
+   scale, relative, from the Lorentzian wings) is within the tolerance,
+   the optical depth of a ray that crosses the resonance is the Sobolev
+   one: u^2 / w over dx / dz at the resonance, times the fraction of
+   the Lorentzian that the ray spans. Rays that do not cross it only
+   see the wings, and are integrated. This is not used at reference
+   precision. */
 class RAD_OpticalDepth {
  public:
   RAD_OpticalDepth (Velocity* V, Real DeltaE, Real Gamma, Real Tau0,
 		    Real Vinfty); // constructor
   //~RAD_OpticalDepth (); // destructor
   Real getOpticalDepth (Real p, Real z);
+  void setTolerance (Real epsrel);
   Real getPhi (Real wz);
   Real getP () {return itsP;}
   Real getW (Real u) {return itsVelocity->getVelocity (u);}
   void initialize (Real p, Real z); // setup to manually call integrand
   // initialize is also called by getOpticalDepth
   double getZIntegrand (double z);
+  // the resonance on the current ray, if the line is narrow
+  bool getResonant () const {return isResonant;}
+  Real getResonanceZ () const {return itsZResonance;}
+  Real getResonanceWidth () const {return itsResonanceWidth;} // in z
+  bool getSobolev () const {return isSobolev;}
  private:
   static const Real LARGE_OPTICAL_DEPTH;
   static const Real MU0;
+  static const Real NARROW_LINE;
+  static const Real RESONANCE_TOLERANCE;
+  static const size_t MAXIMUM_ITERATIONS;
+  static const Real SOBOLEV_ERROR;
   Real itsP;
   Real itsZ0;
   Real itsMu0;
@@ -86,10 +139,18 @@ class RAD_OpticalDepth {
   Real itsTau0;
   Real itsVinfty; // in units of speed of light
   bool isTransparent;
+  bool isSobolev;
+  bool isResonant;
+  Real itsZResonance;
+  Real itsResonanceWidth;
   Velocity* itsVelocity;
   RAD_OpticalDepthZ* itsRADODZ;
   RAD_OpticalDepthU* itsRADODU;
   void checkInput ();
+  void checkSobolev (Real epsrel);
+  void findResonance ();
+  Real getSobolevOpticalDepth ();
+  Real getWz (Real z);
   void allocateRAD_OpticalDepthZU ();
   void freeRAD_OpticalDepthZU ();
   // To prevent copying and assignment:
@@ -24,9 +24,10 @@
 
 #include "RAD_OpticalDepth.h"
 #include "Utilities.h"
+#include <gsl/gsl_math.h>
 
 RAD_OpticalDepthU::RAD_OpticalDepthU (RAD_OpticalDepth* A)
-  : Integral (), isPositiveMu (true), itsRADOD (A)
+  : RAD_MappedIntegral (), isPositiveMu (true), itsRADOD (A)
 {
   return;
 }
@@ -36,7 +37,9 @@ Real RAD_OpticalDepthU::getOpticalDepth (Real z)
 {
   isPositiveMu = true;
   Real u = uPZ (itsRADOD->getP (), z);
-  return qag (0., u);
+  Real center, scale;
+  if (!getMapping (center, scale)) return qag (0., u);
+  return integrate (0., u, center, scale);
 }
 
 
@@ -46,10 +49,25 @@ Real RAD_OpticalDepthU::getOpticalDepth (Real z1, Real z2)
   isPositiveMu = false;
   Real u1 = uPZ (itsRADOD->getP (), z1);
   Real u2 = uPZ (itsRADOD->getP (), z2);
-  return qag (u2, u1);
+  Real center, scale;
+  if (!getMapping (center, scale)) return qag (u2, u1);
+  return integrate (u2, u1, center, scale);
 }
 
-double RAD_OpticalDepthU::integrand (double u)
+/* The map of RAD_OpticalDepthZ, in u, if the resonance is on this side
+   of z = 0. Its half width in u is |du/dz| = |z| u^3 times the one in z. */
+bool RAD_OpticalDepthU::getMapping (Real& center, Real& scale)
+{
+  if (!itsRADOD->getResonant ()) return false;
+  Real z = itsRADOD->getResonanceZ ();
+  if ((compare (z, 0.) == 1) != isPositiveMu) return false;
+  if (compare (z, 0.) == 0) return false;
+  center = uPZ (itsRADOD->getP (), z);
+  scale = itsRADOD->getResonanceWidth () * fabs (z) * gsl_pow_3 (center);
+  return (scale > 0.);
+}
+
+double RAD_OpticalDepthU::getIntegrand (double u)
 {
   double w = itsRADOD->getW (u);
   double mu = muPU (itsRADOD->getP (), u);
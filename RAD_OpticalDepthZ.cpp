@@ -25,7 +25,7 @@
 #include "RAD_OpticalDepth.h"
 
 RAD_OpticalDepthZ::RAD_OpticalDepthZ (RAD_OpticalDepth* A)
-  : Integral (), itsRADOD (A)
+  : RAD_MappedIntegral (), itsRADOD (A)
 {
   return;
 }
@@ -33,10 +33,12 @@ RAD_OpticalDepthZ::RAD_OpticalDepthZ (RAD_OpticalDepth* A)
 // z1 < z2
 Real RAD_OpticalDepthZ::getOpticalDepth (Real z1, Real z2)
 {
-  return qag (z1, z2);
+  if (!itsRADOD->getResonant ()) return qag (z1, z2);
+  return integrate (z1, z2, itsRADOD->getResonanceZ (),
+		    itsRADOD->getResonanceWidth ());
 }
 
-double RAD_OpticalDepthZ::integrand (double z)
+double RAD_OpticalDepthZ::getIntegrand (double z)
 {
   double u = uPZ (itsRADOD->getP (), z);
   double w = itsRADOD->getW (u);
@@ -26,15 +26,34 @@
 #include <complex>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf_exp.h>
+#include "FastMath.h"
 
 using namespace std;
 
+// The spline is accurate to about 1.e-6 relative for SPLINE_UMIN <= u <=
+// SPLINE_UMAX; the table extends beyond that so that the spline end 
+// conditions do not matter there. u0 <= 0.99, so u > SPLINE_UMAX is rare.
+const size_t ResonanceScattering::N_TABLE = 257;
+const Real ResonanceScattering::TABLE_UMIN = 1.e-7;
+const Real ResonanceScattering::TABLE_UMAX = 0.999;
+const Real ResonanceScattering::SPLINE_UMIN = 1.e-6;
+const Real ResonanceScattering::SPLINE_UMAX = 0.99;
+
 ResonanceScattering::ResonanceScattering
 (Real Tau0Star, Real BetaSobolev, bool OpticallyThick, Velocity* V) 
   : itsTau0Star (Tau0Star), itsBetaSobolev (BetaSobolev),
-    isOpticallyThick (OpticallyThick), isOpticallyThin (true), itsVelocity (V)
+    isOpticallyThick (OpticallyThick), isOpticallyThin (true), itsVelocity (V),
+    isFastMath (getFastMath ()), isTabulated (false), itsLogPAverage (NULL),
+    itsAccel (NULL)
 {
   checkInput ();
+  tabulatePAverage ();
+  return;
+}
+
+ResonanceScattering::~ResonanceScattering ()
+{
+  freeTable ();
   return;
 }
 
@@ -46,6 +65,7 @@ void ResonanceScattering::setParameters
   isOpticallyThick = OpticallyThick; 
   itsVelocity = V; 
   checkInput ();
+  tabulatePAverage ();
   return;
 }
 
@@ -69,23 +89,79 @@ void ResonanceScattering::checkInput ()
 Real ResonanceScattering::getEscapeProbability (Real u, Real mu)
 {
   if (isOpticallyThin) return 1.;
-  Real sigma = (itsBetaSobolev * u) / (1. - u) - 1.;
+  Real sigma = getSigma (u);
   Real AngleFactor = (1. + sigma * mu * mu);
   if (isOpticallyThick) {
     return (AngleFactor / (1. + sigma / 3.));
   }
-  Real w = itsVelocity->getVelocity (u);
-  Real Tau0 = itsTau0Star * u / (w * w);
+  Real Tau0 = getTau0 (u);
   if (compare (AngleFactor, 0.) != 1) {
     return 0.;
   }
   Real TauMu = -1. * Tau0 / AngleFactor;
+  Real PAverage;
+  if (isTabulated && (u >= SPLINE_UMIN) && (u <= SPLINE_UMAX)) {
+    PAverage = exp (gsl_spline_eval (itsLogPAverage, log (u / (1. - u)), 
+				     itsAccel));
+  } else if (isFastMath) {
+    PAverage = getPAverageFast (Tau0, sigma);
+  } else {
+    PAverage = getPAverage (Tau0, sigma);
+  }
+  if (isFastMath) return (fastExprel (TauMu) / PAverage);
   Real p = gsl_sf_exprel (TauMu);
   //  Real p = expm1 (TauMu) / TauMu; // 1 - e^-t / t
-  Real PAverage = getPAverage (Tau0, sigma);
   return (p / PAverage);
 }
 
+Real ResonanceScattering::getSigma (Real u)
+{
+  return (itsBetaSobolev * u) / (1. - u) - 1.;
+}
+
+Real ResonanceScattering::getTau0 (Real u)
+{
+  Real w = itsVelocity->getVelocity (u);
+  return itsTau0Star * u / (w * w);
+}
+
+/* Tabulates log <p> on a grid uniform in log (u / (1 - u)), which 
+   resolves both the rise of Tau0 at small u and the steep fall of <p>
+   towards the photosphere. If <p> is not positive and finite everywhere
+   (e.g. from cancellation at very large Tau0), the table is not used. */
+void ResonanceScattering::tabulatePAverage ()
+{
+  freeTable ();
+  if (isOpticallyThin || isOpticallyThick || (itsVelocity == NULL)) return;
+  Real vMin = log (TABLE_UMIN / (1. - TABLE_UMIN));
+  Real vMax = log (TABLE_UMAX / (1. - TABLE_UMAX));
+  Real dv = (vMax - vMin) / (N_TABLE - 1);
+  RealArray v (N_TABLE);
+  RealArray logPAverage (N_TABLE);
+  for (size_t i = 0; i < N_TABLE; i++) {
+    v[i] = vMin + dv * i;
+    Real u = 1. / (1. + exp (-1. * v[i]));
+    Real PAverage = getPAverage (getTau0 (u), getSigma (u));
+    if (!gsl_finite (PAverage) || (compare (PAverage, 0.) != 1)) return;
+    logPAverage[i] = log (PAverage);
+  }
+  itsLogPAverage = gsl_spline_alloc (gsl_interp_cspline, N_TABLE);
+  itsAccel = gsl_interp_accel_alloc ();
+  gsl_spline_init (itsLogPAverage, &v[0], &logPAverage[0], N_TABLE);
+  isTabulated = true;
+  return;
+}
+
+void ResonanceScattering::freeTable ()
+{
+  if (itsLogPAverage != NULL) gsl_spline_free (itsLogPAverage);
+  itsLogPAverage = NULL;
+  if (itsAccel != NULL) gsl_interp_accel_free (itsAccel);
+  itsAccel = NULL;
+  isTabulated = false;
+  return;
+}
+
 /* Castor, Radiation hydrodynamics, pp 128-129. */
 Real ResonanceScattering::getPAverage (Real Tau0, Real sigma)
 {
@@ -104,3 +180,40 @@ Real ResonanceScattering::getPAverage (Real Tau0, Real sigma)
   complex<Real> temp = rbz * ((tlog / (t * z * (sigma * 2.))) + 1.);
   return ((Real) (-2. * real (temp)));
 }
+
+/* Same as getPAverage, with the complex arithmetic written out in reals
+   (avoiding the complex division and csqrt/clog library calls) and 
+   fastLog for the modulus part of the logarithm. */
+Real ResonanceScattering::getPAverageFast (Real Tau0, Real sigma)
+{
+  const Real zr = -0.97515;
+  const Real zi = -1.193464;
+  const Real br = -0.5;
+  const Real bi = 0.01193391;
+  const Real z2 = zr * zr + zi * zi;
+  // a = Tau0 / z - 1
+  Real ar = Tau0 * zr / z2 - 1.;
+  Real ai = -1. * Tau0 * zi / z2;
+  if (compare (sigma, 0.) == 0) {
+    return (2. * (br * ar + bi * ai) / (ar * ar + ai * ai));
+  }
+  // t = sqrt (a / sigma), principal branch
+  Real cr = ar / sigma;
+  Real ci = ai / sigma;
+  Real modulus = hypot (cr, ci);
+  Real tr = sqrt (0.5 * (modulus + cr));
+  Real ti = sqrt (0.5 * (modulus - cr));
+  if (signbit (ci)) ti *= -1.;
+  // log ((t - 1) / (t + 1))
+  Real numerator2 = (tr - 1.) * (tr - 1.) + ti * ti;
+  Real denominator2 = (tr + 1.) * (tr + 1.) + ti * ti;
+  Real logr = 0.5 * (fastLog (numerator2) - fastLog (denominator2));
+  Real logi = atan2 (2. * ti, tr * tr + ti * ti - 1.);
+  // tlog / (t z 2 sigma)
+  Real dr = 2. * sigma * (tr * zr - ti * zi);
+  Real di = 2. * sigma * (tr * zi + ti * zr);
+  Real d2 = dr * dr + di * di;
+  Real qr = Tau0 * (logr * dr + logi * di) / d2;
+  Real qi = Tau0 * (logi * dr - logr * di) / d2;
+  return (-2. * (br * (qr + 1.) - bi * qi));
+}
@@ -24,10 +24,14 @@
 #ifndef RESONANCE_SCATTERING_H
 #define RESONANCE_SCATTERING_H
 
+#include <gsl/gsl_spline.h>
 #include "xsTypes.h"
 #include "Utilities.h"
 
-/* getEscapeProbability returns the normalized escape probability p / <p>. */
+/* getEscapeProbability returns the normalized escape probability p / <p>.
+   <p> depends only on u for a given set of parameters; it is tabulated
+   when the parameters are set, as a cubic spline of log <p> in
+   log (u / (1 - u)), and computed directly only outside the table. */
 class ResonanceScattering
 {
  public:
@@ -35,15 +39,33 @@ class ResonanceScattering
     (Real Tau0Star, Real BetaSobolev, bool OpticallyThick, Velocity* V);
   void setParameters 
     (Real Tau0Star, Real BetaSobolev, bool OpticallyThick, Velocity* V);
+  ~ResonanceScattering ();
   Real getEscapeProbability (Real u, Real mu);
  private:
+  static const size_t N_TABLE;
+  static const Real TABLE_UMIN;
+  static const Real TABLE_UMAX;
+  static const Real SPLINE_UMIN;
+  static const Real SPLINE_UMAX;
   Real itsTau0Star;
   Real itsBetaSobolev;
   bool isOpticallyThick;
   bool isOpticallyThin;
   Velocity* itsVelocity;
+  bool isFastMath;
+  bool isTabulated;
+  gsl_spline* itsLogPAverage;
+  gsl_interp_accel* itsAccel;
+  Real getTau0 (Real u);
+  Real getSigma (Real u);
   Real getPAverage (Real Tau0, Real sigma);
+  Real getPAverageFast (Real Tau0, Real sigma);
+  void tabulatePAverage ();
+  void freeTable ();
   void checkInput ();
+  // To prevent copying and assignment:
+  ResonanceScattering (const ResonanceScattering& R);
+  ResonanceScattering operator = (const ResonanceScattering& R);
 };
 
 #endif//RESONANCE_SCATTERING_H
@@ -0,0 +1,125 @@
+/***************************************************************************
+    ResponseMatrix.cpp - A precomputed response (effective area times
+                         redistribution) that folds a model flux into
+                         counts in the channels of a detector.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "ResponseMatrix.h"
+#include "Utilities.h"
+
+using namespace std;
+
+ResponseMatrix::ResponseMatrix ()
+  : itsEnergy (), itsNChannels (0), itsRow ()
+{
+  return;
+}
+
+void ResponseMatrix::setSize (const RealArray& energy, size_t NChannels)
+{
+  itsEnergy.resize (energy.size ());
+  itsEnergy = energy;
+  itsNChannels = NChannels;
+  Row empty;
+  empty.itsFirst = 0;
+  itsRow.assign ((energy.size () > 0) ? energy.size () - 1 : 0, empty);
+  return;
+}
+
+bool ResponseMatrix::setRow
+(size_t bin, size_t first, const RealArray& response)
+{
+  if ((bin >= itsRow.size ()) ||
+      (first + response.size () > itsNChannels)) {
+    cerr << "ResponseMatrix: energy bin " << bin << " responds beyond the "
+	 << itsNChannels << " channels\n";
+    return false;
+  }
+  itsRow[bin].itsFirst = first;
+  itsRow[bin].itsResponse.resize (response.size ());
+  itsRow[bin].itsResponse = response;
+  return true;
+}
+
+bool ResponseMatrix::read (const string& filename)
+{
+  ifstream file (filename.c_str ());
+  if (!file) {
+    cerr << "ResponseMatrix: cannot open " << filename << "\n";
+    return false;
+  }
+  string line;
+  size_t NBins = 0, NChannels = 0;
+  bool hasSize = false;
+  RealArray energy;
+  size_t bin = 0;
+  while (getline (file, line)) {
+    istringstream words (line);
+    string first;
+    if (!(words >> first) || (first[0] == '#')) continue;
+    words.str (line);
+    words.clear ();
+    if (!hasSize) {
+      if (!(words >> NBins >> NChannels) || (NBins == 0)) break;
+      energy.resize (NBins + 1);
+      setSize (energy, NChannels);
+      hasSize = true;
+      continue;
+    }
+    Real low, high;
+    size_t channel, N;
+    if ((bin >= NBins) || !(words >> low >> high >> channel >> N)) break;
+    if ((bin > 0) && compare (low, itsEnergy[bin])) {
+      cerr << "ResponseMatrix: the energy bins of " << filename
+	   << " are not contiguous at " << low << " keV\n";
+      return false;
+    }
+    RealArray response (N);
+    for (size_t i = 0; i < N; i++) {
+      if (!(words >> response[i])) break;
+    }
+    if (!words) break;
+    itsEnergy[bin] = low;
+    itsEnergy[bin + 1] = high;
+    if (!setRow (bin, channel, response)) return false;
+    bin++;
+  }
+  if (!hasSize || (bin != NBins)) {
+    cerr << "ResponseMatrix: cannot read " << filename << "\n";
+    return false;
+  }
+  return true;
+}
+
+void ResponseMatrix::fold (ConstRealSpan flux, RealSpan counts) const
+{
+  for (size_t c = 0; c < counts.size (); c++) counts[c] = 0.;
+  for (size_t bin = 0; bin < itsRow.size (); bin++) {
+    const Row& R = itsRow[bin];
+    for (size_t i = 0; i < R.itsResponse.size (); i++) {
+      counts[R.itsFirst + i] += flux[bin] * R.itsResponse[i];
+    }
+  }
+  return;
+}
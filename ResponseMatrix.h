@@ -0,0 +1,77 @@
+/***************************************************************************
+    ResponseMatrix.h - A precomputed response (effective area times
+                       redistribution) that folds a model flux into
+                       counts in the channels of a detector.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef RESPONSE_MATRIX_H
+#define RESPONSE_MATRIX_H
+
+/*
+  Each energy bin has one contiguous range of channels it responds in
+  (as a response matrix with one channel group per row, OGIP/92-002),
+  with the response in cm^2 counts per photon, so that folding a flux
+  in photons/cm^2/s per energy bin gives counts/s per channel.
+
+  The text file has the number of energy bins and of channels, then
+  one line for each energy bin (in order of increasing energy):
+
+  E_lo E_hi first_channel N r_1 ... r_N
+
+  with the energies in keV and the channels numbered from 0. Lines
+  starting with # are comments. The energy bins must be contiguous,
+  since the models are evaluated on the bin edges.
+*/
+
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+
+using namespace std;
+
+class ResponseMatrix
+{
+ public:
+  ResponseMatrix ();
+  bool read (const string& filename);
+  // The energy bin edges (one more than the number of bins).
+  const RealArray& getEnergy () const {return itsEnergy;}
+  size_t getNChannels () const {return itsNChannels;}
+  // For a response made in memory instead of read: the energy bin
+  // edges and number of channels (which clear the response), then the
+  // response of each energy bin, from channel first on.
+  void setSize (const RealArray& energy, size_t NChannels);
+  bool setRow (size_t bin, size_t first, const RealArray& response);
+  // counts (one per channel) = the flux (one per energy bin) folded
+  // through the response.
+  void fold (ConstRealSpan flux, RealSpan counts) const;
+ private:
+  struct Row {
+    size_t itsFirst;
+    RealArray itsResponse;
+  };
+  RealArray itsEnergy;
+  size_t itsNChannels;
+  vector<Row> itsRow;
+};
+
+#endif//RESPONSE_MATRIX_H
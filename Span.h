@@ -0,0 +1,64 @@
+/***************************************************************************
+    Span.h   - A non-owning view of a contiguous array, so that the model
+               cores can work directly on buffers owned by the caller
+               (XSPEC RealArrays, or the raw pointers passed by ISIS).
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include "xsTypes.h"
+
+/*
+  A span does not own its data, and must not outlive the array it was
+  made from. A Span<Real> converts to a Span<const Real>.
+*/
+template <typename T>
+class Span
+{
+ public:
+  Span () : itsData (0), itsSize (0) {}
+  Span (T* data, size_t size) : itsData (data), itsSize (size) {}
+  Span (RealArray& array)
+    : itsData (array.size () ? &array[0] : 0), itsSize (array.size ()) {}
+  Span (const RealArray& array)
+    : itsData (array.size () ? &array[0] : 0), itsSize (array.size ()) {}
+  template <typename U>
+  Span (const Span<U>& other) : itsData (other.data ()), itsSize (other.size ()) {}
+  T& operator[] (size_t i) const {return itsData[i];}
+  T* data () const {return itsData;}
+  size_t size () const {return itsSize;}
+  Real sum () const
+  {
+    Real total = 0.;
+    for (size_t i = 0; i < itsSize; i++) total += itsData[i];
+    return total;
+  }
+ private:
+  T* itsData;
+  size_t itsSize;
+};
+
+typedef Span<Real> RealSpan;
+typedef Span<const Real> ConstRealSpan;
+
+#endif//SPAN_H
@@ -0,0 +1,150 @@
+/***************************************************************************
+    windemulator.cpp - Trains the emulator of windprof, hwind or hewind
+                       (see WindProfileEmulator.h) on a table made by
+                       windtable, and validates it against WindProfile.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  See TableModel/README. The validation integrates the model at the
+  centre of every cell of the grid, as many integrations as the table
+  itself, so it is done in parallel like the table. The settings that
+  the table was made with (WINDPROFTOLERANCE, WINDPROFFASTMATH) should
+  be given again with --xset.
+*/
+
+#include "../Benchmark/ModelTable.h"
+#include "WindProfileTable.h"
+#include "WindProfileEmulator.h"
+#include "WindProfileConfig.h"
+#include "PrecisionSchedule.h"
+#include "FastMath.h"
+#include "OpticalDepth.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+static void usage ()
+{
+  cerr << "usage: windemulator --table FILE [options]\n"
+       << "  --table FILE          table made by windtable\n"
+       << "  --output FILE         emulator file (default FILE.emu)\n"
+       << "  --basis N             at most N basis vectors per component\n"
+       << "                        (default 20)\n"
+       << "  --truncation X        error of the basis at the grid points\n"
+       << "                        (default 1.e-4)\n"
+       << "  --threads N           default one per core\n"
+       << "  --xset KEY=VALUE      set a model setting (may be repeated)\n";
+  return;
+}
+
+// WINDPROFOPTICALDEPTH (see README.md)
+static bool isAutomaticOpticalDepth ()
+{
+  string backend = getConfigVariable ("WINDPROFOPTICALDEPTH", "SWITCH");
+  for (size_t i = 0; i < backend.size (); i++) {
+    backend[i] = toupper (backend[i]);
+  }
+  return (backend == "AUTO");
+}
+
+int main (int argc, char** argv)
+{
+  string tableFile, outputFile;
+  size_t maxBasis = 20;
+  Real truncation = 1.e-4;
+  size_t NThreads = 0;
+  for (int i = 1; i < argc; i++) {
+    string option (argv[i]);
+    if (i + 1 >= argc) {
+      usage ();
+      return 1;
+    }
+    string value (argv[++i]);
+    if (option == "--table") {
+      tableFile = value;
+    } else if (option == "--output") {
+      outputFile = value;
+    } else if (option == "--basis") {
+      maxBasis = atoi (value.c_str ());
+    } else if (option == "--truncation") {
+      truncation = atof (value.c_str ());
+    } else if (option == "--threads") {
+      NThreads = atoi (value.c_str ());
+    } else if (option == "--xset") {
+      if (!setXspecKey (value)) {
+	usage ();
+	return 1;
+      }
+    } else {
+      usage ();
+      return 1;
+    }
+  }
+  if (tableFile.empty () || (maxBasis < 1) || (truncation <= 0.)) {
+    usage ();
+    return 1;
+  }
+  if (outputFile.empty ()) outputFile = tableFile + ".emu";
+  WindProfileTable table;
+  if (!table.read (tableFile)) return 1;
+  size_t NPoints = table.getNPoints ();
+  size_t NComponents = table.getNComponents ();
+  vector<RealArray> spectrum (NPoints * NComponents);
+  for (size_t j = 0; j < NPoints; j++) {
+    for (size_t c = 0; c < NComponents; c++) {
+      spectrum[j * NComponents + c].resize
+	(table.getSpectrum (j, c).size ());
+      spectrum[j * NComponents + c] = table.getSpectrum (j, c);
+    }
+  }
+  WindProfileEmulator emulator;
+  if (!emulator.train (table, spectrum, maxBasis, truncation)) return 1;
+  cerr << "windemulator: " << table.getModelName () << ", " << NPoints
+       << " points, basis vectors";
+  for (size_t c = 0; c < NComponents; c++) {
+    cerr << " " << emulator.getNBasis (c);
+  }
+  cerr << ", truncation error " << emulator.getTruncationError () << "\n";
+
+  PrecisionSchedule& P = PrecisionSchedule::instance ();
+  P.setMode (getConfigVariable ("WINDPROFPRECISION", "FULL"));
+  bool isReference = (P.getMode () == referencePrecision);
+  setFastMath (!isReference &&
+	       (atoi (getConfigVariable ("WINDPROFFASTMATH", "0").c_str ())
+		== 1));
+  OpticalDepth::setAutomatic (!isReference && isAutomaticOpticalDepth ());
+  Real target = isReference ? 0. :
+    atof (getConfigVariable ("WINDPROFTOLERANCE", "1.e-4").c_str ());
+  cerr << "windemulator: validating " << emulator.getNCells ()
+       << " cells\n";
+  emulator.validate (target, NThreads);
+  vector<Real> error (emulator.getCellErrors ());
+  sort (error.begin (), error.end ());
+  cerr << "windemulator: cell errors from " << error[0] << " to "
+       << error[error.size () - 1] << ", median "
+       << error[error.size () / 2] << "\n";
+  if (!emulator.write (outputFile)) return 1;
+  cerr << "windemulator: wrote " << outputFile << "\n";
+  return 0;
+}
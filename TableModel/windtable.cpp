@@ -0,0 +1,346 @@
+/***************************************************************************
+    windtable.cpp   - Makes a table of windprof, hwind or hewind on a grid
+                      of their parameters (see WindProfileTable.h), with
+                      the grid points computed in parallel, and a
+                      checkpoint file to resume an interrupted run.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  See TableModel/README. Each grid point is one task for the thread
+  pool: its components are integrated over the x bins, as WindProfile
+  does for the model, and written to the checkpoint file as soon as
+  they are done. A run started again with the same table settings
+  skips the points already in the checkpoint. The table file is
+  written when every point is done, and the checkpoint is then removed.
+*/
+
+#include "../Benchmark/ModelTable.h"
+#include "WindProfileTable.h"
+#include "WindProfile.h"
+#include "WindProfileConfig.h"
+#include "PrecisionSchedule.h"
+#include "FastMath.h"
+#include "OpticalDepth.h"
+#include "ThreadPool.h"
+#include <cstdio>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+static void usage ()
+{
+  cerr << "usage: windtable --model NAME --param NAME=VALUES ... [options]\n"
+       << "  --model NAME          windprof, hwind or hewind\n"
+       << "  --param NAME=VALUES   a grid parameter (may be repeated), with\n"
+       << "                        VALUES v1,v2,... or lo:hi:n[:log]\n"
+       << "  --set NAME=VALUE      a parameter that is not on the grid\n"
+       << "                        (default: lmodel.dat; may be repeated)\n"
+       << "  --output FILE         table file (default MODEL.fits)\n"
+       << "  --checkpoint FILE     default FILE.checkpoint\n"
+       << "  --nx N                x bins (default 400)\n"
+       << "  --xmax X              x range -X to X (default 1.05)\n"
+       << "  --threads N           default one per core\n"
+       << "  --lmodel FILE         model definitions (default lmodel.dat)\n"
+       << "  --xset KEY=VALUE      set a model setting (may be repeated)\n";
+  return;
+}
+
+// v1,v2,... or lo:hi:n[:log]
+static bool readValues (const string& text, RealArray& values, bool& isLog)
+{
+  isLog = false;
+  vector<Real> v;
+  if (text.find (':') != string::npos) {
+    istringstream fields (text);
+    string lo, hi, n, scale;
+    getline (fields, lo, ':');
+    getline (fields, hi, ':');
+    getline (fields, n, ':');
+    getline (fields, scale, ':');
+    isLog = (scale == "log");
+    if ((!scale.empty () && !isLog) || (atoi (n.c_str ()) < 1)) return false;
+    Real low = atof (lo.c_str ());
+    Real high = atof (hi.c_str ());
+    size_t N = atoi (n.c_str ());
+    if (isLog && ((low <= 0.) || (high <= 0.))) return false;
+    for (size_t i = 0; i < N; i++) {
+      Real t = (N > 1) ? Real (i) / Real (N - 1) : 0.;
+      if (isLog) {
+	v.push_back (low * pow (high / low, t));
+      } else {
+	v.push_back (low + t * (high - low));
+      }
+    }
+  } else {
+    istringstream fields (text);
+    string value;
+    while (getline (fields, value, ',')) v.push_back (atof (value.c_str ()));
+  }
+  if (v.empty ()) return false;
+  values.resize (v.size ());
+  for (size_t i = 0; i < v.size (); i++) values[i] = v[i];
+  return true;
+}
+
+/* Everything the spectra depend on, as the first line of the
+   checkpoint, so that a checkpoint is only used for the same table. */
+static string getSignature
+(const WindProfileTable& table, const vector<string>& grids)
+{
+  ostringstream signature;
+  signature << setprecision (17) << "# windtable " << table.getModelName ();
+  RealArray base;
+  table.getParameters (0, base);
+  for (size_t i = 0; i < base.size (); i++) signature << " " << base[i];
+  for (size_t i = 0; i < grids.size (); i++) signature << " " << grids[i];
+  signature << " nx " << table.getNBins () << " xmax " << table.getX ()[0];
+  signature << " precision "
+	    << getConfigVariable ("WINDPROFPRECISION", "FULL")
+	    << " tolerance "
+	    << getConfigVariable ("WINDPROFTOLERANCE", "1.e-4")
+	    << " fastmath " << getConfigVariable ("WINDPROFFASTMATH", "0")
+	    << " opticaldepth "
+	    << getConfigVariable ("WINDPROFOPTICALDEPTH", "SWITCH");
+  return signature.str ();
+}
+
+/* Each line is a point and its components. A line cut short by an
+   interrupted run (one without its newline, or without exactly all of
+   its values) is skipped, and that point is done again. length is
+   where the last complete line ends, so that the run can cut off what
+   follows before appending to the file. */
+static bool readCheckpoint
+(const string& filename, const string& signature, WindProfileTable& table,
+ vector<bool>& isDone, streamoff& length)
+{
+  length = 0;
+  ifstream file (filename.c_str ());
+  if (!file) return true;
+  string line;
+  if (!getline (file, line) || file.eof ()) return true;
+  if (line != signature) {
+    cerr << "windtable: " << filename << " is the checkpoint of another "
+	 << "table; remove it, or give another --checkpoint\n";
+    return false;
+  }
+  size_t NComponents = table.getNComponents ();
+  size_t NBins = table.getNBins ();
+  length = file.tellg ();
+  while (getline (file, line) && !file.eof ()) {
+    length = file.tellg ();
+    istringstream values (line);
+    size_t point;
+    if (!(values >> point) || (point >= isDone.size ())) continue;
+    vector<RealArray> component (NComponents, RealArray (NBins));
+    bool isComplete = true;
+    for (size_t c = 0; c < NComponents && isComplete; c++) {
+      for (size_t i = 0; i < NBins; i++) {
+	if (!(values >> component[c][i])) {
+	  isComplete = false;
+	  break;
+	}
+      }
+    }
+    string extra;
+    if (!isComplete || (values >> extra)) continue;
+    for (size_t c = 0; c < NComponents; c++) {
+      table.setSpectrum (point, c, component[c]);
+    }
+    isDone[point] = true;
+  }
+  return true;
+}
+
+// WINDPROFOPTICALDEPTH (see README.md)
+static bool isAutomaticOpticalDepth ()
+{
+  string backend = getConfigVariable ("WINDPROFOPTICALDEPTH", "SWITCH");
+  for (size_t i = 0; i < backend.size (); i++) {
+    backend[i] = toupper (backend[i]);
+  }
+  return (backend == "AUTO");
+}
+
+int main (int argc, char** argv)
+{
+  string modelFile ("lmodel.dat");
+  string model, outputFile, checkpointFile, changes;
+  vector<string> grids;
+  size_t NBins = 400;
+  Real xMaximum = 1.05;
+  size_t NThreads = 0;
+  for (int i = 1; i < argc; i++) {
+    string option (argv[i]);
+    if (i + 1 >= argc) {
+      usage ();
+      return 1;
+    }
+    string value (argv[++i]);
+    if (option == "--model") {
+      model = value;
+    } else if (option == "--param") {
+      grids.push_back (value);
+    } else if (option == "--set") {
+      changes += " " + value;
+    } else if (option == "--output") {
+      outputFile = value;
+    } else if (option == "--checkpoint") {
+      checkpointFile = value;
+    } else if (option == "--nx") {
+      NBins = atoi (value.c_str ());
+    } else if (option == "--xmax") {
+      xMaximum = atof (value.c_str ());
+    } else if (option == "--threads") {
+      NThreads = atoi (value.c_str ());
+    } else if (option == "--lmodel") {
+      modelFile = value;
+    } else if (option == "--xset") {
+      if (!setXspecKey (value)) {
+	usage ();
+	return 1;
+      }
+    } else {
+      usage ();
+      return 1;
+    }
+  }
+  ModelType type;
+  if (!WindProfileTable::getModelType (model, type) || (NBins < 1) ||
+      (xMaximum <= 0.)) {
+    usage ();
+    return 1;
+  }
+  if (outputFile.empty ()) outputFile = model + ".fits";
+  if (checkpointFile.empty ()) checkpointFile = outputFile + ".checkpoint";
+
+  map<string, ParameterList> defaults;
+  if (!readModelFile (modelFile, defaults)) return 1;
+  if (defaults.find (model) == defaults.end ()) {
+    cerr << "windtable: " << model << " is not in " << modelFile << "\n";
+    return 1;
+  }
+  const ParameterList& list = defaults[model];
+  RealArray base;
+  if (!makeParameters (list, changes, base)) return 1;
+  vector<string> names;
+  for (size_t i = 0; i < list.size (); i++) names.push_back (list[i].first);
+
+  WindProfileTable table;
+  if (!table.setModel (model, names, base)) return 1;
+  table.setXGrid (xMaximum, NBins);
+  for (size_t k = 0; k < grids.size (); k++) {
+    size_t equals = grids[k].find ('=');
+    RealArray values;
+    bool isLog;
+    if ((equals == string::npos) ||
+	!readValues (grids[k].substr (equals + 1), values, isLog)) {
+      cerr << "windtable: cannot read --param " << grids[k] << "\n";
+      return 1;
+    }
+    if (!table.addGrid (grids[k].substr (0, equals), values, isLog)) return 1;
+  }
+
+  PrecisionSchedule& P = PrecisionSchedule::instance ();
+  P.setMode (getConfigVariable ("WINDPROFPRECISION", "FULL"));
+  bool isReference = (P.getMode () == referencePrecision);
+  setFastMath (!isReference &&
+	       (atoi (getConfigVariable ("WINDPROFFASTMATH", "0").c_str ())
+		== 1));
+  OpticalDepth::setAutomatic (!isReference && isAutomaticOpticalDepth ());
+  Real target = isReference ? 0. :
+    atof (getConfigVariable ("WINDPROFTOLERANCE", "1.e-4").c_str ());
+
+  size_t NPoints = table.getNPoints ();
+  vector<bool> isDone (NPoints, false);
+  string signature = getSignature (table, grids);
+  streamoff length;
+  if (!readCheckpoint (checkpointFile, signature, table, isDone, length)) {
+    return 1;
+  }
+  vector<size_t> remaining;
+  for (size_t j = 0; j < NPoints; j++) {
+    if (!isDone[j]) remaining.push_back (j);
+  }
+  cerr << "windtable: " << model << ", " << NPoints << " points, "
+       << NPoints - remaining.size () << " from " << checkpointFile << "\n";
+
+  ofstream checkpoint;
+  if (remaining.size () == NPoints) {
+    checkpoint.open (checkpointFile.c_str ());
+    checkpoint << signature << "\n";
+  } else {
+    // a line cut short would be glued to the next one
+    if (truncate (checkpointFile.c_str (), length) != 0) {
+      cerr << "windtable: cannot truncate " << checkpointFile << "\n";
+      return 1;
+    }
+    checkpoint.open (checkpointFile.c_str (), ios::app);
+  }
+  if (!checkpoint) {
+    cerr << "windtable: cannot write " << checkpointFile << "\n";
+    return 1;
+  }
+  checkpoint << setprecision (17);
+  checkpoint.flush ();
+
+  mutex lock;
+  size_t NDone = 0;
+  ThreadPool pool (NThreads);
+  pool.run (remaining.size (), [&] (size_t i, size_t) {
+      size_t point = remaining[i];
+      RealArray parameter;
+      table.getParameters (point, parameter);
+      vector<RealArray> component;
+      table.computeComponents (parameter, target, component);
+      ostringstream line;
+      line << setprecision (17) << point;
+      for (size_t c = 0; c < component.size (); c++) {
+	for (size_t b = 0; b < component[c].size (); b++) {
+	  line << " " << component[c][b];
+	}
+      }
+      lock_guard<mutex> guard (lock);
+      for (size_t c = 0; c < component.size (); c++) {
+	table.setSpectrum (point, c, component[c]);
+      }
+      checkpoint << line.str () << "\n";
+      checkpoint.flush ();
+      NDone++;
+      if ((NDone * 10 / remaining.size ()) !=
+	  ((NDone - 1) * 10 / remaining.size ())) {
+	cerr << "windtable: " << NDone << " of " << remaining.size ()
+	     << " points done\n";
+      }
+    });
+  checkpoint.close ();
+
+  if (!table.write (outputFile)) return 1;
+  remove (checkpointFile.c_str ());
+  cerr << "windtable: wrote " << outputFile << "\n";
+  return 0;
+}
@@ -0,0 +1,45 @@
+/***************************************************************************
+    TableTransmission.cpp - looks up the windtabs transmission on an
+                            energy grid from tabulated opacity and
+                            transmission.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "TableTransmission.h"
+#include "Utilities.h"
+#include <gsl/gsl_const_cgsm.h>
+
+static const Real CONST_HC_KEV_A = GSL_CONST_CGSM_PLANCKS_CONSTANT_H * 
+  GSL_CONST_CGSM_SPEED_OF_LIGHT * 1.e5 / GSL_CONST_CGSM_ELECTRON_VOLT;
+
+void getTableTransmission
+(ConstRealSpan energy, RealSpan flux, Real RhoRstar,
+ const RealArray& kappaWavelength, const RealArray& kappa,
+ const RealArray& TauStar, const RealArray& Transmission)
+{
+  size_t fluxSize = flux.size ();
+  for (size_t i = 0; i < fluxSize; i++) {
+    Real responseWavelength = 2. * CONST_HC_KEV_A / (energy[i] + energy[i+1]); 
+    size_t j = BinarySearch (kappaWavelength, responseWavelength);
+    size_t k = BinarySearch (TauStar, RhoRstar * kappa[j]);
+    flux[i] = Transmission[k];
+  }
+  return;
+}
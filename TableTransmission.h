@@ -0,0 +1,43 @@
+/***************************************************************************
+    TableTransmission.h - looks up the windtabs transmission on an energy
+                          grid from tabulated opacity and transmission.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef TABLE_TRANSMISSION_H
+#define TABLE_TRANSMISSION_H
+
+#include "xsTypes.h"
+#include "Span.h"
+
+/*
+  For each bin, kappa is taken at the wavelength of the bin center,
+  TauStar = RhoRstar * kappa, and the transmission is looked up in the
+  table of T (TauStar). Both tables are searched with BinarySearch, so
+  kappaWavelength and TauStar must be increasing. This is the windtabs
+  model without the FITS tables, so that it can also be called with
+  tables loaded elsewhere (e.g. from python).
+*/
+void getTableTransmission
+(ConstRealSpan energy, RealSpan flux, Real RhoRstar,
+ const RealArray& kappaWavelength, const RealArray& kappa,
+ const RealArray& TauStar, const RealArray& Transmission);
+
+#endif//TABLE_TRANSMISSION_H
@@ -0,0 +1,159 @@
+/***************************************************************************
+    TabulatedOpticalDepth.cpp - The optical depth of a smooth wind, by
+                                interpolation in a table made with
+                                NumericalOpticalDepth.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "TabulatedOpticalDepth.h"
+#include "NumericalOpticalDepth.h"
+#include "FastMath.h"
+#include <gsl/gsl_math.h>
+
+using namespace std;
+
+// The table extends beyond MAXIMUM_U so that the interpolation does not
+// use its one-sided end there. u0 <= 0.99, so only the rays passing
+// within about 1% of the stellar radius of the photosphere behind the
+// star are integrated.
+const size_t TabulatedOpticalDepth::N_S = 72;
+const size_t TabulatedOpticalDepth::N_M = 49;
+const Real TabulatedOpticalDepth::TABLE_U = 0.995;
+const Real TabulatedOpticalDepth::MAXIMUM_U = 0.99;
+const Real TabulatedOpticalDepth::TABLE_EPSREL = 1.e-8;
+const Real TabulatedOpticalDepth::LARGE_OPTICAL_DEPTH = 1.e6;
+const size_t TabulatedOpticalDepth::MAXIMUM_CACHED_TABLES = 8;
+
+mutex TabulatedOpticalDepth::theLock;
+vector<shared_ptr<const TabulatedOpticalDepth::Table> >
+TabulatedOpticalDepth::theTables;
+
+TabulatedOpticalDepth::TabulatedOpticalDepth
+(Real TauStar, Real beta, Real MinimumVelocity,
+ NumericalOpticalDepth* fallback)
+  : itsTauStar (TauStar), itsFallback (fallback),
+    itsTable (getTable (beta, MinimumVelocity))
+{
+  return;
+}
+
+Real TabulatedOpticalDepth::getOpticalDepth (Real p, Real z)
+{
+  if (badCoordinates (p, z)) return LARGE_OPTICAL_DEPTH;
+  if (compare (itsTauStar, 0.) != 1) return 0.;
+  Real u = uPZ (p, z);
+  if (compare (z, 0.) == -1) {
+    Real uMidplane = 1. / p;
+    if (uMidplane > MAXIMUM_U) return itsFallback->getOpticalDepth (p, z);
+    return itsTauStar *
+      (2. * interpolate (uMidplane, 0.) - interpolate (u, -1. * z * u));
+  }
+  if (u > MAXIMUM_U) return itsFallback->getOpticalDepth (p, z);
+  return itsTauStar * interpolate (u, z * u);
+}
+
+Real TabulatedOpticalDepth::interpolate (Real u, Real mu) const
+{
+  const Table& T = *itsTable;
+  Real s = -1. * log1p (-1. * u) / T.itsDS;
+  Real m = sqrt (mu) / T.itsDM;
+  size_t i = (size_t) GSL_MAX_INT ((int) floor (s) - 1, 0);
+  if (i > N_S - 4) i = N_S - 4;
+  size_t j = (size_t) GSL_MAX_INT ((int) floor (m) - 1, 0);
+  if (j > N_M - 4) j = N_M - 4;
+  // Lagrange weights on the nodes i ... i + 3 and j ... j + 3
+  Real a = s - i;
+  Real b = m - j;
+  Real wa[4] = {-1. * (a - 1.) * (a - 2.) * (a - 3.) / 6.,
+		a * (a - 2.) * (a - 3.) / 2.,
+		-1. * a * (a - 1.) * (a - 3.) / 2.,
+		a * (a - 1.) * (a - 2.) / 6.};
+  Real wb[4] = {-1. * (b - 1.) * (b - 2.) * (b - 3.) / 6.,
+		b * (b - 2.) * (b - 3.) / 2.,
+		-1. * b * (b - 1.) * (b - 3.) / 2.,
+		b * (b - 1.) * (b - 2.) / 6.};
+  Real logDepth = 0.;
+  for (size_t k = 0; k < 4; k++) {
+    const Real* row = &T.itsLogDepth[(i + k) * N_M + j];
+    logDepth += wa[k] *
+      (wb[0] * row[0] + wb[1] * row[1] + wb[2] * row[2] + wb[3] * row[3]);
+  }
+  return u * exp (logDepth);
+}
+
+shared_ptr<const TabulatedOpticalDepth::Table> TabulatedOpticalDepth::getTable
+(Real beta, Real MinimumVelocity)
+{
+  lock_guard<mutex> guard (theLock);
+  bool isFastMath = getFastMath ();
+  for (size_t k = 0; k < theTables.size (); k++) {
+    const Table& T = *theTables[k];
+    if ((T.itsBeta == beta) && (T.itsMinimumVelocity == MinimumVelocity) &&
+	(T.isFastMath == isFastMath)) {
+      return theTables[k];
+    }
+  }
+  // Made while holding the lock, since the other threads of a batch
+  // usually want the same table.
+  shared_ptr<const Table> table (makeTable (beta, MinimumVelocity));
+  if (!table) return table;
+  if (theTables.size () == MAXIMUM_CACHED_TABLES) {
+    theTables.erase (theTables.begin ());
+  }
+  theTables.push_back (table);
+  return table;
+}
+
+/* At u = 0 the wind is at terminal velocity, and tau / u is the
+   integral of 1 / r^2 along the ray, acos (mu) / sqrt (1 - mu^2). */
+shared_ptr<const TabulatedOpticalDepth::Table>
+TabulatedOpticalDepth::makeTable (Real beta, Real MinimumVelocity)
+{
+  shared_ptr<Table> table (new Table);
+  Table& T = *table;
+  T.itsBeta = beta;
+  T.itsMinimumVelocity = MinimumVelocity;
+  T.isFastMath = getFastMath ();
+  T.itsDS = -1. * log1p (-1. * TABLE_U) / (N_S - 1);
+  T.itsDM = 1. / (N_M - 1);
+  T.itsLogDepth.resize (N_S * N_M);
+  Velocity V (beta, MinimumVelocity);
+  NumericalOpticalDepth N (1., false, NULL, &V);
+  N.setTolerance (TABLE_EPSREL);
+  for (size_t i = 0; i < N_S; i++) {
+    Real u = -1. * expm1 (-1. * T.itsDS * i);
+    for (size_t j = 0; j < N_M; j++) {
+      Real m = T.itsDM * j;
+      Real mu = m * m;
+      Real nu = sqrt (1. - mu * mu);
+      Real depth;
+      if (i == 0) {
+	depth = (j == N_M - 1) ? 1. : acos (mu) / nu;
+      } else {
+	depth = N.getOpticalDepth (nu / u, mu / u) / u;
+      }
+      if (!gsl_finite (depth) || (compare (depth, 0.) != 1)) {
+	return shared_ptr<const Table> ();
+      }
+      T.itsLogDepth[i * N_M + j] = log (depth);
+    }
+  }
+  return table;
+}
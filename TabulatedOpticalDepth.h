@@ -0,0 +1,94 @@
+/***************************************************************************
+    TabulatedOpticalDepth.h - The optical depth of a smooth wind, by
+                              interpolation in a table made with
+                              NumericalOpticalDepth.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef TABULATED_OPTICAL_DEPTH_H
+#define TABULATED_OPTICAL_DEPTH_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "xsTypes.h"
+#include "Utilities.h"
+
+using namespace std;
+
+class NumericalOpticalDepth;
+
+/* Without porosity, the optical depth is TauStar times a function of
+   (p, z) that depends only on beta, so it can be tabulated once for
+   all TauStar. The table is of log (tau / (TauStar u)) for z >= 0, on
+   a grid uniform in -log (1 - u) and in sqrt (mu), which resolves the
+   steep rise near the photosphere; it is interpolated with 4 x 4 point
+   Lagrange polynomials, to about 1.e-5 relative. For z < 0 the
+   symmetry about z = 0 is used, as in NumericalOpticalDepth. Points
+   with u (or, for z < 0, 1 / p) above MAXIMUM_U are integrated by the
+   NumericalOpticalDepth given.
+
+   The tables are kept for the session (the last few of them), and
+   shared by all the TabulatedOpticalDepth objects with the same beta,
+   minimum velocity and FastMath setting. The He II optical depth is
+   not tabulated: its filter (see NumericalOpticalDepth::HeIIFilter)
+   switches off too sharply near u = 0.2 for this grid. */
+class TabulatedOpticalDepth
+{
+ public:
+  // fallback must be smooth (not porous), with the same TauStar.
+  TabulatedOpticalDepth (Real TauStar, Real beta, Real MinimumVelocity,
+			 NumericalOpticalDepth* fallback);
+  // False if the table could not be made (e.g. an integral was not
+  // positive and finite); it must not be used then.
+  bool isValid () const {return (bool) itsTable;}
+  void setTauStar (Real TauStar) {itsTauStar = TauStar; return;}
+  Real getOpticalDepth (Real p, Real z);
+ private:
+  static const size_t N_S;
+  static const size_t N_M;
+  static const Real TABLE_U;
+  static const Real MAXIMUM_U;
+  static const Real TABLE_EPSREL;
+  static const Real LARGE_OPTICAL_DEPTH;
+  static const size_t MAXIMUM_CACHED_TABLES;
+  struct Table {
+    Real itsBeta;
+    Real itsMinimumVelocity;
+    bool isFastMath;
+    Real itsDS;
+    Real itsDM;
+    vector<Real> itsLogDepth; // N_S x N_M, mu varying fastest
+  };
+  static mutex theLock;
+  static vector<shared_ptr<const Table> > theTables;
+  Real itsTauStar;
+  NumericalOpticalDepth* itsFallback;
+  shared_ptr<const Table> itsTable;
+  static shared_ptr<const Table> getTable (Real beta, Real MinimumVelocity);
+  static shared_ptr<const Table> makeTable (Real beta, Real MinimumVelocity);
+  // tau / TauStar for z >= 0 and u <= MAXIMUM_U
+  Real interpolate (Real u, Real mu) const;
+  // To prevent copying and assignment:
+  TabulatedOpticalDepth (const TabulatedOpticalDepth& T);
+  TabulatedOpticalDepth operator = (const TabulatedOpticalDepth& T);
+};
+
+#endif//TABULATED_OPTICAL_DEPTH_H
@@ -0,0 +1,400 @@
+/***************************************************************************
+    unittests.cpp        - checks the numerical kernels against the
+                           reference calculations they replace.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  Each check compares a fast kernel with the calculation it replaced, or
+  with a closed form, and prints one line; the program exits with 1 if
+  any check fails. See Tests/README.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <gsl/gsl_math.h>
+#include "xsTypes.h"
+#include "Span.h"
+#include "mal_integration.h"
+#include "calorimeterLSF.h"
+#include "LSFConvolution.h"
+#include "Gaussian.h"
+#include "MultiGaussian.h"
+#include "WindProfile.h"
+#include "WindProfileBatch.h"
+#include "NParameters.h"
+
+using namespace std;
+
+static size_t NFailures = 0;
+
+// Reports a check; deviation and limit are relative to the peak.
+static void report (const string& name, Real deviation, Real limit)
+{
+  bool isPassed = (deviation <= limit);
+  if (!isPassed) NFailures++;
+  cout << (isPassed ? "pass  " : "FAIL  ") << name << ": deviation "
+       << deviation << ", limit " << limit << "\n";
+  return;
+}
+
+// Largest absolute difference of two arrays, relative to the peak of a.
+static Real getDeviation (ConstRealSpan a, ConstRealSpan b)
+{
+  if (a.size () != b.size ()) return GSL_POSINF;
+  Real peak = 0.;
+  Real deviation = 0.;
+  for (size_t i = 0; i < a.size (); i++) {
+    peak = GSL_MAX_DBL (peak, fabs (a[i]));
+    deviation = GSL_MAX_DBL (deviation, fabs (a[i] - b[i]));
+  }
+  if (peak > 0.) deviation /= peak;
+  return deviation;
+}
+
+static void makeGrid (Real EMin, Real EMax, size_t NBins, RealArray& energy)
+{
+  energy.resize (NBins + 1);
+  for (size_t i = 0; i <= NBins; i++) {
+    energy[i] = EMin + (EMax - EMin) * i / NBins;
+  }
+  return;
+}
+
+/***************************/
+
+// u^q on [0,1], which is 1/(q+1)
+class PowerLaw : public Integral
+{
+ public:
+  PowerLaw (Real q) : itsQ (q) {}
+  double integrand (double u) {return pow (u, itsQ);}
+ private:
+  Real itsQ;
+};
+
+static void checkTanhSinh ()
+{
+  Real q[] = {-0.9, -0.5, 0., 0.5, 3.};
+  for (size_t i = 0; i < sizeof (q) / sizeof (Real); i++) {
+    PowerLaw P (q[i]);
+    P.setEpsRel (1.e-8);
+    Real exact = 1. / (q[i] + 1.);
+    Real answer = P.qts (0., 1.);
+    string name = "tanh-sinh u^" + to_string (q[i]);
+    if (P.getStatus ()) {
+      report (name + " (did not converge)", GSL_POSINF, 1.e-8);
+    } else {
+      report (name, fabs (answer - exact) / exact, 1.e-8);
+    }
+  }
+  return;
+}
+
+/***************************/
+
+/* The density of calorimeterLSF at deltaE, from the convolution of the
+   Gaussian with the tail and the flat continuum, which both stop at
+   deltaE; the original quadrature (electronLossContinuum) does not split
+   the integral there. */
+class LSFDensity : public Integral
+{
+ public:
+  LSFDensity (Real sigma, Real eTau, Real ratio, Real E0)
+    : itsSigma (sigma), itsETau (eTau), itsTailNorm (1. / (ratio + 1.)),
+      itsFlatNorm (ratio / (ratio + 1.) / E0), itsDeltaE (0.) {}
+  Real getDensity (Real deltaE)
+  {
+    itsDeltaE = deltaE;
+    Real bound = 12. * itsSigma;
+    if (deltaE < -1. * bound) return 0.;
+    return qag (-1. * bound, GSL_MIN_DBL (deltaE, bound), 6);
+  }
+  double integrand (double epsilon)
+  {
+    Real tail = itsTailNorm * exp ((epsilon - itsDeltaE) / itsETau) / itsETau;
+    Real x = epsilon / itsSigma;
+    return ((tail + itsFlatNorm) * exp (-0.5 * x * x)
+	    / (itsSigma * sqrt (2. * M_PI)));
+  }
+ private:
+  Real itsSigma;
+  Real itsETau;
+  Real itsTailNorm;
+  Real itsFlatNorm;
+  Real itsDeltaE;
+};
+
+class LSFBin : public Integral
+{
+ public:
+  LSFBin (LSFDensity& density) : itsDensity (density) {}
+  double integrand (double deltaE) {return itsDensity.getDensity (deltaE);}
+ private:
+  LSFDensity& itsDensity;
+};
+
+/* The closed form CDFs against a quadrature of the density, and against
+   the original nested quadrature (getLSFQuadrature), which only aims for
+   1.e-3 in each bin, and is off by about 1% of the peak in the bin next
+   to deltaE = 0 when sigma is close to etail. */
+static void checkCalorimeterLSF ()
+{
+  Real E0 = 1.;
+  Real sigma[] = {2.e-3, 5.e-3};
+  Real eTau[] = {1.5e-2, 5.e-3};
+  Real ratio[] = {1., 0.2};
+  RealArray energy;
+  makeGrid (0.9, 1.02, 240, energy);
+  RealArray deltaE (energy.size ());
+  deltaE = E0 - energy;
+  for (size_t k = 0; k < 2; k++) {
+    string name = "calorimeterLSF " + to_string (k);
+    calorimeterLSF CLSF (sigma[k], eTau[k], ratio[k], E0);
+    RealArray flux;
+    CLSF.getLSF (deltaE, flux);
+    LSFDensity density (sigma[k], eTau[k], ratio[k], E0);
+    density.setEpsRel (1.e-10);
+    LSFBin bin (density);
+    bin.setEpsRel (1.e-8);
+    RealArray reference (flux.size ());
+    RealArray quadrature (flux.size ());
+    for (size_t j = 0; j < flux.size (); j++) {
+      reference[j] = bin.qag (deltaE[j+1], deltaE[j], 6);
+      quadrature[j] = CLSF.getLSFQuadrature (deltaE[j], deltaE[j+1]);
+    }
+    report (name + " closed form", getDeviation (reference, flux), 1.e-7);
+    report (name + " getLSFQuadrature", getDeviation (quadrature, flux),
+	    2.e-2);
+    Real single = 0.;
+    for (size_t j = 0; j < flux.size (); j++) {
+      single = GSL_MAX_DBL
+	(single, fabs (CLSF.getLSF (deltaE[j], deltaE[j+1]) - flux[j]));
+    }
+    report (name + " single bins", single / flux.max (), 1.e-12);
+  }
+  return;
+}
+
+/***************************/
+
+/* The sum over source bins, with each source at its bin center, done
+   the slow way. */
+static void convolveSum (const RealArray& coordinate, LSFKernel& kernel,
+			 const RealArray& source, RealArray& flux)
+{
+  size_t fsize = source.size ();
+  flux.resize (fsize);
+  flux = 0.;
+  for (size_t i = 0; i < fsize; i++) {
+    Real center = 0.5 * (coordinate[i] + coordinate[i+1]);
+    for (size_t j = 0; j < fsize; j++) {
+      flux[j] += source[i] * (kernel.getCDF (coordinate[j+1] - center)
+			      - kernel.getCDF (coordinate[j] - center));
+    }
+  }
+  return;
+}
+
+/* A line and a continuum, on a uniform grid (FFT) and on a grid with
+   one edge moved (banded direct sum). */
+static void checkConvolution (const string& name, LSFKernel& kernel,
+			      Real EMin, Real EMax)
+{
+  size_t NBins = 600;
+  RealArray coordinate;
+  makeGrid (EMin, EMax, NBins, coordinate);
+  RealArray source (NBins);
+  for (size_t i = 0; i < NBins; i++) {
+    source[i] = 1.e-3 * (1. + i / (Real) NBins);
+  }
+  source[NBins / 2] += 1.;
+  for (size_t grid = 0; grid < 2; grid++) {
+    if (grid == 1) {
+      coordinate[NBins / 3] += 1.e-3 * (coordinate[1] - coordinate[0]);
+    }
+    RealArray key (1, 0.);
+    LSFConvolution C;
+    RealArray flux (source);
+    C.convolve (coordinate, kernel, key, flux);
+    RealArray expected;
+    convolveSum (coordinate, kernel, source, expected);
+    string method = C.getUniform () ? " FFT" : " direct";
+    if (C.getUniform () != (grid == 0)) {
+      report (name + method + " (wrong method)", GSL_POSINF, 0.);
+      continue;
+    }
+    report (name + method, getDeviation (expected, flux), 2.e-4);
+  }
+  return;
+}
+
+static void checkConvolutions ()
+{
+  GratingKernel grating (2.e-3, 1.e-3, 3.e-3, 0.8, 1.);
+  checkConvolution ("gratpr2 kernel", grating, 15., 15.6);
+  CalorimeterKernel calorimeter (2.e-3, 1.5e-2, 0.98, 0.01);
+  checkConvolution ("sxsconv kernel", calorimeter, 0.9, 1.02);
+  return;
+}
+
+/***************************/
+
+/* MultiGaussian against a weighted sum of Gaussians: resolved,
+   unresolved, partly off the grid and outside it. */
+static void checkMultiGaussian ()
+{
+  RealArray energy;
+  makeGrid (0.5, 0.7, 400, energy);
+  Real E[] = {0.55, 0.5523, 0.6, 0.62, 0.695, 0.8};
+  Real SigmaC[] = {1.e-3, 5.e-3, 0., 2.e-3, 1.e-2, 1.e-3};
+  Real Weight[] = {1., 0.5, 0.3, 2., 0.7, 1.};
+  MultiGaussian M (energy);
+  RealArray expected (energy.size () - 1);
+  expected = 0.;
+  for (size_t k = 0; k < sizeof (E) / sizeof (Real); k++) {
+    M.addLine (E[k], SigmaC[k], Weight[k]);
+    Gaussian G (energy, E[k], SigmaC[k]);
+    RealArray gflux (energy.size () - 1);
+    G.getFlux (gflux);
+    expected += Weight[k] * gflux;
+  }
+  RealArray flux (energy.size () - 1);
+  M.getFlux (flux);
+  report ("MultiGaussian", getDeviation (expected, flux), 1.e-12);
+  return;
+}
+
+/***************************/
+
+static void setParameters (ModelType type, RealArray& parameter)
+{
+  if (type == helike) {
+    // hewind, Z = 12; the last one is the norm
+    Real p[] = {0.5, 2., 0.5, 0., 0., 0., 1., 0., 0.7, 0.,
+		0., 0., 0., 0., 0., 12., 0., 2485., 131., 1.e11, 0., 1.};
+    parameter.resize (HEWIND_N_PARAMETERS + 1);
+    for (size_t i = 0; i < parameter.size (); i++) parameter[i] = p[i];
+  } else {
+    Real p[] = {0.5, 2., 0.5, 0., 0., 0., 1., 0., 0.,
+		0., 0., 0., 0., 0., 24.781, 0., 2485., 0., 1.};
+    parameter.resize (WINDPROF_N_PARAMETERS + 1);
+    for (size_t i = 0; i < parameter.size (); i++) parameter[i] = p[i];
+  }
+  return;
+}
+
+static void getSeparateFlux (const RealArray& energy,
+			     const RealArray& parameter, ModelType type,
+			     RealArray& flux)
+{
+  flux.resize (energy.size () - 1);
+  WindProfile W (energy, parameter, type);
+  W.setTargetAccuracy (0.);
+  W.getModelFlux (flux);
+  return;
+}
+
+/* Several rows of a batch, and the rows of a stencil, against separate
+   WindProfile runs with a fixed epsrel (a stencil shares the tolerance
+   budget of its base point): identical, except for the rows of a stencil
+   that only shift the line, which are integrated from the bin edges, and
+   differ from a separate run by the integration error of its bins. */
+static void checkBatch (const string& name, ModelType type,
+			Real EMin, Real EMax, size_t ShiftIndex)
+{
+  RealArray energy;
+  makeGrid (EMin, EMax, 300, energy);
+  size_t fsize = energy.size () - 1;
+  RealArray base;
+  setParameters (type, base);
+  size_t NParameters = base.size ();
+  vector<size_t> index;
+  index.push_back (0); // q
+  index.push_back (1); // taustar
+  index.push_back (ShiftIndex); // shift
+  index.push_back (ShiftIndex + 1); // velocity
+  RealArray delta (index.size ());
+  delta[0] = 0.01;
+  delta[1] = 0.05;
+  delta[2] = 0.05;
+  delta[3] = 2.;
+  size_t NRows = index.size () + 1;
+  RealArray parameter (NRows * NParameters);
+  for (size_t row = 0; row < NRows; row++) {
+    for (size_t i = 0; i < NParameters; i++) {
+      parameter[row * NParameters + i] = base[i];
+    }
+    if (row > 0) parameter[row * NParameters + index[row-1]] += delta[row-1];
+  }
+  vector<RealArray> separate (NRows);
+  for (size_t row = 0; row < NRows; row++) {
+    RealArray p (base);
+    if (row > 0) p[index[row-1]] += delta[row-1];
+    getSeparateFlux (energy, p, type, separate[row]);
+  }
+  size_t NThreads[] = {1, 4};
+  for (size_t t = 0; t < 2; t++) {
+    string threads = " (" + to_string (NThreads[t]) + " threads)";
+    WindProfileBatch B (energy, type, NThreads[t]);
+    B.setTargetAccuracy (0.);
+    RealArray flux;
+    B.getModelFlux (parameter, NRows, flux);
+    Real deviation = 0.;
+    for (size_t row = 0; row < NRows; row++) {
+      ConstRealSpan F (&flux[row * fsize], fsize);
+      deviation = GSL_MAX_DBL (deviation, getDeviation (separate[row], F));
+    }
+    report (name + " batch" + threads, deviation, 0.);
+    B.getStencilFlux (base, index, delta, flux);
+    deviation = 0.;
+    Real shifted = 0.;
+    for (size_t row = 0; row < NRows; row++) {
+      ConstRealSpan F (&flux[row * fsize], fsize);
+      if ((row > 0) && (index[row-1] >= ShiftIndex)) {
+	shifted = GSL_MAX_DBL (shifted, getDeviation (separate[row], F));
+      } else {
+	deviation = GSL_MAX_DBL (deviation, getDeviation (separate[row], F));
+      }
+    }
+    report (name + " stencil" + threads, deviation, 0.);
+    report (name + " shifted stencil" + threads, shifted, 1.e-6);
+  }
+  return;
+}
+
+/***************************/
+
+int main ()
+{
+  checkTanhSinh ();
+  checkCalorimeterLSF ();
+  checkConvolutions ();
+  checkMultiGaussian ();
+  checkBatch ("windprof", general, 0.495, 0.506, 15);
+  checkBatch ("hewind", helike, 1.32, 1.36, 16);
+  if (NFailures) {
+    cerr << "unittests: " << NFailures << " checks failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+/***************************************************************************
+    ThreadPool.cpp - A fixed set of worker threads that run a numbered
+                     list of tasks, with work stealing between threads.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool (size_t NThreads)
+  : itsNThreads (NThreads), itsThreads (0), itsQueue (0), itsTask (NULL),
+    itsGeneration (0), itsNBusy (0), isStopping (false)
+{
+  if (itsNThreads == 0) itsNThreads = thread::hardware_concurrency ();
+  if (itsNThreads == 0) itsNThreads = 1;
+  for (size_t t = 0; t < itsNThreads; t++) itsQueue.push_back (new Queue);
+  for (size_t t = 1; t < itsNThreads; t++) {
+    itsThreads.push_back (thread (&ThreadPool::work, this, t));
+  }
+  return;
+}
+
+ThreadPool::~ThreadPool ()
+{
+  {
+    lock_guard<mutex> guard (itsLock);
+    isStopping = true;
+  }
+  itsStart.notify_all ();
+  for (size_t t = 0; t < itsThreads.size (); t++) itsThreads[t].join ();
+  for (size_t t = 0; t < itsQueue.size (); t++) delete itsQueue[t];
+  return;
+}
+
+void ThreadPool::run (size_t N, const Task& task)
+{
+  if (N == 0) return;
+  if ((itsNThreads == 1) || (N == 1)) {
+    for (size_t i = 0; i < N; i++) task (i, 0);
+    return;
+  }
+  for (size_t t = 0; t < itsNThreads; t++) {
+    Queue& queue = *itsQueue[t];
+    lock_guard<mutex> guard (queue.itsLock);
+    for (size_t i = t * N / itsNThreads; i < (t + 1) * N / itsNThreads; i++) {
+      queue.itsTasks.push_back (i);
+    }
+  }
+  {
+    lock_guard<mutex> guard (itsLock);
+    itsTask = &task;
+    itsNBusy = itsNThreads - 1;
+    itsGeneration++;
+  }
+  itsStart.notify_all ();
+  runTasks (0);
+  unique_lock<mutex> lock (itsLock);
+  while (itsNBusy > 0) itsDone.wait (lock);
+  itsTask = NULL;
+  return;
+}
+
+void ThreadPool::work (size_t worker)
+{
+  size_t generation = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock (itsLock);
+      while (!isStopping && (itsGeneration == generation)) {
+	itsStart.wait (lock);
+      }
+      if (isStopping) return;
+      generation = itsGeneration;
+    }
+    runTasks (worker);
+    {
+      lock_guard<mutex> guard (itsLock);
+      itsNBusy--;
+    }
+    itsDone.notify_one ();
+  }
+}
+
+void ThreadPool::runTasks (size_t worker)
+{
+  size_t i = 0;
+  while (getTask (worker, i)) (*itsTask) (i, worker);
+  return;
+}
+
+/* No tasks are added during a run, so once every queue is found empty
+   there is nothing left to do. */
+bool ThreadPool::getTask (size_t worker, size_t& i)
+{
+  {
+    Queue& queue = *itsQueue[worker];
+    lock_guard<mutex> guard (queue.itsLock);
+    if (!queue.itsTasks.empty ()) {
+      i = queue.itsTasks.front ();
+      queue.itsTasks.pop_front ();
+      return true;
+    }
+  }
+  for (size_t k = 1; k < itsNThreads; k++) {
+    Queue& victim = *itsQueue[(worker + k) % itsNThreads];
+    lock_guard<mutex> guard (victim.itsLock);
+    if (!victim.itsTasks.empty ()) {
+      i = victim.itsTasks.back ();
+      victim.itsTasks.pop_back ();
+      return true;
+    }
+  }
+  return false;
+}
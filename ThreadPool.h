@@ -0,0 +1,80 @@
+/***************************************************************************
+    ThreadPool.h   - A fixed set of worker threads that run a numbered
+                     list of tasks, with work stealing between threads.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+/*
+  run (N, task) calls task (i, worker) for i = 0 ... N-1 and returns
+  when all calls have finished; worker (0 ... getNThreads () - 1) says
+  which thread is making the call, so that tasks can keep per-thread
+  scratch objects. The calling thread works as thread 0.
+
+  Each thread starts on its own contiguous block of tasks, so neighbouring
+  tasks (which often share setup) tend to run on the same thread. A
+  thread that finishes its block steals from the far end of another
+  thread's block. Only one run may be in progress at a time.
+*/
+class ThreadPool
+{
+ public:
+  typedef function<void (size_t, size_t)> Task;
+  // 0 means one thread per core.
+  ThreadPool (size_t NThreads = 0);
+  ~ThreadPool ();
+  size_t getNThreads () const {return itsNThreads;}
+  void run (size_t N, const Task& task);
+ private:
+  struct Queue {
+    mutex itsLock;
+    deque<size_t> itsTasks;
+  };
+  size_t itsNThreads;
+  vector<thread> itsThreads;
+  vector<Queue*> itsQueue;
+  mutex itsLock;
+  condition_variable itsStart;
+  condition_variable itsDone;
+  const Task* itsTask;
+  size_t itsGeneration;
+  size_t itsNBusy;
+  bool isStopping;
+  void work (size_t worker);
+  void runTasks (size_t worker);
+  bool getTask (size_t worker, size_t& i);
+  // To prevent copying and assignment:
+  ThreadPool (const ThreadPool& p);
+  ThreadPool operator = (const ThreadPool& p);
+};
+
+#endif//THREAD_POOL_H
@@ -0,0 +1,99 @@
+/***************************************************************************
+    ToleranceBudget.cpp   - Distributes an accuracy goal for the whole 
+                            normalized spectrum over the individual bins,
+                            and derives tolerances for the nested integrals.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "ToleranceBudget.h"
+#include <iostream>
+#include <gsl/gsl_math.h>
+
+using namespace std;
+
+const Real ToleranceBudget::DEFAULT_TARGET = 1.e-4;
+
+const Real ToleranceBudget::DEFAULT_EPSREL = 1.e-4;
+
+const Real ToleranceBudget::MINIMUM_EPSREL = 1.e-6;
+
+const Real ToleranceBudget::MAXIMUM_EPSREL = 1.e-2;
+
+ToleranceBudget::ToleranceBudget (Real target)
+  : itsTarget (target), isEnabled (true), isEstimated (false), 
+    itsEstimate (0), itsTotal (0.), itsNNonzero (0)
+{
+  checkInput ();
+  return;
+}
+
+void ToleranceBudget::setTarget (Real target)
+{
+  itsTarget = target;
+  checkInput ();
+  return;
+}
+
+void ToleranceBudget::checkInput ()
+{
+  switch (compare (itsTarget, 0.)) {
+  case 1: isEnabled = true; break;
+  case 0: isEnabled = false; break;
+  default: cerr << "ToleranceBudget: invalid target " << itsTarget << "\n";
+    itsTarget = 0.;
+    isEnabled = false; break;
+  }
+  return;
+}
+
+// The estimate only needs to be good to a factor of a few.
+void ToleranceBudget::setContributions (const RealArray& estimate)
+{
+  itsEstimate.resize (estimate.size ());
+  itsEstimate = estimate;
+  itsTotal = 0.;
+  itsNNonzero = 0;
+  for (size_t i = 0; i < itsEstimate.size (); i++) {
+    if (compare (itsEstimate[i], 0.) == 1) {
+      itsTotal += itsEstimate[i];
+      itsNNonzero++;
+    } else {
+      itsEstimate[i] = 0.;
+    }
+  }
+  isEstimated = (itsNNonzero > 0);
+  return;
+}
+
+Real ToleranceBudget::getAbsoluteTolerance (size_t i) const
+{
+  Real share = itsEstimate[i] / itsTotal + 1. / Real (itsNNonzero);
+  return 0.5 * itsTarget * itsTotal * share;
+}
+
+// Relative tolerance for the integrals that make up the flux in bin i.
+Real ToleranceBudget::getRelativeTolerance (size_t i) const
+{
+  if (compare (itsEstimate[i], 0.) != 1) return MAXIMUM_EPSREL;
+  Real epsrel = getAbsoluteTolerance (i) / itsEstimate[i];
+  epsrel = GSL_MAX_DBL (epsrel, MINIMUM_EPSREL);
+  epsrel = GSL_MIN_DBL (epsrel, MAXIMUM_EPSREL);
+  return epsrel;
+}
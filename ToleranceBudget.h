@@ -0,0 +1,70 @@
+/***************************************************************************
+    ToleranceBudget.h   - Distributes an accuracy goal for the whole 
+                          normalized spectrum over the individual bins,
+                          and derives tolerances for the nested integrals.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef TOLERANCE_BUDGET_H
+#define TOLERANCE_BUDGET_H
+
+#include <stdbool.h>
+#include "xsTypes.h"
+#include "Utilities.h"
+
+/*
+  The target is the allowed error of the renormalized spectrum, 
+  summed over all bins. Given an estimate c[i] of the (unnormalized) 
+  flux in each bin, with total T, the allowed absolute error 
+  target * T is split in two halves: one in proportion to c[i], and one 
+  evenly between the bins with nonzero c[i]. So the line core gets about 
+  the same relative precision as with a fixed epsrel = target, while the 
+  far wings and nearly empty bins get a much looser relative precision.
+  The relative tolerance of each bin is passed on to the nested Lx and 
+  optical depth integrals, within the limits MINIMUM_EPSREL and 
+  MAXIMUM_EPSREL.
+*/
+
+class ToleranceBudget {
+ public:
+  ToleranceBudget (Real target = DEFAULT_TARGET);
+  void setTarget (Real target);
+  Real getTarget () const {return itsTarget;}
+  // A target of zero turns off the budget (fixed epsrel on all integrals).
+  bool getEnabled () const {return isEnabled;}
+  bool getActive () const {return isEnabled && isEstimated;}
+  void setContributions (const RealArray& estimate);
+  Real getAbsoluteTolerance (size_t i) const;
+  Real getRelativeTolerance (size_t i) const;
+  static const Real DEFAULT_TARGET;
+  static const Real DEFAULT_EPSREL; // fixed epsrel used when inactive
+ private:
+  static const Real MINIMUM_EPSREL;
+  static const Real MAXIMUM_EPSREL;
+  Real itsTarget;
+  bool isEnabled;
+  bool isEstimated;
+  RealArray itsEstimate;
+  Real itsTotal;
+  size_t itsNNonzero;
+  void checkInput ();
+};
+
+#endif//TOLERANCE_BUDGET_H
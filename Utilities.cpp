@@ -26,6 +26,8 @@
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_const_cgsm.h>
 #include "Utilities.h"
+#include "FastMath.h"
+#include "Diagnostics.h"
 
 using namespace std;
 
@@ -67,12 +69,14 @@ bool isOcculted (Real p, Real z)
 bool badCoordinates (Real p, Real z)
 {
   if (compare (p, 0.) == -1){
-    cerr << "Negative p = " << p << "not supported.\n";
+    DIAGNOSE (diagnosticError, "badCoordinates",
+	      "Negative p = " << p << " not supported.");
     return true;
   }
   if (isOcculted (p, z)) {
-    cerr << "Call with invalid coordinates is occulted;"
-	 << "p = " << p << ", z = " << z << "\n";
+    DIAGNOSE (diagnosticError, "badCoordinates",
+	      "Call with invalid coordinates is occulted; "
+	      << "p = " << p << ", z = " << z);
     return true;
   }
   return false;
@@ -131,7 +135,8 @@ Real ShiftWavelength
 /*--------------------------Velocity-------------------------------*/
 
 Velocity::Velocity (Real beta, Real MinimumVelocity) 
-  : itsBeta (beta), itsMinimumVelocity (MinimumVelocity)
+  : itsBeta (beta), itsMinimumVelocity (MinimumVelocity), isBetaOne (false),
+    isFastMath (getFastMath ())
 {
   checkInput ();
   return;
@@ -155,11 +160,19 @@ void Velocity::checkInput ()
 	 << "; setting to 0.\n";
     itsMinimumVelocity = 0.;
   }
+  isBetaOne = (compare (itsBeta, 1.) == 0);
   return;
 }
 
 Real Velocity::getVelocity (Real u)
 {
-  return (itsMinimumVelocity + (1. - itsMinimumVelocity) 
-	  * pow (1. - u, itsBeta));
+  Real w;
+  if (isBetaOne) {
+    w = 1. - u;
+  } else if (isFastMath) {
+    w = fastPow (1. - u, itsBeta);
+  } else {
+    w = pow (1. - u, itsBeta);
+  }
+  return (itsMinimumVelocity + (1. - itsMinimumVelocity) * w);
 }
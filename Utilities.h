@@ -66,6 +66,8 @@ class Velocity
  private:
   Real itsBeta;
   Real itsMinimumVelocity;
+  bool isBetaOne;
+  bool isFastMath;
   void checkInput ();
 };
 
@@ -7,6 +7,7 @@ def configuration (parent_package='', top_path=None):
     sourceFiles\
         = ['WindAbsorption.cpp',\
                '../Utilities.cpp',\
+               '../FastMath.cpp',\
                '../Porosity.cpp',\
                '../NumericalOpticalDepth.cpp',\
                '../NumericalOpticalDepthZ.cpp',\
@@ -31,7 +31,7 @@
 using namespace std;
 
 WindAbsorptionProfile::WindAbsorptionProfile 
-(const RealArray& energy, const RealArray& parameter) 
+(ConstRealSpan energy, ConstRealSpan parameter) 
   : itsWindProfile (0), itsEnergySize (energy.size ())
 {
   allocateClasses (energy, parameter);
@@ -45,7 +45,7 @@ WindAbsorptionProfile::~WindAbsorptionProfile ()
 }
 
 void WindAbsorptionProfile::allocateClasses 
-(const RealArray& energy, const RealArray& parameter) 
+(ConstRealSpan energy, ConstRealSpan parameter) 
 {
   itsWindProfile = new WindProfile (energy, parameter, absorption);
   return;
@@ -58,10 +58,24 @@ void WindAbsorptionProfile::freeClasses ()
 }
 
 
+void WindAbsorptionProfile::setTargetAccuracy (Real target)
+{
+  itsWindProfile->setTargetAccuracy (target);
+  return;
+}
+
 void WindAbsorptionProfile::multiplyModelFlux (RealArray& flux)
 {
   size_t FluxSize = itsEnergySize - 1;
-  flux.resize (FluxSize, 1.);
+  if (flux.size () != FluxSize) flux.resize (FluxSize);
+  multiplyModelFlux (RealSpan (flux));
+  return;
+}
+
+void WindAbsorptionProfile::multiplyModelFlux (RealSpan flux)
+{
+  size_t FluxSize = itsEnergySize - 1;
+  for (size_t i = 0; i < FluxSize; i++) flux[i] = 1.;
   RealArray EmissionFlux (FluxSize);
   itsWindProfile->getModelFlux (EmissionFlux);
   size_t i = 0;
@@ -31,13 +31,16 @@
 
 class WindAbsorptionProfile {
  public:
-  WindAbsorptionProfile (const RealArray& energy, const RealArray& parameter);
+  WindAbsorptionProfile (ConstRealSpan energy, ConstRealSpan parameter);
   ~WindAbsorptionProfile ();
+  // flux must have one element fewer than energy.
+  void multiplyModelFlux (RealSpan flux);
   void multiplyModelFlux (RealArray& flux);
+  void setTargetAccuracy (Real target);
  private:
   WindProfile* itsWindProfile;
   size_t itsEnergySize;
-  void allocateClasses (const RealArray& energy, const RealArray& parameter);
+  void allocateClasses (ConstRealSpan energy, ConstRealSpan parameter);
   void freeClasses ();
 };
 
@@ -50,12 +50,12 @@ WindParameter::WindParameter ()
     isHeII (false),
     itsTau0RAD (0.), itsDeltaERAD (0.), itsGammaRAD (0.),
     itsWavelength (20.), itsShift (0.), itsVelocity (0.001), isVerbose (false),
-    itsG (0.)
+    itsG (0.), itsMappingBegin (0), itsMappingEnd (0)
 {
   return;
 }
 
-WindParameter::WindParameter (const RealArray& parameter, ModelType type)
+WindParameter::WindParameter (ConstRealSpan parameter, ModelType type)
   : itsQ (0.), itsTauStar (0.), itsU0 (0.5), itsUmin (0.), 
     itsH (0.), itsTau0Star (0.), 
     itsBeta (1.), itsBetaSobolev (0.), itsKappaRatio (0.), itsR0 (1.), itsP (0.), 
@@ -66,7 +66,7 @@ WindParameter::WindParameter (const RealArray& parameter, ModelType type)
     isHeII (false),
     itsTau0RAD (0.), itsDeltaERAD (0.), itsGammaRAD (0.),
     itsWavelength (20.), itsShift (0.), itsVelocity (0.001), isVerbose (false),
-    itsG (0.)
+    itsG (0.), itsMappingBegin (0), itsMappingEnd (0)
 {
   setModelType (type);
   setParameters (parameter);
@@ -83,7 +83,7 @@ void WindParameter::setModelType (ModelType type)
 // Turns the array parameter into physical function parameters.
 // Checks that the values are reasonable.
 void WindParameter::setParameters 
-(const RealArray& parameter)
+(ConstRealSpan parameter)
 {
   if (!correctNParameters (parameter.size ())) return;
   size_t i = 0;
@@ -139,14 +139,18 @@ void WindParameter::setParameters
   isExpansion = bool (parameter [i++]);
   isOpticallyThick = bool (parameter [i++]);
   if (itsModelType == general) {
+    itsMappingBegin = i;
     itsWavelength = parameter [i++];
   } else if (itsModelType == rad) {
+    itsMappingBegin = i;
     itsWavelength = parameter [i++];
   } else {
     itsAtomicNumber = int (parameter [i++]);
+    itsMappingBegin = i;
   }
   itsShift = ConvertWavelength (parameter [i++]);
   itsVelocity = convert_KMS_C (parameter [i++]);
+  itsMappingEnd = i;
   if (itsModelType == helike) {
     itsP = parameter [i++];
     itsN0 = parameter[i++];
@@ -170,7 +174,7 @@ void WindParameter::setParameters
 */
 
 /*
-void WindParameter::setOpticalDepthParameters (const RealArray& parameter)
+void WindParameter::setOpticalDepthParameters (ConstRealSpan parameter)
 {
   size_t i (0);
   itsTauStar = parameter [i++];
@@ -183,7 +187,7 @@ void WindParameter::setOpticalDepthParameters (const RealArray& parameter)
   return;
 }
 
-void WindParameter::setProfileParameters (const RealArray& parameter)
+void WindParameter::setProfileParameters (ConstRealSpan parameter)
 {
   size_t i (0);
   itsQ = parameter [i++];
@@ -202,7 +206,7 @@ void WindParameter::setProfileParameters (const RealArray& parameter)
   return;
 }
 */
-void WindParameter::setAbsorptionParameters (const RealArray& parameter)
+void WindParameter::setAbsorptionParameters (ConstRealSpan parameter)
 {
   size_t i (0);
   itsQ = parameter [i++];
@@ -215,7 +219,7 @@ void WindParameter::setAbsorptionParameters (const RealArray& parameter)
   return;
 }
 
-void WindParameter::setRADParameters (const RealArray& parameter)
+void WindParameter::setRADParameters (ConstRealSpan parameter)
 {
   size_t i (0);
   itsQ = parameter [i++];
@@ -226,7 +230,10 @@ void WindParameter::setRADParameters (const RealArray& parameter)
   itsTau0RAD = parameter[i++];
   itsDeltaERAD = parameter[i++];
   itsGammaRAD = parameter[i++];
+  // the velocity also sets the RAD optical depth
+  itsMappingBegin = i;
   itsWavelength = parameter [i++];
+  itsMappingEnd = i;
   itsVelocity = convert_KMS_C (parameter [i++]);
   return;
 }
@@ -234,12 +241,12 @@ void WindParameter::setRADParameters (const RealArray& parameter)
 
 // opticaldepth and profile are passed from IDL.
 // The others are passed from XSPEC and thus contain an extra parameter
-// (normalization).
+// (normalization), except abswind, which is multiplicative.
 bool WindParameter::correctNParameters (size_t N)
 {
   size_t ExpectedParameters;
   if (itsModelType == absorption) {
-    ExpectedParameters = 6;
+    ExpectedParameters = ABSWIND_N_PARAMETERS;
     /*  } else if (itsModelType == opticaldepth) {
     ExpectedParameters = 7;
   } else if (itsModelType == profile) {
@@ -388,23 +395,39 @@ Real WindParameter::getWavelength (HeLikeType type) const
   return (HePar.getWavelength (type) + itsShift);
 }
 
+Real WindParameter::getRestEnergy (HeLikeType type) const
+{
+  if (itsModelType == helike) {
+    return HC / getWavelength (type); // keV
+  } else {
+    return HC / getWavelength ();
+  }
+}
+
 void WindParameter::setX 
-(const RealArray& energy, RealArray& x, HeLikeType type)
+(ConstRealSpan energy, RealArray& x, HeLikeType type)
+{
+  mapX (energy, getRestEnergy (type), getVelocity (), x);
+  return;
+}
+
+void WindParameter::mapX 
+(ConstRealSpan energy, Real RestEnergy, Real v, RealArray& x)
 {
   if (x.size () != energy.size ()) {
     x.resize (energy.size ());
   }
-  Real wavelength;
-  if (itsModelType == helike) {
-    wavelength = getWavelength (type); 
-  } else {
-    wavelength = getWavelength ();
+  for (size_t i = 0; i < energy.size (); i++) {
+    x[i] = (RestEnergy / energy[i] - 1.) / v;
   }
-  Real RestEnergy = HC / wavelength; // keV
-  x = (RestEnergy / energy - 1.) / getVelocity ();
   return;
 }
 
+bool WindParameter::isMappingParameter (size_t index) const
+{
+  return ((index >= itsMappingBegin) && (index < itsMappingEnd));
+}
+
 void WindParameter::initializeVelocity (Velocity*& V)
 {
   V = new Velocity (itsBeta, 0.); 
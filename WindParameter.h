@@ -34,6 +34,7 @@
 #include "Lx.h"
 #include "AtomicParameters.h"
 #include "RAD_OpticalDepth.h"
+#include "Span.h"
 
 //enum ModelType {general, hlike, helike, opticaldepth, profile, absorption};
 enum ModelType {general, hlike, helike, absorption, rad};
@@ -48,9 +49,9 @@ class WindParameter
 {
  public:
   WindParameter ();
-  WindParameter (const RealArray& parameters, ModelType type);
+  WindParameter (ConstRealSpan parameters, ModelType type);
   void setModelType (ModelType type);
-  void setParameters (const RealArray& parameters);
+  void setParameters (ConstRealSpan parameters);
   Real getVelocity () const {return itsVelocity;}
   Real getWavelength () const {return (itsWavelength + itsShift);}
   Real getWavelength (HeLikeType type) const;
@@ -58,8 +59,17 @@ class WindParameter
   Real getG () const {return itsG;}
   bool getNumerical () const {return isNumerical;}
   bool getHeII () {return isHeII;}
+  // Rest energy (keV) of the line; type selects the He-like line.
+  Real getRestEnergy (HeLikeType type = wResonance) const;
   void setX 
-    (const RealArray& energy, RealArray& x, HeLikeType type = wResonance);
+    (ConstRealSpan energy, RealArray& x, HeLikeType type = wResonance);
+  // x = (RestEnergy / E - 1) / v on the energy grid (v in units of c)
+  static void mapX (ConstRealSpan energy, Real RestEnergy, Real v,
+		    RealArray& x);
+  /* True if parameter[index] only enters the mapping from energy to x
+     (the line position, and the velocity except for radwind), so that
+     changing it leaves Lx as it is. */
+  bool isMappingParameter (size_t index) const;
   void initializeVelocity (Velocity*& V);
   void initializePorosity (Porosity*& P);
   void initializeOpticalDepth (OpticalDepth*& Tau, OpticalDepth*& TauHeII);
@@ -107,12 +117,15 @@ class WindParameter
   bool isVerbose;
   HeLikeParameters HePar;
   Real itsG;
+  // parameters [itsMappingBegin, itsMappingEnd) set only the x mapping
+  size_t itsMappingBegin;
+  size_t itsMappingEnd;
   bool correctNParameters (size_t N);
   void checkInput ();
-  void setOpticalDepthParameters (const RealArray& parameter);
-  void setProfileParameters (const RealArray& parameter);
-  void setAbsorptionParameters (const RealArray& parameter);
-  void setRADParameters (const RealArray& parameter);
+  void setOpticalDepthParameters (ConstRealSpan parameter);
+  void setProfileParameters (ConstRealSpan parameter);
+  void setAbsorptionParameters (ConstRealSpan parameter);
+  void setRADParameters (ConstRealSpan parameter);
 };
 
 #endif
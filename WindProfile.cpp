@@ -23,12 +23,15 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "WindProfile.h"
+#include "Diagnostics.h"
 #include <iostream>
 
 using namespace std;
 
+const size_t WindProfile::N_ESTIMATE = 65;
+
 WindProfile::WindProfile 
-(const RealArray& energy, const RealArray& parameter, ModelType type)
+(ConstRealSpan energy, ConstRealSpan parameter, ModelType type)
   : itsEnergyArray (energy),  itsEnergySize (itsEnergyArray.size ()), 
     itsFluxSize (itsEnergySize - 1), x (RealArray (itsEnergySize)), 
     itsModelType (type), itsWindParameter (NULL), itsFluxIntegral (NULL),
@@ -36,7 +39,7 @@ WindProfile::WindProfile
     itsResonanceScattering (NULL), itsOpticalDepth (NULL),
     //    itsNumericalOpticalDepth (NULL),
     itsPorosity (NULL),
-    itsRAD_OpticalDepth (NULL),
+    itsRAD_OpticalDepth (NULL), itsToleranceBudget (NULL),
     itsTotal (0.), 
     isFinite (false), isNumerical (false)
 {
@@ -51,7 +54,7 @@ WindProfile::~WindProfile ()
   freeClasses ();
 }
 
-void WindProfile::allocateWindParameter (const RealArray& parameter)
+void WindProfile::allocateWindParameter (ConstRealSpan parameter)
 {
   itsWindParameter = new WindParameter (parameter, itsModelType);
   return;
@@ -94,6 +97,9 @@ void WindProfile::allocateClasses ()
 				    itsResonanceScattering, itsOpticalDepth);
   }
   itsFluxIntegral = new FluxIntegral (itsLx);
+  itsToleranceBudget = new ToleranceBudget ();
+  itsOpticalDepth->reportBackend ();
+  if (isHeII) itsOpticalDepthHeII->reportBackend ();
   return;
 }
 
@@ -104,6 +110,8 @@ void WindProfile::freeClasses ()
   itsWindParameter = NULL;
   delete itsFluxIntegral;
   itsFluxIntegral = NULL;
+  delete itsToleranceBudget;
+  itsToleranceBudget = NULL;
   delete itsLx;
   itsLx = NULL;
   delete itsOpticalDepth;
@@ -127,68 +135,225 @@ void WindProfile::freeClasses ()
 
 void WindProfile::getModelFlux (RealArray& flux) 
 {
-  flux.resize (itsFluxSize);
-  Real RADeff = 1.;
-  if (itsModelType == helike) {
-    RealArray rFlux (itsFluxSize);
-    RealArray iFlux (itsFluxSize);
-    RealArray fFlux (itsFluxSize);
-    getOneFlux (rFlux, wResonance);
-    getOneFlux (iFlux, yIntercombination);
-    getOneFlux (fFlux, zForbidden);
-    if (itsWindParameter->getVerbosity ()) {
-      FToIRatio (fFlux, iFlux);
-    }
-    Real G = itsWindParameter->getG ();
-    flux = (rFlux + G * (iFlux + fFlux)) / (1. + G);
-  } else if (itsModelType == rad) {
-    RealArray noRADflux (itsFluxSize);
-    getOneFlux (flux);
-    itsLx->setRADTransparent ();
-    getOneFlux (noRADflux);
-    itsLx->notRADTransparent ();
-    Real noRADflux_sum = noRADflux.sum ();
-    if (compare (noRADflux_sum, 0.) == 1) {
-      RADeff = flux.sum () / noRADflux.sum ();
-    }
-  } else {
-    getOneFlux (flux);
+  if (flux.size () != itsFluxSize) flux.resize (itsFluxSize);
+  getModelFlux (RealSpan (flux));
+  return;
+}
+
+void WindProfile::getModelFlux (RealSpan flux) 
+{
+  size_t N = getNumberOfComponents ();
+  vector<RealArray> component (N, RealArray (itsFluxSize));
+  ToleranceBudget budget;
+  for (size_t c = 0; c < N; c++) {
+    itsWindParameter->setX (itsEnergyArray, x, getComponentType (c));
+    setComponentBudget (c, x, budget);
+    getComponentFlux (c, x, budget, 0, itsFluxSize, component[c]);
   }
-  renormalize (flux);
-  if (itsModelType == rad) {
-    flux *= RADeff;
-    cout << "RAD transmitted fraction: " << RADeff << endl;
+  if ((itsModelType == helike) && itsWindParameter->getVerbosity ()) {
+    FToIRatio (component[2], component[1]);
   }
+  combineComponents (component, flux);
   if (isFinite && itsWindParameter->getVerbosity () && 
       (itsModelType != helike)) {
+    setComponent (0);
     TransmissionRatio (x);
   }
   return;
 }
 
-void WindProfile::getOneFlux (RealArray& flux, HeLikeType type)
+size_t WindProfile::getNumberOfComponents () const
+{
+  return getNumberOfComponents (itsModelType);
+}
+
+size_t WindProfile::getNumberOfComponents (ModelType type)
+{
+  if (type == helike) return 3;
+  if (type == rad) return 2;
+  return 1;
+}
+
+HeLikeType WindProfile::getComponentType (size_t component) const
+{
+  return getComponentType (itsModelType, component);
+}
+
+HeLikeType WindProfile::getComponentType (ModelType type, size_t component)
+{
+  if (type != helike) return wResonance;
+  if (component == 1) return yIntercombination;
+  if (component == 2) return zForbidden;
+  return wResonance;
+}
+
+// Component 1 of radwind is the flux without RAD.
+void WindProfile::setComponent (size_t component)
 {
   if (itsModelType == helike) {
-    itsWindParameter->setX (itsEnergyArray, x, type);
-    itsLx->setHeLikeType (type);
-  } else {
-    itsWindParameter->setX (itsEnergyArray, x);
+    itsLx->setHeLikeType (getComponentType (component));
+  } else if (itsModelType == rad) {
+    if (component == 1) {
+      itsLx->setRADTransparent ();
+    } else {
+      itsLx->notRADTransparent ();
+    }
   }
-  for (size_t i = 0; i < (itsFluxSize); i++) {
+  return;
+}
+
+void WindProfile::getXMapping 
+(size_t component, Real& RestEnergy, Real& v) const
+{
+  RestEnergy = itsWindParameter->getRestEnergy (getComponentType (component));
+  v = itsWindParameter->getVelocity ();
+  return;
+}
+
+void WindProfile::setComponentBudget 
+(size_t component, const RealArray& x, ToleranceBudget& budget)
+{
+  budget = *itsToleranceBudget;
+  if (budget.getEnabled ()) {
+    setComponent (component);
+    RealArray estimate (itsFluxSize);
+    estimateContributions (x, estimate);
+    budget.setContributions (estimate);
+  }
+  return;
+}
+
+void WindProfile::getComponentFlux 
+(size_t component, const RealArray& x, const ToleranceBudget& budget,
+ size_t first, size_t last, RealSpan flux)
+{
+  setComponent (component);
+  bool isBudget = budget.getActive ();
+  for (size_t i = first; i < last; i++) {
+    if (isBudget) {
+      itsFluxIntegral->setEpsAbs (budget.getAbsoluteTolerance (i));
+      itsLx->setTolerance (budget.getRelativeTolerance (i));
+    }
     flux[i] = itsFluxIntegral->getFlux (x[i], x[i+1]);
   } 
+  if (isBudget) {
+    itsFluxIntegral->setEpsRel (ToleranceBudget::DEFAULT_EPSREL);
+    itsLx->setTolerance (ToleranceBudget::DEFAULT_EPSREL);
+  }
+  return;
+}
+
+bool WindProfile::isMappingParameter (size_t index) const
+{
+  return itsWindParameter->isMappingParameter (index);
+}
+
+/* Each edge gets the tighter tolerance of the two bins it borders. */
+void WindProfile::getEdgeFlux 
+(size_t component, const RealArray& x, const RealArray& xNew,
+ const ToleranceBudget& budget, size_t first, size_t last, RealSpan delta)
+{
+  setComponent (component);
+  bool isBudget = budget.getActive ();
+  for (size_t i = first; i < last; i++) {
+    if (isBudget) {
+      size_t lower = (i > 0) ? i - 1 : 0;
+      size_t upper = (i < itsFluxSize) ? i : itsFluxSize - 1;
+      itsFluxIntegral->setEpsAbs 
+	(GSL_MIN_DBL (budget.getAbsoluteTolerance (lower),
+		      budget.getAbsoluteTolerance (upper)));
+      itsLx->setTolerance 
+	(GSL_MIN_DBL (budget.getRelativeTolerance (lower),
+		      budget.getRelativeTolerance (upper)));
+    }
+    delta[i] = itsFluxIntegral->getFlux (x[i], xNew[i]);
+    if (xNew[i] < x[i]) delta[i] *= -1.;
+  }
+  if (isBudget) {
+    itsFluxIntegral->setEpsRel (ToleranceBudget::DEFAULT_EPSREL);
+    itsLx->setTolerance (ToleranceBudget::DEFAULT_EPSREL);
+  }
+  return;
+}
+
+void WindProfile::combineComponents 
+(const vector<RealArray>& component, RealSpan flux)
+{
+  Real RADeff = 1.;
+  if (itsModelType == helike) {
+    Real G = itsWindParameter->getG ();
+    for (size_t i = 0; i < itsFluxSize; i++) {
+      flux[i] = (component[0][i] + G * (component[1][i] + component[2][i]))
+	/ (1. + G);
+    }
+  } else {
+    for (size_t i = 0; i < itsFluxSize; i++) flux[i] = component[0][i];
+  }
+  if (itsModelType == rad) {
+    Real noRADflux_sum = component[1].sum ();
+    if (compare (noRADflux_sum, 0.) == 1) {
+      RADeff = flux.sum () / noRADflux_sum;
+    }
+  }
+  renormalize (flux);
+  if (itsModelType == rad) {
+    for (size_t i = 0; i < itsFluxSize; i++) flux[i] *= RADeff;
+    DIAGNOSE (diagnosticInfo, "WindProfile::getModelFlux",
+	      "RAD transmitted fraction: " << RADeff);
+  }
+  return;
+}
+
+void WindProfile::setTargetAccuracy (Real target)
+{
+  itsToleranceBudget->setTarget (target);
+  return;
+}
+
+/* 
+   Cheap estimate of the flux in each bin, used to set up the tolerance
+   budget. Lx is evaluated on a coarse uniform grid in x, and the linear
+   interpolation between the grid points is integrated over each bin
+   of the grid x.
+*/
+void WindProfile::estimateContributions 
+(const RealArray& x, RealArray& estimate)
+{
+  Real dx = 2. / Real (N_ESTIMATE - 1);
+  RealArray LxGrid (N_ESTIMATE);
+  RealArray Cumulative (N_ESTIMATE);
+  for (size_t j = 0; j < N_ESTIMATE; j++) {
+    LxGrid[j] = itsLx->getLx (-1. + dx * j);
+  }
+  Cumulative[0] = 0.;
+  for (size_t j = 1; j < N_ESTIMATE; j++) {
+    Cumulative[j] = Cumulative[j-1] + 0.5 * dx * (LxGrid[j-1] + LxGrid[j]);
+  }
+  Real previous = 0.;
+  for (size_t i = 0; i < itsEnergySize; i++) {
+    // cumulative integral of the interpolated Lx from -1 to x[i]
+    Real xi = GSL_MAX_DBL (GSL_MIN_DBL (x[i], 1.), -1.);
+    size_t j = size_t ((xi + 1.) / dx);
+    if (j > N_ESTIMATE - 2) j = N_ESTIMATE - 2;
+    Real t = xi + 1. - dx * j;
+    Real slope = (LxGrid[j+1] - LxGrid[j]) / dx;
+    Real current = Cumulative[j] + t * (LxGrid[j] + 0.5 * slope * t);
+    if (i > 0) estimate[i-1] = fabs (current - previous);
+    previous = current;
+  }
   return;
 }
 
-void WindProfile::renormalize (RealArray& flux)
+void WindProfile::renormalize (RealSpan flux)
 {
   itsTotal = flux.sum ();
   if (compare (itsTotal, 0.) == 1) {
-    flux /= itsTotal;
+    for (size_t i = 0; i < itsFluxSize; i++) flux[i] /= itsTotal;
     isFinite = true;
     return;
   } else {
-    cerr << "Can't renormalize; total flux is zero.\n";
+    DIAGNOSE (diagnosticWarning, "WindProfile::renormalize",
+	      "Can't renormalize; total flux is zero.");
     isFinite = false;
     return;
   }
@@ -35,16 +35,57 @@
 #include "Lx.h"
 #include "WindParameter.h"
 #include "FluxIntegral.h"
+#include "ToleranceBudget.h"
+#include "Span.h"
+#include <vector>
+
+using namespace std;
 
 class WindProfile
 {
  public:
-  WindProfile (const RealArray& energy, const RealArray& parameter, 
+  WindProfile (ConstRealSpan energy, ConstRealSpan parameter, 
 	       ModelType type = general);
   ~WindProfile ();
+  // Writes the profile into flux, which must have one element fewer
+  // than energy.
+  void getModelFlux (RealSpan flux);
   void getModelFlux (RealArray& flux);
+  // Accuracy goal for the renormalized spectrum; 0 gives a fixed epsrel
+  // on every integral instead.
+  void setTargetAccuracy (Real target);
+  /* For evaluating the flux in pieces (see WindProfileBatch). The
+     profile is the normalized combination of one or more components
+     (r, i and f for hewind; with and without RAD for radwind; otherwise
+     just the line). Each component is integrated bin by bin on its own
+     x grid and tolerance budget; these depend only on the parameters,
+     so they can be shared by several WindProfile objects. */
+  size_t getNumberOfComponents () const;
+  static size_t getNumberOfComponents (ModelType type);
+  static HeLikeType getComponentType (ModelType type, size_t component);
+  // x = (RestEnergy / E - 1) / v for the component (see WindParameter)
+  void getXMapping (size_t component, Real& RestEnergy, Real& v) const;
+  void setComponentBudget 
+    (size_t component, const RealArray& x, ToleranceBudget& budget);
+  // Writes flux[i] for first <= i < last; flux spans the whole grid.
+  void getComponentFlux 
+    (size_t component, const RealArray& x, const ToleranceBudget& budget,
+     size_t first, size_t last, RealSpan flux);
+  void combineComponents 
+    (const vector<RealArray>& component, RealSpan flux);
+  /* When only the x mapping changes (see 
+     WindParameter::isMappingParameter), Lx stays the same, and the
+     flux on a new grid xNew is the flux on x plus delta[i] - delta[i+1],
+     where delta[i] is the integral of Lx from x[i] to xNew[i]. This
+     fills delta for the edges first ... last - 1. */
+  bool isMappingParameter (size_t index) const;
+  void getEdgeFlux 
+    (size_t component, const RealArray& x, const RealArray& xNew,
+     const ToleranceBudget& budget, size_t first, size_t last, 
+     RealSpan delta);
  private:
-  const RealArray& itsEnergyArray;
+  static const size_t N_ESTIMATE; // grid size for estimateContributions
+  ConstRealSpan itsEnergyArray;
   size_t itsEnergySize;
   size_t itsFluxSize;
   RealArray x;
@@ -62,16 +103,19 @@ class WindProfile
   //  NumericalOpticalDepth* itsNumericalOpticalDepth;
   Porosity* itsPorosity;
   RAD_OpticalDepth* itsRAD_OpticalDepth;
+  ToleranceBudget* itsToleranceBudget;
   Real itsTotal;
   bool isFinite;
   bool isNumerical;
   bool isHeII;
-  void allocateWindParameter (const RealArray& parameter);
+  void allocateWindParameter (ConstRealSpan parameter);
   void freeWindParameter ();
   void allocateClasses ();
   void freeClasses ();
-  void getOneFlux (RealArray& flux, HeLikeType type = wResonance);
-  void renormalize (RealArray& flux);
+  HeLikeType getComponentType (size_t component) const;
+  void setComponent (size_t component);
+  void estimateContributions (const RealArray& x, RealArray& estimate);
+  void renormalize (RealSpan flux);
   void TransmissionRatio (const RealArray& x);
   void FToIRatio (const RealArray& fFlux, const RealArray& iFlux);
 };
@@ -0,0 +1,299 @@
+/***************************************************************************
+    WindProfileBatch.cpp - computes the windprof family of spectra for
+                           many parameter vectors on one energy grid,
+                           spreading walkers and bins over a thread pool.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "WindProfileBatch.h"
+#include "Diagnostics.h"
+#include <iostream>
+
+using namespace std;
+
+const size_t WindProfileBatch::BINS_PER_TASK = 16;
+// x grids kept between calls (e.g. when the line position is fitted)
+const size_t WindProfileBatch::MAXIMUM_CACHED_GRIDS = 1024;
+
+WindProfileBatch::WindProfileBatch 
+(ConstRealSpan energy, ModelType type, size_t NThreads)
+  : itsEnergyArray (energy), itsFluxSize (energy.size () - 1),
+    itsModelType (type), itsTarget (ToleranceBudget::DEFAULT_TARGET),
+    itsPool (NThreads), itsXCache (), itsRow (0),
+    itsWorker (itsPool.getNThreads (), (WindProfile*) NULL),
+    itsWorkerRow (itsPool.getNThreads (), 0)
+{
+  return;
+}
+
+WindProfileBatch::~WindProfileBatch ()
+{
+  freeWorkers ();
+  freeRows ();
+  return;
+}
+
+void WindProfileBatch::setTargetAccuracy (Real target)
+{
+  itsTarget = target;
+  return;
+}
+
+void WindProfileBatch::getModelFlux 
+(ConstRealSpan parameter, size_t NRows, RealArray& flux)
+{
+  if (flux.size () != NRows * itsFluxSize) flux.resize (NRows * itsFluxSize);
+  getModelFlux (parameter, NRows, RealSpan (flux));
+  return;
+}
+
+void WindProfileBatch::getModelFlux 
+(ConstRealSpan parameter, size_t NRows, RealSpan flux)
+{
+  // the messages of all the threads are written at the end
+  DIAGNOSTICS_MODEL_CALL ("WindProfileBatch", "");
+  if (NRows == 0) return;
+  if ((parameter.size () % NRows != 0) || 
+      (flux.size () != NRows * itsFluxSize)) {
+    cerr << "WindProfileBatch: " << parameter.size () << " parameters and "
+	 << flux.size () << " flux bins do not make " << NRows << " rows\n";
+    return;
+  }
+  allocateRows (parameter, NRows);
+  evaluateRows (parameter, NRows, flux);
+  return;
+}
+
+void WindProfileBatch::getStencilFlux 
+(ConstRealSpan base, const vector<size_t>& index, ConstRealSpan delta,
+ RealArray& flux)
+{
+  size_t NRows = index.size () + 1;
+  if (flux.size () != NRows * itsFluxSize) flux.resize (NRows * itsFluxSize);
+  getStencilFlux (base, index, delta, RealSpan (flux));
+  return;
+}
+
+void WindProfileBatch::getStencilFlux 
+(ConstRealSpan base, const vector<size_t>& index, ConstRealSpan delta,
+ RealSpan flux)
+{
+  size_t NParameters = base.size ();
+  size_t NRows = index.size () + 1;
+  if ((delta.size () != index.size ()) || 
+      (flux.size () != NRows * itsFluxSize)) {
+    cerr << "WindProfileBatch: " << index.size () << " perturbations, "
+	 << delta.size () << " steps and " << flux.size () 
+	 << " flux bins do not make a stencil\n";
+    return;
+  }
+  RealArray parameter (NRows * NParameters);
+  for (size_t row = 0; row < NRows; row++) {
+    for (size_t i = 0; i < NParameters; i++) {
+      parameter[row * NParameters + i] = base[i];
+    }
+  }
+  for (size_t k = 0; k < index.size (); k++) {
+    if (index[k] >= NParameters) {
+      cerr << "WindProfileBatch: parameter index " << index[k] 
+	   << " out of range\n";
+      return;
+    }
+    parameter[(k + 1) * NParameters + index[k]] += delta[k];
+  }
+  allocateRows (parameter, NRows, true);
+  evaluateRows (parameter, NRows, flux);
+  return;
+}
+
+void WindProfileBatch::evaluateRows 
+(ConstRealSpan parameter, size_t NRows, RealSpan flux)
+{
+  size_t NParameters = parameter.size () / NRows;
+  size_t NComponents = itsRow[0].itsComponent.size ();
+  size_t NChunks = (itsFluxSize + BINS_PER_TASK - 1) / BINS_PER_TASK;
+  itsPool.run (NRows * NComponents * NChunks, 
+	       [&] (size_t task, size_t worker) {
+		 integrateTask (task, worker, parameter, NParameters);
+	       });
+  itsPool.run (NRows, [&] (size_t row, size_t /*worker*/) {
+      if (itsRow[row].isShifted) setShiftedFlux (row);
+      itsRow[row].itsProfile->combineComponents 
+	(itsRow[row].itsComponent, 
+	 RealSpan (flux.data () + row * itsFluxSize, itsFluxSize));
+    });
+  freeWorkers ();
+  freeRows ();
+  return;
+}
+
+/* For a stencil (isStencil), row 0 is the base point. A row that
+   differs from it only in x mapping parameters is shifted, and its
+   components hold the edge integrals until setShiftedFlux; a row with
+   the same x grid as row 0 takes its tolerance budget. */
+void WindProfileBatch::allocateRows 
+(ConstRealSpan parameter, size_t NRows, bool isStencil)
+{
+  size_t NParameters = parameter.size () / NRows;
+  itsRow.resize (NRows);
+  itsPool.run (NRows, [&] (size_t row, size_t /*worker*/) {
+      Row& R = itsRow[row];
+      R.itsProfile = new WindProfile 
+	(itsEnergyArray, 
+	 ConstRealSpan (parameter.data () + row * NParameters, NParameters),
+	 itsModelType);
+      R.itsProfile->setTargetAccuracy (itsTarget);
+      R.isShifted = false;
+      size_t NComponents = R.itsProfile->getNumberOfComponents ();
+      R.itsX.assign (NComponents, (const RealArray*) NULL);
+      R.itsBudget.resize (NComponents);
+      R.itsComponent.assign (NComponents, RealArray (itsFluxSize));
+    });
+  if (isStencil) {
+    for (size_t row = 1; row < NRows; row++) {
+      Row& R = itsRow[row];
+      R.isShifted = true;
+      for (size_t i = 0; i < NParameters; i++) {
+	if ((parameter[row * NParameters + i] != parameter[i]) &&
+	    !itsRow[0].itsProfile->isMappingParameter (i)) {
+	  R.isShifted = false;
+	}
+      }
+      if (R.isShifted) {
+	for (size_t c = 0; c < R.itsComponent.size (); c++) {
+	  R.itsComponent[c].resize (itsFluxSize + 1);
+	}
+      }
+    }
+  }
+  // the cache is only touched here, from one thread
+  if (itsXCache.size () > MAXIMUM_CACHED_GRIDS) itsXCache.clear ();
+  size_t NComponents = itsRow[0].itsComponent.size ();
+  for (size_t row = 0; row < NRows; row++) {
+    for (size_t c = 0; c < NComponents; c++) itsRow[row].itsX[c] = getX (row, c);
+  }
+  itsPool.run (NRows, [&] (size_t row, size_t /*worker*/) {
+      Row& R = itsRow[row];
+      for (size_t c = 0; c < NComponents; c++) {
+	if (isStencil && (row > 0) && 
+	    (R.isShifted || (R.itsX[c] == itsRow[0].itsX[c]))) continue;
+	R.itsProfile->setComponentBudget (c, *R.itsX[c], R.itsBudget[c]);
+      }
+    });
+  if (isStencil) {
+    for (size_t row = 1; row < NRows; row++) {
+      Row& R = itsRow[row];
+      for (size_t c = 0; c < NComponents; c++) {
+	if (!R.isShifted && (R.itsX[c] == itsRow[0].itsX[c])) {
+	  R.itsBudget[c] = itsRow[0].itsBudget[c];
+	}
+      }
+    }
+  }
+  return;
+}
+
+void WindProfileBatch::freeRows ()
+{
+  for (size_t row = 0; row < itsRow.size (); row++) {
+    delete itsRow[row].itsProfile;
+    itsRow[row].itsProfile = NULL;
+  }
+  itsRow.clear ();
+  return;
+}
+
+void WindProfileBatch::freeWorkers ()
+{
+  for (size_t t = 0; t < itsWorker.size (); t++) {
+    delete itsWorker[t];
+    itsWorker[t] = NULL;
+  }
+  return;
+}
+
+const RealArray* WindProfileBatch::getX (size_t row, size_t component)
+{
+  Real RestEnergy = 0.;
+  Real v = 0.;
+  itsRow[row].itsProfile->getXMapping (component, RestEnergy, v);
+  pair<Real, Real> key (RestEnergy, v);
+  map<pair<Real, Real>, RealArray>::iterator cached = itsXCache.find (key);
+  if (cached != itsXCache.end ()) return &cached->second;
+  RealArray& x = itsXCache[key];
+  WindParameter::mapX (itsEnergyArray, RestEnergy, v, x);
+  return &x;
+}
+
+/* Tasks are numbered by row, then component, then chunk of bins, so
+   the blocks the pool deals out to each thread mostly stay within one
+   row, and the thread's WindProfile is only rebuilt when it moves on
+   to another row. */
+void WindProfileBatch::integrateTask 
+(size_t task, size_t worker, ConstRealSpan parameter, size_t NParameters)
+{
+  size_t NComponents = itsRow[0].itsComponent.size ();
+  size_t NChunks = (itsFluxSize + BINS_PER_TASK - 1) / BINS_PER_TASK;
+  size_t row = task / (NComponents * NChunks);
+  size_t c = (task / NChunks) % NComponents;
+  size_t first = (task % NChunks) * BINS_PER_TASK;
+  size_t last = first + BINS_PER_TASK;
+  if (last > itsFluxSize) last = itsFluxSize;
+  Row& R = itsRow[row];
+  // shifted rows integrate the Lx of row 0
+  size_t source = R.isShifted ? 0 : row;
+  if ((itsWorker[worker] == NULL) || (itsWorkerRow[worker] != source)) {
+    delete itsWorker[worker];
+    itsWorker[worker] = new WindProfile 
+      (itsEnergyArray, 
+       ConstRealSpan (parameter.data () + source * NParameters, NParameters),
+       itsModelType);
+    itsWorkerRow[worker] = source;
+  }
+  if (R.isShifted) {
+    if (last == itsFluxSize) last++; // the upper edge of the last bin
+    itsWorker[worker]->getEdgeFlux 
+      (c, *itsRow[0].itsX[c], *R.itsX[c], itsRow[0].itsBudget[c], 
+       first, last, R.itsComponent[c]);
+  } else {
+    itsWorker[worker]->getComponentFlux 
+      (c, *R.itsX[c], R.itsBudget[c], first, last, R.itsComponent[c]);
+  }
+  return;
+}
+
+/* Turns the edge integrals of a shifted row into bin fluxes; rounding
+   can leave tiny negative values in empty bins. */
+void WindProfileBatch::setShiftedFlux (size_t row)
+{
+  Row& R = itsRow[row];
+  for (size_t c = 0; c < R.itsComponent.size (); c++) {
+    const RealArray& delta = R.itsComponent[c];
+    const RealArray& flux = itsRow[0].itsComponent[c];
+    RealArray shifted (itsFluxSize);
+    for (size_t i = 0; i < itsFluxSize; i++) {
+      shifted[i] = GSL_MAX_DBL (flux[i] + delta[i] - delta[i+1], 0.);
+    }
+    R.itsComponent[c].resize (itsFluxSize);
+    R.itsComponent[c] = shifted;
+  }
+  R.isShifted = false;
+  return;
+}
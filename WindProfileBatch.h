@@ -0,0 +1,114 @@
+/***************************************************************************
+    WindProfileBatch.h - computes the windprof family of spectra for many
+                         parameter vectors on one energy grid, spreading
+                         walkers and bins over a thread pool.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef WIND_PROFILE_BATCH_H
+#define WIND_PROFILE_BATCH_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+#include "WindParameter.h"
+#include "WindProfile.h"
+#include "ToleranceBudget.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*
+  Each row gives the same flux as WindProfile with that parameter
+  vector (bit for bit). The work is done in three passes over the pool:
+  one WindProfile per row sets up the x grid and tolerance budget of
+  each component; the bins of every row and component are then cut into
+  tasks of BINS_PER_TASK bins, which the threads integrate with their
+  own WindProfile for the row; finally the components of each row are
+  combined and normalized. x grids are cached by rest energy and
+  velocity, so rows with the same line position share one, also from
+  one call to the next.
+
+  The pool is kept for the life of the object; getModelFlux should not
+  be called from two threads at once.
+*/
+class WindProfileBatch
+{
+ public:
+  // NThreads = 0 means one thread per core.
+  WindProfileBatch (ConstRealSpan energy, ModelType type, size_t NThreads = 0);
+  ~WindProfileBatch ();
+  // Same meaning as WindProfile::setTargetAccuracy.
+  void setTargetAccuracy (Real target);
+  size_t getNThreads () const {return itsPool.getNThreads ();}
+  /* parameter holds NRows parameter vectors one after the other, each
+     as passed by XSPEC (with the normalization last); flux gets the NRows
+     spectra one after the other, each with one element fewer than
+     energy. */
+  void getModelFlux (ConstRealSpan parameter, size_t NRows, RealSpan flux);
+  void getModelFlux (ConstRealSpan parameter, size_t NRows, RealArray& flux);
+  /* Finite difference stencil: flux gets the spectrum at base, then
+     one for each k, with base[index[k]] increased by delta[k]. All of
+     them are computed together, and the perturbed spectra reuse what
+     they can from base: a change of line position (or velocity,
+     except for radwind) only moves the x grid, so only the integrals
+     of Lx between the old and new bin edges are computed; any other
+     change keeps the x grid and tolerance budget of base, which also
+     keeps the integration error from differing needlessly between
+     the points of the stencil. */
+  void getStencilFlux (ConstRealSpan base, const vector<size_t>& index,
+		       ConstRealSpan delta, RealSpan flux);
+  void getStencilFlux (ConstRealSpan base, const vector<size_t>& index,
+		       ConstRealSpan delta, RealArray& flux);
+ private:
+  static const size_t BINS_PER_TASK;
+  static const size_t MAXIMUM_CACHED_GRIDS;
+  struct Row {
+    WindProfile* itsProfile;
+    // computed from the edge integrals of row 0 (see getStencilFlux)
+    bool isShifted;
+    vector<const RealArray*> itsX;
+    vector<ToleranceBudget> itsBudget;
+    vector<RealArray> itsComponent;
+  };
+  ConstRealSpan itsEnergyArray;
+  size_t itsFluxSize;
+  ModelType itsModelType;
+  Real itsTarget;
+  ThreadPool itsPool;
+  map<pair<Real, Real>, RealArray> itsXCache;
+  vector<Row> itsRow;
+  // the WindProfile each thread is integrating with, and its row
+  vector<WindProfile*> itsWorker;
+  vector<size_t> itsWorkerRow;
+  void allocateRows 
+    (ConstRealSpan parameter, size_t NRows, bool isStencil = false);
+  void evaluateRows (ConstRealSpan parameter, size_t NRows, RealSpan flux);
+  void setShiftedFlux (size_t row);
+  void freeRows ();
+  void freeWorkers ();
+  const RealArray* getX (size_t row, size_t component);
+  void integrateTask (size_t task, size_t worker, ConstRealSpan parameter,
+		      size_t NParameters);
+};
+
+#endif//WIND_PROFILE_BATCH_H
@@ -0,0 +1,115 @@
+/***************************************************************************
+    WindProfileConfig.cpp - The settings of the models (tolerance,
+                            precision, table files, ...), and the solar
+                            abundances, independent of XSPEC.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include "WindProfileConfig.h"
+#include <cstdlib>
+
+using namespace std;
+
+const size_t WindProfileConfig::N_ABUNDANCES = 30;
+
+// Anders & Grevesse (1989), the XSPEC default (angr), H to Zn
+const Real WindProfileConfig::SOLAR_ABUNDANCE[] = {
+  1.00e+00, 9.77e-02, 1.45e-11, 1.41e-11, 3.98e-10,
+  3.63e-04, 1.12e-04, 8.51e-04, 3.63e-08, 1.23e-04,
+  2.14e-06, 3.80e-05, 2.95e-06, 3.55e-05, 2.82e-07,
+  1.62e-05, 3.16e-07, 3.63e-06, 1.32e-07, 2.29e-06,
+  1.26e-09, 9.77e-08, 1.00e-08, 4.68e-07, 2.45e-07,
+  4.68e-05, 8.32e-08, 1.78e-06, 1.62e-08, 3.98e-08
+};
+
+WindProfileConfig& WindProfileConfig::instance ()
+{
+  static WindProfileConfig windProfileConfig; // calls constructor
+  return windProfileConfig;
+}
+
+WindProfileConfig::WindProfileConfig ()
+  : itsLock (), itsValues (), itsLookup (NULL), itsAbundanceLookup (NULL)
+{
+  return;
+}
+
+void WindProfileConfig::set (const string& key, const string& value)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsValues[key] = value;
+  return;
+}
+
+void WindProfileConfig::unset (const string& key)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsValues.erase (key);
+  return;
+}
+
+string WindProfileConfig::get (const string& key, const string& defaultValue)
+{
+  Lookup lookup = NULL;
+  {
+    lock_guard<mutex> guard (itsLock);
+    map<string, string>::const_iterator found = itsValues.find (key);
+    if (found != itsValues.end ()) return found->second;
+    lookup = itsLookup;
+  }
+  string value;
+  if (lookup && lookup (key, value)) return value;
+  const char* environment = getenv (key.c_str ());
+  if (environment && *environment) return string (environment);
+  return defaultValue;
+}
+
+void WindProfileConfig::setLookup (Lookup lookup)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsLookup = lookup;
+  return;
+}
+
+void WindProfileConfig::setAbundanceLookup (AbundanceLookup lookup)
+{
+  lock_guard<mutex> guard (itsLock);
+  itsAbundanceLookup = lookup;
+  return;
+}
+
+Real WindProfileConfig::getAbundance (size_t Z)
+{
+  if ((Z < 1) || (Z > N_ABUNDANCES)) return 0.;
+  AbundanceLookup lookup = NULL;
+  {
+    lock_guard<mutex> guard (itsLock);
+    lookup = itsAbundanceLookup;
+  }
+  if (lookup) return lookup (Z);
+  return SOLAR_ABUNDANCE[Z - 1];
+}
+
+/***************************/
+
+string getConfigVariable (const string& key, const string& defaultValue)
+{
+  return WindProfileConfig::instance ().get (key, defaultValue);
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+    WindProfileConfig.h   - The settings of the models (tolerance,
+                            precision, table files, ...), and the solar
+                            abundances, independent of XSPEC.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef WINDPROF_CONFIG_H
+#define WINDPROF_CONFIG_H
+
+/*
+  The models read their settings (WINDPROFTOLERANCE, WINDPROFPRECISION,
+  WINDTABSDIRECTORY, HEII, ...; see README.md) with getConfigVariable.
+  A setting is taken from, in order:
+  1. a value given with set (e.g. by a program using libwindprofile);
+  2. the lookup installed with setLookup; in the XSPEC package this is
+     xset (see XspecUtilities.cpp);
+  3. the environment variable of the same name;
+  4. the default given by the caller.
+  The solar abundances (by number, relative to H) used by the tabulated
+  absorption models are those of the installed abundance lookup (in
+  XSPEC, the abund setting), or else Anders & Grevesse (1989).
+*/
+
+#include <map>
+#include <mutex>
+#include <string>
+#include "xsTypes.h"
+
+using namespace std;
+
+// Singleton
+class WindProfileConfig
+{
+ public:
+  // Returns false if the key is not set.
+  typedef bool (*Lookup) (const string& key, string& value);
+  typedef Real (*AbundanceLookup) (size_t Z);
+  static const size_t N_ABUNDANCES;
+  static WindProfileConfig& instance ();
+  void set (const string& key, const string& value);
+  void unset (const string& key);
+  string get (const string& key, const string& defaultValue);
+  void setLookup (Lookup lookup);
+  void setAbundanceLookup (AbundanceLookup lookup);
+  // For Z = 1 to N_ABUNDANCES; 0 otherwise.
+  Real getAbundance (size_t Z);
+ private:
+  WindProfileConfig ();
+  mutex itsLock;
+  map<string, string> itsValues;
+  Lookup itsLookup;
+  AbundanceLookup itsAbundanceLookup;
+  static const Real SOLAR_ABUNDANCE[];
+  // To prevent copying and assignment:
+  WindProfileConfig (const WindProfileConfig& C);
+  WindProfileConfig operator = (const WindProfileConfig& C);
+};
+
+string getConfigVariable (const string& key, const string& defaultValue);
+
+#endif//WINDPROF_CONFIG_H
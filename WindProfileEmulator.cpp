@@ -0,0 +1,491 @@
+/***************************************************************************
+    WindProfileEmulator.cpp - A reduced basis emulator of the profile
+                              components of windprof, hwind and hewind,
+                              with an estimate of its error.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_eigen.h>
+#include "WindProfileEmulator.h"
+#include "ThreadPool.h"
+#include "Diagnostics.h"
+
+using namespace std;
+
+static const char EMULATOR_MAGIC[] = "WPEMU001";
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Any count in a file beyond this is taken to be corrupt.
+static const uint64_t MAXIMUM_COUNT = uint64_t (1) << 28;
+
+WindProfileEmulator::WindProfileEmulator ()
+  : ProfileGrid (), itsFilename (), itsBasis (), itsPointError (),
+    itsCellError ()
+{
+  return;
+}
+
+/*
+  The basis vectors are the eigenvectors of the covariance of the
+  profiles over the grid points, by decreasing eigenvalue. They are
+  rounded to single precision, as they are stored, before the
+  coefficients are computed, so that the truncation error is that of
+  the file. Each coefficient is the projection of what is left of the
+  profile after the previous basis vectors, which keeps the rounding
+  from accumulating.
+*/
+static void getPrincipalComponents
+(const vector<RealArray>& profile, RealArray& mean,
+ vector<RealArray>& basis)
+{
+  size_t NPoints = profile.size ();
+  size_t NBins = profile[0].size ();
+  mean.resize (NBins);
+  mean = 0.;
+  for (size_t j = 0; j < NPoints; j++) mean += profile[j];
+  mean /= Real (NPoints);
+  for (size_t i = 0; i < NBins; i++) mean[i] = float (mean[i]);
+  gsl_matrix* covariance = gsl_matrix_alloc (NBins, NBins);
+  gsl_matrix_set_zero (covariance);
+  RealArray deviation (NBins);
+  for (size_t j = 0; j < NPoints; j++) {
+    deviation = profile[j] - mean;
+    for (size_t a = 0; a < NBins; a++) {
+      for (size_t b = 0; b <= a; b++) {
+	Real c = gsl_matrix_get (covariance, a, b) +
+	  deviation[a] * deviation[b] / Real (NPoints);
+	gsl_matrix_set (covariance, a, b, c);
+	gsl_matrix_set (covariance, b, a, c);
+      }
+    }
+  }
+  gsl_vector* eigenvalue = gsl_vector_alloc (NBins);
+  gsl_matrix* eigenvector = gsl_matrix_alloc (NBins, NBins);
+  gsl_eigen_symmv_workspace* workspace = gsl_eigen_symmv_alloc (NBins);
+  gsl_eigen_symmv (covariance, eigenvalue, eigenvector, workspace);
+  gsl_eigen_symmv_sort (eigenvalue, eigenvector, GSL_EIGEN_SORT_VAL_DESC);
+  size_t NVectors = GSL_MIN (NBins, NPoints);
+  basis.assign (NVectors, RealArray (NBins));
+  for (size_t k = 0; k < NVectors; k++) {
+    for (size_t i = 0; i < NBins; i++) {
+      basis[k][i] = float (gsl_matrix_get (eigenvector, i, k));
+    }
+  }
+  gsl_eigen_symmv_free (workspace);
+  gsl_matrix_free (eigenvector);
+  gsl_vector_free (eigenvalue);
+  gsl_matrix_free (covariance);
+  return;
+}
+
+bool WindProfileEmulator::train
+(const ProfileGrid& grid, const vector<RealArray>& spectrum,
+ size_t maxBasis, Real truncation)
+{
+  ProfileGrid::operator= (grid);
+  itsFilename.clear ();
+  itsBasis.clear ();
+  itsPointError.clear ();
+  itsCellError.assign (getNCells (), GSL_POSINF);
+  size_t NPoints = getNPoints ();
+  size_t NBins = getNBins ();
+  size_t NComponents = getNComponents ();
+  if (spectrum.size () != NPoints * NComponents) {
+    cerr << "WindProfileEmulator: " << spectrum.size () << " spectra for "
+	 << NPoints << " grid points\n";
+    return false;
+  }
+  vector<vector<RealArray> > profile
+    (NComponents, vector<RealArray> (NPoints, RealArray (NBins)));
+  for (size_t j = 0; j < NPoints; j++) {
+    Real total = 0.;
+    for (size_t c = 0; c < NComponents; c++) {
+      if (spectrum[j * NComponents + c].size () != NBins) {
+	cerr << "WindProfileEmulator: grid point " << j << " is missing\n";
+	return false;
+      }
+      total += spectrum[j * NComponents + c].sum ();
+    }
+    if (compare (total, 0.) != 1) {
+      cerr << "WindProfileEmulator: no flux at grid point " << j << "\n";
+      return false;
+    }
+    for (size_t c = 0; c < NComponents; c++) {
+      profile[c][j] = spectrum[j * NComponents + c] / total;
+    }
+  }
+
+  itsBasis.assign (NComponents, Basis ());
+  itsPointError.assign (NPoints, 0.);
+  for (size_t c = 0; c < NComponents; c++) {
+    Basis& B = itsBasis[c];
+    vector<RealArray> basis;
+    getPrincipalComponents (profile[c], B.itsMean, basis);
+    B.itsCoefficient.assign (NPoints, RealArray ());
+    vector<RealArray> residual (NPoints, RealArray (NBins));
+    vector<Real> error (NPoints);
+    Real maximum = 0.;
+    for (size_t j = 0; j < NPoints; j++) {
+      residual[j] = profile[c][j] - B.itsMean;
+      error[j] = getError (profile[c][j] - residual[j], profile[c][j]);
+      maximum = GSL_MAX_DBL (maximum, error[j]);
+    }
+    size_t NVectors = GSL_MIN (maxBasis, basis.size ());
+    while ((maximum > truncation) && (B.itsVector.size () < NVectors)) {
+      const RealArray& e = basis[B.itsVector.size ()];
+      B.itsVector.push_back (e);
+      maximum = 0.;
+      for (size_t j = 0; j < NPoints; j++) {
+	Real a = float ((residual[j] * e).sum ());
+	residual[j] -= a * e;
+	RealArray& coefficient = B.itsCoefficient[j];
+	RealArray previous (coefficient);
+	coefficient.resize (previous.size () + 1);
+	coefficient[slice (0, previous.size (), 1)] = previous;
+	coefficient[previous.size ()] = a;
+	error[j] = getError (profile[c][j] - residual[j], profile[c][j]);
+	maximum = GSL_MAX_DBL (maximum, error[j]);
+      }
+    }
+    if (maximum > truncation) {
+      cerr << "WindProfileEmulator: with " << B.itsVector.size ()
+	   << " basis vectors, component " << c << " is only reproduced to "
+	   << maximum << "\n";
+    }
+    for (size_t j = 0; j < NPoints; j++) {
+      itsPointError[j] = GSL_MAX_DBL (itsPointError[j], error[j]);
+    }
+  }
+  return true;
+}
+
+/* Each cell is one task: the cells are independent, and each writes
+   only its own error. */
+void WindProfileEmulator::validate (Real target, size_t NThreads)
+{
+  size_t NCells = getNCells ();
+  itsCellError.assign (NCells, GSL_POSINF);
+  if (itsBasis.empty ()) return;
+  ThreadPool pool (NThreads);
+  pool.run (NCells, [&] (size_t cell, size_t) {
+      RealArray parameter;
+      getCellCentre (cell, parameter);
+      vector<RealArray> exact, emulated;
+      computeComponents (parameter, target, exact);
+      getComponents (parameter, emulated);
+      Real total = 0.;
+      for (size_t c = 0; c < exact.size (); c++) total += exact[c].sum ();
+      Real error = 0.;
+      for (size_t c = 0; c < exact.size (); c++) {
+	exact[c] /= total;
+	error = GSL_MAX_DBL (error, getError (emulated[c], exact[c]));
+      }
+      vector<size_t> point;
+      vector<Real> weight;
+      getCorners (parameter, point, weight);
+      for (size_t i = 0; i < point.size (); i++) {
+	error = GSL_MAX_DBL (error, itsPointError[point[i]]);
+      }
+      itsCellError[cell] = float (error);
+    });
+  return;
+}
+
+size_t WindProfileEmulator::getNBasis (size_t component) const
+{
+  if (component >= itsBasis.size ()) return 0;
+  return itsBasis[component].itsVector.size ();
+}
+
+Real WindProfileEmulator::getTruncationError () const
+{
+  Real maximum = 0.;
+  for (size_t j = 0; j < itsPointError.size (); j++) {
+    maximum = GSL_MAX_DBL (maximum, itsPointError[j]);
+  }
+  return maximum;
+}
+
+// The summed absolute deviation, relative to the total.
+Real WindProfileEmulator::getError
+(const RealArray& emulated, const RealArray& exact)
+{
+  Real deviation = abs (emulated - exact).sum ();
+  Real total = exact.sum ();
+  if (compare (total, 0.) != 1) return deviation;
+  return deviation / total;
+}
+
+void WindProfileEmulator::getComponents
+(ConstRealSpan parameter, vector<RealArray>& component) const
+{
+  vector<size_t> point;
+  vector<Real> weight;
+  getCorners (parameter, point, weight);
+  component.resize (itsBasis.size ());
+  for (size_t c = 0; c < itsBasis.size (); c++) {
+    const Basis& B = itsBasis[c];
+    component[c].resize (B.itsMean.size ());
+    component[c] = B.itsMean;
+    for (size_t k = 0; k < B.itsVector.size (); k++) {
+      Real a = 0.;
+      for (size_t j = 0; j < point.size (); j++) {
+	a += weight[j] * B.itsCoefficient[point[j]][k];
+      }
+      component[c] += a * B.itsVector[k];
+    }
+    for (size_t i = 0; i < component[c].size (); i++) {
+      if (component[c][i] < 0.) component[c][i] = 0.;
+    }
+  }
+  return;
+}
+
+Real WindProfileEmulator::getErrorEstimate (ConstRealSpan parameter) const
+{
+  if (itsBasis.empty () || (parameter.size () != getBase ().size ()) ||
+      !isInside (parameter) || !hasFixedParameters (parameter)) {
+    return GSL_POSINF;
+  }
+  return itsCellError[getCell (parameter)];
+}
+
+void WindProfileEmulator::getModelFlux
+(ConstRealSpan energy, ConstRealSpan parameter, RealSpan flux) const
+{
+  if (itsBasis.empty () || (parameter.size () != getBase ().size ())) {
+    for (size_t i = 0; i + 1 < energy.size (); i++) flux[i] = 0.;
+    DIAGNOSE (diagnosticError, "WindProfileEmulator::getModelFlux",
+	      "no emulator for " << parameter.size () << " parameters");
+    return;
+  }
+  vector<RealArray> component;
+  getComponents (parameter, component);
+  mapComponents (component, energy, parameter, flux);
+  return;
+}
+
+/*-------------------the emulator file----------------------*/
+
+template <typename T>
+static void writeValue (ostream& file, T value)
+{
+  file.write (reinterpret_cast<const char*> (&value), sizeof (T));
+  return;
+}
+
+static void writeString (ostream& file, const string& text)
+{
+  writeValue<uint64_t> (file, text.size ());
+  file.write (text.data (), text.size ());
+  return;
+}
+
+template <typename T>
+static void writeArray (ostream& file, const RealArray& values)
+{
+  if (values.size () == 0) return;
+  vector<T> buffer (&values[0], &values[0] + values.size ());
+  file.write (reinterpret_cast<const char*> (&buffer[0]),
+	      buffer.size () * sizeof (T));
+  return;
+}
+
+template <typename T>
+static bool readValue (istream& file, T& value)
+{
+  return bool (file.read (reinterpret_cast<char*> (&value), sizeof (T)));
+}
+
+static bool readCount (istream& file, size_t& count)
+{
+  uint64_t value = 0;
+  if (!readValue (file, value) || (value > MAXIMUM_COUNT)) return false;
+  count = value;
+  return true;
+}
+
+static bool readString (istream& file, string& text)
+{
+  size_t size;
+  if (!readCount (file, size)) return false;
+  text.resize (size);
+  return (size == 0) || bool (file.read (&text[0], size));
+}
+
+template <typename T>
+static bool readArray (istream& file, size_t size, RealArray& values)
+{
+  vector<T> buffer (size);
+  if ((size > 0) && !file.read (reinterpret_cast<char*> (&buffer[0]),
+				size * sizeof (T))) {
+    return false;
+  }
+  values.resize (size);
+  for (size_t i = 0; i < size; i++) values[i] = buffer[i];
+  return true;
+}
+
+void WindProfileEmulator::writeFile (ostream& file) const
+{
+  file.write (EMULATOR_MAGIC, 8);
+  writeValue (file, BYTE_ORDER_MARK);
+  writeString (file, getModelName ());
+  const vector<string>& names = getNames ();
+  writeValue<uint64_t> (file, names.size ());
+  for (size_t i = 0; i < names.size (); i++) writeString (file, names[i]);
+  writeArray<double> (file, getBase ());
+  writeValue<uint64_t> (file, getNGrids ());
+  for (size_t k = 0; k < getNGrids (); k++) {
+    writeString (file, getGridName (k));
+    writeValue<uint8_t> (file, isGridLog (k) ? 1 : 0);
+    writeValue<uint64_t> (file, getGridValues (k).size ());
+    writeArray<double> (file, getGridValues (k));
+  }
+  writeValue<uint64_t> (file, getX ().size ());
+  writeArray<double> (file, getX ());
+  writeValue<uint64_t> (file, itsBasis.size ());
+  for (size_t c = 0; c < itsBasis.size (); c++) {
+    const Basis& B = itsBasis[c];
+    writeValue<uint64_t> (file, B.itsVector.size ());
+    writeArray<float> (file, B.itsMean);
+    for (size_t k = 0; k < B.itsVector.size (); k++) {
+      writeArray<float> (file, B.itsVector[k]);
+    }
+    for (size_t j = 0; j < B.itsCoefficient.size (); j++) {
+      writeArray<float> (file, B.itsCoefficient[j]);
+    }
+  }
+  RealArray cellError (&itsCellError[0], itsCellError.size ());
+  writeArray<float> (file, cellError);
+  return;
+}
+
+bool WindProfileEmulator::write (const string& filename) const
+{
+  if (itsBasis.empty ()) {
+    cerr << "WindProfileEmulator: nothing to write to " << filename << "\n";
+    return false;
+  }
+  ofstream file (filename.c_str (), ios::binary);
+  if (file) writeFile (file);
+  if (!file) {
+    cerr << "WindProfileEmulator: cannot write " << filename << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool WindProfileEmulator::readFile (istream& file)
+{
+  char magic[8];
+  uint32_t mark = 0;
+  if (!file.read (magic, 8) || (string (magic, 8) != EMULATOR_MAGIC) ||
+      !readValue (file, mark)) {
+    cerr << "WindProfileEmulator: not an emulator file\n";
+    return false;
+  }
+  if (mark != BYTE_ORDER_MARK) {
+    cerr << "WindProfileEmulator: the file has the wrong byte order\n";
+    return false;
+  }
+  string model;
+  size_t NNames;
+  if (!readString (file, model) || !readCount (file, NNames)) return false;
+  vector<string> names (NNames);
+  for (size_t i = 0; i < NNames; i++) {
+    if (!readString (file, names[i])) return false;
+  }
+  RealArray base;
+  if (!readArray<double> (file, NNames, base)) return false;
+  if (!setModel (model, names, base)) return false;
+  size_t NGrids;
+  if (!readCount (file, NGrids)) return false;
+  for (size_t k = 0; k < NGrids; k++) {
+    string name;
+    uint8_t isLog;
+    size_t NValues;
+    RealArray values;
+    if (!readString (file, name) || !readValue (file, isLog) ||
+	!readCount (file, NValues) ||
+	!readArray<double> (file, NValues, values) ||
+	!addGrid (name, values, isLog == 1)) {
+      return false;
+    }
+  }
+  size_t NEdges;
+  RealArray x;
+  if (!readCount (file, NEdges) || (NEdges < 2) ||
+      !readArray<double> (file, NEdges, x)) {
+    return false;
+  }
+  setX (x);
+  size_t NComponents;
+  if (!readCount (file, NComponents) || (NComponents != getNComponents ())) {
+    return false;
+  }
+  size_t NBins = getNBins ();
+  size_t NPoints = getNPoints ();
+  itsBasis.assign (NComponents, Basis ());
+  for (size_t c = 0; c < NComponents; c++) {
+    Basis& B = itsBasis[c];
+    size_t NVectors;
+    if (!readCount (file, NVectors) ||
+	!readArray<float> (file, NBins, B.itsMean)) {
+      return false;
+    }
+    B.itsVector.assign (NVectors, RealArray ());
+    for (size_t k = 0; k < NVectors; k++) {
+      if (!readArray<float> (file, NBins, B.itsVector[k])) return false;
+    }
+    B.itsCoefficient.assign (NPoints, RealArray ());
+    for (size_t j = 0; j < NPoints; j++) {
+      if (!readArray<float> (file, NVectors, B.itsCoefficient[j])) {
+	return false;
+      }
+    }
+  }
+  RealArray cellError;
+  if (!readArray<float> (file, getNCells (), cellError)) return false;
+  itsCellError.assign (&cellError[0], &cellError[0] + cellError.size ());
+  return true;
+}
+
+bool WindProfileEmulator::read (const string& filename)
+{
+  if (filename == itsFilename) return true;
+  itsFilename.clear ();
+  itsPointError.clear ();
+  ifstream file (filename.c_str (), ios::binary);
+  if (!file || !readFile (file)) {
+    cerr << "WindProfileEmulator: cannot read " << filename << "\n";
+    itsBasis.clear ();
+    itsCellError.clear ();
+    return false;
+  }
+  itsFilename = filename;
+  return true;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+    WindProfileEmulator.h - A reduced basis emulator of the profile
+                            components of windprof, hwind and hewind,
+                            with an estimate of its error.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef WIND_PROFILE_EMULATOR_H
+#define WIND_PROFILE_EMULATOR_H
+
+/*
+  The emulator is trained on the spectra of a table (see ProfileGrid.h
+  and WindProfileTable.h) by TableModel/windemulator. The components of
+  each grid point are divided by their total, and each component is
+  expanded in the leading principal components of its normalized
+  profiles over the grid (the mean profile, plus a few basis vectors in
+  x). Only the coefficients of the basis are kept for each grid point,
+  and they are interpolated between the grid points as the table
+  interpolates its spectra; the line position, velocity and G are then
+  applied as for the table.
+
+  The error of a component is the summed absolute deviation of its
+  profile, relative to its total (so that it bounds the summed absolute
+  deviation of the renormalized model flux, for windprof and hwind);
+  the error of the emulator is that of its worst component. It is
+  estimated for each cell of the grid: the emulator is compared with
+  WindProfile at the centre of the cell, where the interpolation error
+  is largest, and with the table at its corners, for the error of the
+  truncated basis. Outside the grid, or with other values of the
+  parameters that are not on the grid, the estimate is infinite.
+
+  The file is binary, in the byte order of the machine that trained
+  the emulator (a file from a machine with the other byte order is
+  rejected). After the magic "WPEMU001" and a byte order mark, it has
+  the model, the names and values of its parameters, the grid, the x
+  bin edges, then for each component the number of basis vectors, the
+  mean, the basis vectors and the coefficients of each grid point, and
+  finally the error of each cell. The profiles, coefficients and
+  errors are single precision.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+#include "ProfileGrid.h"
+
+using namespace std;
+
+class WindProfileEmulator : public ProfileGrid
+{
+ public:
+  WindProfileEmulator ();
+  /* spectrum holds the components of every point of the grid, by point
+     then component (as WindProfileTable::getSpectrum). Each component
+     gets the fewest basis vectors (at most maxBasis) that reproduce it
+     at every grid point to within truncation. The error estimates
+     are infinite until validate is called. */
+  bool train (const ProfileGrid& grid, const vector<RealArray>& spectrum,
+	      size_t maxBasis, Real truncation);
+  /* Compares the emulator with WindProfile at the centre of each cell,
+     integrated with the accuracy goal target (see
+     WindProfile::setTargetAccuracy), on NThreads threads (0 for one
+     per core). */
+  void validate (Real target, size_t NThreads);
+  size_t getNBasis (size_t component) const;
+  // The largest error of a grid point from the truncation of the basis.
+  Real getTruncationError () const;
+  const vector<Real>& getCellErrors () const {return itsCellError;}
+  bool write (const string& filename) const;
+  // Does nothing if the file has already been read.
+  bool read (const string& filename);
+  // The error of the emulator at the parameters of a model call.
+  Real getErrorEstimate (ConstRealSpan parameter) const;
+  // The normalized profile, as the model would give it.
+  void getModelFlux
+    (ConstRealSpan energy, ConstRealSpan parameter, RealSpan flux) const;
+ private:
+  struct Basis {
+    RealArray itsMean;
+    vector<RealArray> itsVector;
+    vector<RealArray> itsCoefficient; // by point, then basis vector
+  };
+  string itsFilename;
+  vector<Basis> itsBasis; // by component
+  vector<Real> itsPointError; // from the truncation
+  vector<Real> itsCellError;
+  void getComponents
+    (ConstRealSpan parameter, vector<RealArray>& component) const;
+  void writeFile (ostream& file) const;
+  bool readFile (istream& file);
+  static Real getError (const RealArray& emulated, const RealArray& exact);
+};
+
+#endif//WIND_PROFILE_EMULATOR_H
@@ -0,0 +1,349 @@
+/***************************************************************************
+    WindProfileTable.cpp  - windprof, hwind and hewind tabulated in x on
+                            a grid of their parameters, written as an
+                            OGIP table model, and interpolated with the
+                            line position and velocity applied exactly.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#include <CCfits/CCfits>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <gsl/gsl_math.h>
+#include "WindProfileTable.h"
+#include "WindProfile.h"
+#include "Diagnostics.h"
+
+using namespace std;
+using namespace CCfits;
+
+WindProfileTable::WindProfileTable ()
+  : ProfileGrid (), itsFilename (), itsSpectrum ()
+{
+  return;
+}
+
+void WindProfileTable::setSpectrum
+(size_t point, size_t component, const RealArray& flux)
+{
+  size_t NComponents = getNComponents ();
+  if (itsSpectrum.size () != getNPoints () * NComponents) {
+    itsSpectrum.assign
+      (getNPoints () * NComponents, RealArray (0., getNBins ()));
+  }
+  RealArray& spectrum = itsSpectrum[point * NComponents + component];
+  spectrum.resize (flux.size ());
+  spectrum = flux;
+  return;
+}
+
+const RealArray& WindProfileTable::getSpectrum
+(size_t point, size_t component) const
+{
+  return itsSpectrum[point * getNComponents () + component];
+}
+
+bool WindProfileTable::isComplete () const
+{
+  return (itsSpectrum.size () == getNPoints () * getNComponents ());
+}
+
+/*
+   The columns follow OGIP/92-009; MODLUNIT is that of the normalized
+   profile times the norm. The spectra are written as floats, as XSPEC
+   expects.
+*/
+bool WindProfileTable::write (const string& filename) const
+{
+  size_t NPoints = getNPoints ();
+  size_t NComponents = getNComponents ();
+  if (!isComplete ()) {
+    cerr << "WindProfileTable: the table for " << filename
+	 << " is not complete\n";
+    return false;
+  }
+  size_t NInterpolated = getNGrids ();
+  size_t NAdditional = NComponents - 1;
+  size_t NRows = NInterpolated + NAdditional;
+  size_t NValues = 1;
+  for (size_t k = 0; k < NInterpolated; k++) {
+    NValues = max (NValues, getGridValues (k).size ());
+  }
+  try {
+    unique_ptr<FITS> pOutfile (new FITS ("!" + filename, Write));
+    PHDU& primary = pOutfile->pHDU ();
+    primary.addKey ("HDUCLASS", string ("OGIP"), "format conforms to OGIP");
+    primary.addKey ("HDUCLAS1", string ("XSPEC TABLE MODEL"),
+		    "model spectra for XSPEC");
+    primary.addKey ("HDUVERS", string ("1.0.0"), "version of format");
+    primary.addKey ("MODLNAME", getModelName (), "model tabulated");
+    primary.addKey ("MODLUNIT", string ("photons/cm^2/s"), "model units");
+    primary.addKey ("REDSHIFT", false, "no redshift parameter");
+    primary.addKey ("ADDMODEL", true, "additive model");
+
+    vector<string> names (NRows);
+    vector<int> method (NRows, 0), NumberOfValues (NRows, 0);
+    vector<Real> initial (NRows), delta (NRows), minimum (NRows),
+      maximum (NRows);
+    vector<RealArray> values (NRows, RealArray (0., NValues));
+    for (size_t k = 0; k < NInterpolated; k++) {
+      const RealArray& v = getGridValues (k);
+      names[k] = getGridName (k);
+      method[k] = isGridLog (k) ? 1 : 0;
+      initial[k] = getBase ()[getGridIndex (k)];
+      delta[k] = (v.size () > 1) ? 0.01 * (v[1] - v[0]) : -1.;
+      minimum[k] = v[0];
+      maximum[k] = v[v.size () - 1];
+      NumberOfValues[k] = int (v.size ());
+      for (size_t i = 0; i < v.size (); i++) values[k][i] = v[i];
+    }
+    for (size_t k = 0; k < NAdditional; k++) {
+      size_t row = NInterpolated + k;
+      names[row] = (k == 0) ? "Gi" : "Gf";
+      initial[row] = 1.;
+      delta[row] = -1.;
+      minimum[row] = 0.;
+      maximum[row] = 1.e3;
+    }
+    vector<string> columns, columnFormats, columnUnits;
+    ostringstream valueFormat;
+    valueFormat << NValues << "E";
+    const char* parameterColumns[] =
+      {"NAME", "METHOD", "INITIAL", "DELTA", "MINIMUM", "BOTTOM", "TOP",
+       "MAXIMUM", "NUMBVALS", "VALUE"};
+    const char* parameterFormats[] =
+      {"12A", "J", "E", "E", "E", "E", "E", "E", "J", ""};
+    for (size_t i = 0; i < 10; i++) {
+      columns.push_back (parameterColumns[i]);
+      columnFormats.push_back (parameterFormats[i]);
+      columnUnits.push_back ("");
+    }
+    columnFormats[9] = valueFormat.str ();
+    Table* parameters = pOutfile->addTable
+      ("PARAMETERS", int (NRows), columns, columnFormats, columnUnits);
+    parameters->addKey ("HDUCLASS", string ("OGIP"), "");
+    parameters->addKey ("HDUCLAS1", string ("XSPEC TABLE MODEL"), "");
+    parameters->addKey ("HDUCLAS2", string ("PARAMETERS"), "");
+    parameters->addKey ("HDUVERS", string ("1.0.0"), "");
+    parameters->addKey ("NINTPARM", int (NInterpolated),
+			"number of interpolation parameters");
+    parameters->addKey ("NADDPARM", int (NAdditional),
+			"number of additional parameters");
+    parameters->column ("NAME").write (names, 1);
+    parameters->column ("METHOD").write (method, 1);
+    parameters->column ("INITIAL").write (initial, 1);
+    parameters->column ("DELTA").write (delta, 1);
+    parameters->column ("MINIMUM").write (minimum, 1);
+    parameters->column ("BOTTOM").write (minimum, 1);
+    parameters->column ("TOP").write (maximum, 1);
+    parameters->column ("MAXIMUM").write (maximum, 1);
+    parameters->column ("NUMBVALS").write (NumberOfValues, 1);
+    parameters->column ("VALUE").writeArrays (values, 1);
+
+    size_t NBins = getNBins ();
+    vector<string> energyColumns (2), energyFormats (2, "E"),
+      energyUnits (2, "");
+    energyColumns[0] = "ENERG_LO";
+    energyColumns[1] = "ENERG_HI";
+    Table* energies = pOutfile->addTable
+      ("ENERGIES", int (NBins), energyColumns, energyFormats, energyUnits);
+    energies->addKey ("HDUCLASS", string ("OGIP"), "");
+    energies->addKey ("HDUCLAS1", string ("XSPEC TABLE MODEL"), "");
+    energies->addKey ("HDUCLAS2", string ("ENERGIES"), "");
+    energies->addKey ("HDUVERS", string ("1.0.0"), "");
+    energies->addKey ("XBINS", true, "bins in x = (E0 / E - 1) / v");
+    const RealArray& x = getX ();
+    vector<Real> lower (&x[0], &x[0] + NBins);
+    vector<Real> upper (&x[0] + 1, &x[0] + NBins + 1);
+    energies->column ("ENERG_LO").write (lower, 1);
+    energies->column ("ENERG_HI").write (upper, 1);
+
+    vector<string> spectrumColumns, spectrumFormats, spectrumUnits;
+    ostringstream parameterFormat, binFormat;
+    parameterFormat << max (NInterpolated, size_t (1)) << "E";
+    binFormat << NBins << "E";
+    spectrumColumns.push_back ("PARAMVAL");
+    spectrumFormats.push_back (parameterFormat.str ());
+    spectrumColumns.push_back ("INTPSPEC");
+    spectrumFormats.push_back (binFormat.str ());
+    for (size_t k = 0; k < NAdditional; k++) {
+      ostringstream name;
+      name << "ADDSP00" << k + 1;
+      spectrumColumns.push_back (name.str ());
+      spectrumFormats.push_back (binFormat.str ());
+    }
+    spectrumUnits.assign (spectrumColumns.size (), "");
+    Table* spectra = pOutfile->addTable
+      ("SPECTRA", int (NPoints), spectrumColumns, spectrumFormats,
+       spectrumUnits);
+    spectra->addKey ("HDUCLASS", string ("OGIP"), "");
+    spectra->addKey ("HDUCLAS1", string ("XSPEC TABLE MODEL"), "");
+    spectra->addKey ("HDUCLAS2", string ("MODEL SPECTRA"), "");
+    spectra->addKey ("HDUVERS", string ("1.0.0"), "");
+    vector<RealArray> point (NPoints, RealArray (0., max (NInterpolated,
+							  size_t (1))));
+    RealArray parameter;
+    for (size_t j = 0; j < NPoints; j++) {
+      getParameters (j, parameter);
+      for (size_t k = 0; k < NInterpolated; k++) {
+	point[j][k] = parameter[getGridIndex (k)];
+      }
+    }
+    spectra->column ("PARAMVAL").writeArrays (point, 1);
+    for (size_t c = 0; c < NComponents; c++) {
+      vector<RealArray> spectrum (NPoints);
+      for (size_t j = 0; j < NPoints; j++) {
+	spectrum[j].resize (NBins);
+	spectrum[j] = itsSpectrum[j * NComponents + c];
+      }
+      spectra->column (spectrumColumns[c + 1]).writeArrays (spectrum, 1);
+    }
+
+    vector<string> baseColumns (2), baseFormats (2), baseUnits (2, "");
+    baseColumns[0] = "NAME";
+    baseColumns[1] = "VALUE";
+    baseFormats[0] = "16A";
+    baseFormats[1] = "D";
+    Table* base = pOutfile->addTable
+      ("WINDPROF", int (getNames ().size ()), baseColumns, baseFormats,
+       baseUnits);
+    const RealArray& baseArray = getBase ();
+    vector<Real> baseValues (&baseArray[0], &baseArray[0] + baseArray.size ());
+    base->column ("NAME").write (getNames (), 1);
+    base->column ("VALUE").write (baseValues, 1);
+  }
+  catch (FitsException&) {
+    cerr << "WindProfileTable: cannot write " << filename << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool WindProfileTable::read (const string& filename)
+{
+  if (filename == itsFilename) return true;
+  itsFilename.clear ();
+  try {
+    vector<string> extensions;
+    extensions.push_back ("PARAMETERS");
+    extensions.push_back ("ENERGIES");
+    extensions.push_back ("SPECTRA");
+    extensions.push_back ("WINDPROF");
+    unique_ptr<FITS> pInfile (new FITS (filename, Read, extensions, false));
+    string model;
+    pInfile->pHDU ().readKey ("MODLNAME", model);
+    ExtHDU& base = pInfile->extension ("WINDPROF");
+    size_t NNames = base.column ("NAME").rows ();
+    vector<string> names;
+    RealArray baseValues;
+    base.column ("NAME").read (names, 1, NNames);
+    base.column ("VALUE").read (baseValues, 1, NNames);
+    for (size_t i = 0; i < names.size (); i++) {
+      names[i] = names[i].substr (0, names[i].find_last_not_of (' ') + 1);
+    }
+    if (!setModel (model, names, baseValues)) return false;
+
+    ExtHDU& parameters = pInfile->extension ("PARAMETERS");
+    int NInterpolated = 0;
+    parameters.readKey ("NINTPARM", NInterpolated);
+    if (NInterpolated > 0) {
+      vector<string> gridNames;
+      vector<int> method, NumberOfValues;
+      vector<RealArray> values;
+      parameters.column ("NAME").read (gridNames, 1, NInterpolated);
+      parameters.column ("METHOD").read (method, 1, NInterpolated);
+      parameters.column ("NUMBVALS").read (NumberOfValues, 1, NInterpolated);
+      parameters.column ("VALUE").readArrays (values, 1, NInterpolated);
+      for (int k = 0; k < NInterpolated; k++) {
+	string name = gridNames[k].substr
+	  (0, gridNames[k].find_last_not_of (' ') + 1);
+	RealArray v (values[k][slice (0, NumberOfValues[k], 1)]);
+	if (!addGrid (name, v, method[k] == 1)) return false;
+      }
+    }
+
+    ExtHDU& energies = pInfile->extension ("ENERGIES");
+    size_t NBins = energies.column ("ENERG_LO").rows ();
+    RealArray lower, upper;
+    energies.column ("ENERG_LO").read (lower, 1, NBins);
+    energies.column ("ENERG_HI").read (upper, 1, NBins);
+    RealArray x (NBins + 1);
+    x[slice (0, NBins, 1)] = lower;
+    x[NBins] = upper[NBins - 1];
+    setX (x);
+
+    ExtHDU& spectra = pInfile->extension ("SPECTRA");
+    size_t NPoints = spectra.column ("INTPSPEC").rows ();
+    if (NPoints != getNPoints ()) {
+      cerr << "WindProfileTable: " << filename << " has " << NPoints
+	   << " spectra for " << getNPoints () << " grid points\n";
+      return false;
+    }
+    size_t NComponents = getNComponents ();
+    itsSpectrum.assign (NPoints * NComponents, RealArray ());
+    for (size_t c = 0; c < NComponents; c++) {
+      ostringstream name;
+      if (c == 0) {
+	name << "INTPSPEC";
+      } else {
+	name << "ADDSP00" << c;
+      }
+      vector<RealArray> spectrum;
+      spectra.column (name.str ()).readArrays (spectrum, 1, NPoints);
+      for (size_t j = 0; j < NPoints; j++) {
+	itsSpectrum[j * NComponents + c].resize (spectrum[j].size ());
+	itsSpectrum[j * NComponents + c] = spectrum[j];
+      }
+    }
+  }
+  catch (FitsException&) {
+    cerr << "WindProfileTable: cannot read " << filename << "\n";
+    itsSpectrum.clear ();
+    return false;
+  }
+  itsFilename = filename;
+  return true;
+}
+
+void WindProfileTable::getModelFlux
+(ConstRealSpan energy, ConstRealSpan parameter, RealSpan flux) const
+{
+  if (itsSpectrum.empty () || (parameter.size () != getBase ().size ())) {
+    for (size_t i = 0; i + 1 < energy.size (); i++) flux[i] = 0.;
+    DIAGNOSE (diagnosticError, "WindProfileTable::getModelFlux",
+	      "no table for " << parameter.size () << " parameters");
+    return;
+  }
+  checkFixedParameters (parameter);
+  vector<size_t> point;
+  vector<Real> weight;
+  getCorners (parameter, point, weight);
+  size_t NComponents = getNComponents ();
+  vector<RealArray> component (NComponents, RealArray (0., getNBins ()));
+  for (size_t j = 0; j < point.size (); j++) {
+    for (size_t c = 0; c < NComponents; c++) {
+      component[c] += weight[j] * itsSpectrum[point[j] * NComponents + c];
+    }
+  }
+  mapComponents (component, energy, parameter, flux);
+  return;
+}
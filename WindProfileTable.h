@@ -0,0 +1,69 @@
+/***************************************************************************
+    WindProfileTable.h    - windprof, hwind and hewind tabulated in x on
+                            a grid of their parameters, written as an
+                            OGIP table model, and interpolated with the
+                            line position and velocity applied exactly.
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+#ifndef WIND_PROFILE_TABLE_H
+#define WIND_PROFILE_TABLE_H
+
+/*
+  A table of the profile components on a ProfileGrid (see ProfileGrid.h),
+  made by TableModel/windtable, and used by windptab, hwindtab and
+  hewindtb.
+
+  The file is an OGIP additive table model (OGIP/92-009), except that
+  the ENERGIES extension holds the x bins. The i and f components of
+  hewind are the additional spectra ADDSP001 and ADDSP002, so that
+  with both additional parameters equal to G the sum is r + G (i + f),
+  as in WindProfile::combineComponents. The extension WINDPROF lists
+  every parameter of the model, with the value it had for the table.
+*/
+
+#include <string>
+#include <vector>
+#include "xsTypes.h"
+#include "Span.h"
+#include "ProfileGrid.h"
+
+using namespace std;
+
+class WindProfileTable : public ProfileGrid
+{
+ public:
+  WindProfileTable ();
+  // The flux of a component in the x bins.
+  void setSpectrum (size_t point, size_t component, const RealArray& flux);
+  const RealArray& getSpectrum (size_t point, size_t component) const;
+  bool isComplete () const;
+  bool write (const string& filename) const;
+  // Does nothing if the file has already been read.
+  bool read (const string& filename);
+  // The normalized profile, as the model would give it.
+  void getModelFlux
+    (ConstRealSpan energy, ConstRealSpan parameter, RealSpan flux) const;
+ private:
+  string itsFilename;
+  vector<RealArray> itsSpectrum; // by point, then component
+};
+
+#endif//WIND_PROFILE_TABLE_H
@@ -23,6 +23,7 @@
 
 
 #include "XspecUtilities.h"
+#include "WindProfileConfig.h"
 //#include <XSUtil/FunctionUtils/FunctionUtility.h>
 //#include <FunctionUtility.h>
 #include <XSFunctions/Utilities/FunctionUtility.h>
@@ -37,3 +38,32 @@ string getXspecVariable (string XspecVariableName, string defaultValue)
     return pvalue;
   return defaultValue;
 }
+
+/* The XSPEC layer over libwindprofile: the settings of the models come
+   from xset, and the abundances from abund (see WindProfileConfig).
+   They are installed when the model package is loaded. */
+
+static bool lookupXspecVariable (const string& key, string& value)
+{
+  string pvalue (FunctionUtility::getModelString (key));
+  if (pvalue.length () && pvalue != FunctionUtility::NOT_A_KEY ()) {
+    value = pvalue;
+    return true;
+  }
+  return false;
+}
+
+static Real lookupXspecAbundance (size_t Z)
+{
+  return FunctionUtility::getAbundance (Z);
+}
+
+static bool installXspecConfig ()
+{
+  WindProfileConfig& C = WindProfileConfig::instance ();
+  C.setLookup (lookupXspecVariable);
+  C.setAbundanceLookup (lookupXspecAbundance);
+  return true;
+}
+
+static const bool isXspecConfig = installXspecConfig ();
@@ -25,9 +25,12 @@
 #include "calorimeterLSF.h"
 #include "Utilities.h"
 #include <iostream>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_sf_erf.h>
 
 calorimeterLSF::calorimeterLSF (Real sigma, Real eTau, Real elc_tail_ratio, Real E0) 
-  : itsSigma (sigma), itsETau (eTau), itsELCTailRatio (elc_tail_ratio), itsE0 (E0)
+  : itsSigma (sigma), itsETau (eTau), itsELCTailRatio (elc_tail_ratio), itsE0 (E0),
+    itsTailNorm (0.), itsFlatNorm (0.)
 {
   checkInput ();
   allocateClasses ();
@@ -54,6 +57,9 @@ void calorimeterLSF::checkInput ()
     itsELCTailRatio = 0.;
     cerr << "calorimeterLSF: nflat < 0, setting nflat = 0\n";
   }
+  // same normalization as electronLossContinuum::integrand
+  itsTailNorm = 1. / (itsELCTailRatio + 1.);
+  itsFlatNorm = itsELCTailRatio * itsTailNorm / itsE0;
   return;
 }
 
@@ -74,7 +80,77 @@ double calorimeterLSF::integrand (double deltaE)
   return itsELC->getELC (deltaE);
 }
 
+/* deltaE1 > deltaE2 (energy increases as deltaE decreases). */
 Real calorimeterLSF::getLSF (Real deltaE1, Real deltaE2)
+{
+  Real tail = getTailCDF (deltaE1) - getTailCDF (deltaE2);
+  if ((deltaE1 > 0.) && !(deltaE2 > 0.)) tail += 1.;
+  if (!(deltaE1 > 0.) && (deltaE2 > 0.)) tail -= 1.;
+  Real flat = getFlatCDF (deltaE1) - getFlatCDF (deltaE2);
+  return (itsTailNorm * tail + itsFlatNorm * flat);
+}
+
+/* flux[j] is the LSF between deltaE[j] and deltaE[j+1]. */
+void calorimeterLSF::getLSF (const RealArray& deltaE, RealArray& flux)
+{
+  size_t esize = deltaE.size ();
+  if (esize < 2) {
+    flux.resize (0);
+    return;
+  }
+  flux.resize (esize - 1);
+  Real previousTail = getTailCDF (deltaE[0]);
+  Real previousFlat = getFlatCDF (deltaE[0]);
+  for (size_t j = 0; j < esize - 1; j++) {
+    Real currentTail = getTailCDF (deltaE[j+1]);
+    Real currentFlat = getFlatCDF (deltaE[j+1]);
+    Real tail = previousTail - currentTail;
+    if ((deltaE[j] > 0.) && !(deltaE[j+1] > 0.)) tail += 1.;
+    if (!(deltaE[j] > 0.) && (deltaE[j+1] > 0.)) tail -= 1.;
+    flux[j] = itsTailNorm * tail + itsFlatNorm * (previousFlat - currentFlat);
+    previousTail = currentTail;
+    previousFlat = currentFlat;
+  }
+  return;
+}
+
+/* Cumulative distribution F of the Gaussian convolved with the 
+   normalized exponential tail, from deltaE = -infinity. To avoid 
+   cancellation, this returns F for deltaE <= 0, and F - 1 (minus the 
+   survival function) for deltaE > 0; the caller adds back the 1.
+   With x = deltaE / sigma, s = sigma / eTau:
+   F = Phi (x) - exp (s^2 / 2 - s x) Phi (x - s)
+   1 - F = Phi (-x) + exp (s^2 / 2 - s x) Phi (x - s) */
+Real calorimeterLSF::getTailCDF (Real deltaE)
+{
+  bool isUpper = (deltaE > 0.);
+  if (compare (itsSigma, 0.) == 0) { // pure exponential
+    if (!isUpper || (compare (itsETau, 0.) == 0)) return 0.;
+    return (-1. * exp (-1. * deltaE / itsETau));
+  }
+  Real x = deltaE / itsSigma;
+  Real Phi = 0.5 * gsl_sf_erfc (fabs (x) / M_SQRT2); // Phi (-|x|)
+  if (compare (itsETau, 0.) == 0) { // pure Gaussian
+    return (isUpper ? -1. * Phi : Phi);
+  }
+  Real s = itsSigma / itsETau;
+  Real exponent = 0.5 * s * s - s * x + gsl_sf_log_erfc ((s - x) / M_SQRT2);
+  Real modified = 0.5 * exp (exponent);
+  return (isUpper ? -1. * (Phi + modified) : Phi - modified);
+}
+
+/* Integral of the Gaussian convolved with the unit step from 
+   deltaE = -infinity: sigma (x Phi (x) + phi (x)). */
+Real calorimeterLSF::getFlatCDF (Real deltaE)
+{
+  if (compare (itsSigma, 0.) == 0) return GSL_MAX_DBL (deltaE, 0.);
+  Real x = deltaE / itsSigma;
+  Real Phi = 0.5 * gsl_sf_erfc (-1. * x / M_SQRT2);
+  Real phi = exp (-0.5 * x * x) / sqrt (2. * M_PI);
+  return (itsSigma * (x * Phi + phi));
+}
+
+Real calorimeterLSF::getLSFQuadrature (Real deltaE1, Real deltaE2)
 {
   //  Real answer = qags (deltaE2, deltaE1);
   //  Real answer = qng (deltaE2, deltaE1);
@@ -90,6 +166,8 @@ Real calorimeterLSF::getLSF (Real deltaE1, Real deltaE2)
   if (status) {
     cout << deltaE1 << " " << deltaE2 << " " << answer << "\n";
     cout << integrand (deltaE1) << " " << integrand (deltaE2) << "\n";
+    // retry with the singularity-handling rule
+    answer = qags (deltaE2, deltaE1);
   }
-  return qags (deltaE2, deltaE1);
+  return answer;
 }
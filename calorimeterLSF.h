@@ -28,12 +28,29 @@
 #include "mal_integration.h"
 #include "electronLossContinuum.h"
 
+/*
+  getLSF integrates the electron loss continuum and exponential tail 
+  (see electronLossContinuum) over deltaE2 < deltaE < deltaE1, by 
+  differencing their cumulative distributions, which are closed forms:
+  the Gaussian convolved with the exponential tail is an exponentially 
+  modified Gaussian, and the Gaussian convolved with the flat ELC 
+  integrates to sigma (x Phi(x) + phi(x)), x = deltaE / sigma.
+  The array version evaluates each bin edge once.
+  getLSFQuadrature is the original nested quadrature, kept as a 
+  reference for checking.
+*/
 class calorimeterLSF : public Integral
 {
  public:
   calorimeterLSF (Real sigma, Real eTau, Real elc_tail_ratio, Real E0);
   ~calorimeterLSF ();
   Real getLSF (Real deltaE1, Real deltaE2);
+  void getLSF (const RealArray& deltaE, RealArray& flux);
+  Real getLSFQuadrature (Real deltaE1, Real deltaE2);
+  // Unnormalized cumulative distributions of the two components 
+  // (see the .cpp for the conventions); also used by LSFConvolution.
+  Real getTailCDF (Real deltaE);
+  Real getFlatCDF (Real deltaE);
   double integrand (double deltaE);
  private:
   void allocateClasses ();
@@ -43,6 +60,8 @@ class calorimeterLSF : public Integral
   Real itsETau; // Characteristic energy scale of electron loss continuuum
   Real itsELCTailRatio;
   Real itsE0;
+  Real itsTailNorm; // fraction in the exponential tail
+  Real itsFlatNorm; // fraction in the flat ELC, per unit E0
   electronLossContinuum* itsELC;
 };
 
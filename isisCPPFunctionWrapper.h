@@ -21,6 +21,14 @@
     along with this program; if not, write to the Free Software
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
+#ifndef ISIS_CPP_FUNCTION_WRAPPER_H
+#define ISIS_CPP_FUNCTION_WRAPPER_H
+
+#include <string>
+#include "xsTypes.h"
+
+using namespace std;
+
 /*NParameters is the number listed in the model definition in lmodel.dat;
   this number is one smaller than the actual number of parameters in the
   array const Real* parameter, which also includes normalization. */
@@ -29,3 +37,5 @@ void isisCPPFunctionWrapper
  Real* flux, Real* fluxError, const char* init, size_t NParameters,
  void (*FunctionPointer) (const RealArray&, const RealArray&, int,
 			  RealArray&, RealArray&, const string&));
+
+#endif//ISIS_CPP_FUNCTION_WRAPPER_H
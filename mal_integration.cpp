@@ -21,13 +21,28 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
 
 #include "mal_integration.h"
+#include "IntegrationProfiler.h"
+#include "Diagnostics.h"
+#include <cmath>
 
 using namespace std;
 
+// Maximum number of step halvings for tanh-sinh; level k uses step 2^-k,
+// so the last level has about 12 * 2^TANH_SINH_MAX_LEVEL abscissae.
+const size_t Integral::TANH_SINH_MAX_LEVEL = 7;
+// Largest value of the tanh-sinh variable t. Beyond this the distance
+// of the abscissae from the endpoints underflows.
+const double Integral::TANH_SINH_MAX_T = 6.5;
+// Tolerance of every integration at reference precision. The nested
+// integrals are then accurate to far below the default 1.e-4, but 
+// still well above roundoff.
+const double Integral::REFERENCE_EPSREL = 1.e-8;
+bool Integral::isReference = false;
+
 Integral::Integral (size_t limit, double epsrel, double epsabs)
   : itsEpsAbs (epsabs), itsEpsRel (epsrel), itsLimit (limit),
-    isAllocated (false), itsStatus (0), itsResult (0.), itsAbsErr (0.), 
-    itsNEval (0), itsNCalls (0)
+    isTanhSinh (false), isAllocated (false), itsStatus (0), itsResult (0.), 
+    itsAbsErr (0.), itsNEval (0), itsNCalls (0)
 {
   F.function = &integrandGSL;
   F.params = (Integral*) this;
@@ -109,9 +124,12 @@ void Integral::FreeWorkspace ()
 // Non-adaptive integration on the interval [a,b]
 double Integral::qng (double a, double b)
 {
+  if (isReference) return qag (a, b);
+  PROFILE_INTEGRATION (false);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qng 
-    (&F, a, b, itsEpsAbs, itsEpsRel, &itsResult, &itsAbsErr, &itsNEval);
+    (&F, a, b, getWorkingEpsAbs (), getWorkingEpsRel (), &itsResult, 
+     &itsAbsErr, &itsNEval);
   if (itsStatus) {
     handleError ("qng");
     return 0.;
@@ -124,14 +142,16 @@ double Integral::qng (double a, double b)
 double Integral::qag (double a, double b, int key)
 {
   if ((key > 6) || (key < 1)) {
-    cerr << "Integral::qag: key " << key << " not valid.\n";
-    cerr << "Setting key to 1.\n";
+    DIAGNOSE (diagnosticWarning, "Integral::qag",
+	      "Integral::qag: key " << key << " not valid. Setting key to 1.");
     key = 1;
   }
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qag 
-    (&F, a, b, itsEpsAbs, itsEpsRel, itsLimit, key, itsWorkspace, 
-     &itsResult, &itsAbsErr);
+    (&F, a, b, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, key, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qag");
     return 0.;
@@ -142,10 +162,12 @@ double Integral::qag (double a, double b, int key)
 // Adaptive integration with arbitrary singularities on [a,b]
 double Integral::qags (double a, double b)
 {
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qags
-    (&F, a, b, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, 
-     &itsResult, &itsAbsErr);
+    (&F, a, b, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qags");
     return 0.;
@@ -157,10 +179,12 @@ double Integral::qags (double a, double b)
 // pts[0] and pts[npts-1] give the endpoints of the integration.
 double Integral::qagp (double* pts, size_t npts)
 {
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qagp 
-    (&F, pts, npts, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, 
-     &itsResult, &itsAbsErr);
+    (&F, pts, npts, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qagp (N pts)");
     return 0.;
@@ -175,13 +199,14 @@ double Integral::qagp (double a, double b)
   double pts[2];
   pts[0] = a;
   pts[1] = b;
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qagp 
-    (&F, pts, npts, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, 
-     &itsResult, &itsAbsErr);
+    (&F, pts, npts, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
-    handleError ("qagp (2 points)");
-    cout << "a, b: " << a << ", " << b << endl;
+    handleError ("qagp (2 points)", a, b);
     return 0.;
   }
   return itsResult;
@@ -190,9 +215,12 @@ double Integral::qagp (double a, double b)
 // Adaptive integration on [-infinity, infinity]
 double Integral::qagi ()
 {
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qagi
-    (&F, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, &itsResult, &itsAbsErr);
+    (&F, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, itsWorkspace, 
+     &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qagi");
     return 0.;
@@ -203,10 +231,12 @@ double Integral::qagi ()
 // Adaptive integration on [a, infinity]
 double Integral::qagiu (double a)
 {
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qagiu
-    (&F, a, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, &itsResult, 
-     &itsAbsErr);
+    (&F, a, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qagiu");
     return 0.;
@@ -217,10 +247,12 @@ double Integral::qagiu (double a)
 // Adaptive integration on [-infinity, b]
 double Integral::qagil (double b)
 {
+  PROFILE_INTEGRATION (true);
   gsl_set_error_handler_off ();
   itsStatus = gsl_integration_qagil
-    (&F, b, itsEpsAbs, itsEpsRel, itsLimit, itsWorkspace, &itsResult, 
-     &itsAbsErr);
+    (&F, b, getWorkingEpsAbs (), getWorkingEpsRel (), itsLimit, 
+     itsWorkspace, &itsResult, &itsAbsErr);
+  acceptRoundoff ();
   if (itsStatus) {
     handleError ("qagil");
     return 0.;
@@ -228,6 +260,127 @@ double Integral::qagil (double b)
   return itsResult;
 }
 
+// Tanh-sinh integration on [a,b]; see tanhSinh for details.
+double Integral::qts (double a, double b)
+{
+  if (isReference) return qagp (a, b);
+  tanhSinh (a, b);
+  if (itsStatus) {
+    handleError ("qts", a, b);
+    return 0.;
+  }
+  return itsResult;
+}
+
+// Integration with endpoint singularities on [a,b], using tanh-sinh 
+// if the derived class asked for it, and qagp otherwise. 
+// qagp is also the fallback if tanh-sinh doesn't converge, which can 
+// happen if the integrand has kinks inside [a,b].
+double Integral::qendpoints (double a, double b)
+{
+  if (isTanhSinh && tryTanhSinh (a, b)) return itsResult;
+  return qagp (a, b);
+}
+
+bool Integral::tryTanhSinh (double a, double b)
+{
+  if (isReference) return false;
+  tanhSinh (a, b);
+  return (itsStatus == 0);
+}
+
+// Tanh-sinh (double exponential) quadrature. The substitution
+// x = c + h tanh (pi/2 sinh (t)) maps [a,b] onto the real line and 
+// makes the integrand decay double exponentially in t, so the 
+// trapezoidal rule in t converges very quickly, even for integrable
+// singularities at the endpoints. The step in t is halved at each level, 
+// reusing the previous abscissae, until the difference between 
+// successive levels shows that the tolerance has been reached.
+// The distance of each abscissa from the nearest endpoint is computed
+// directly (rather than as b - x) so that there is no cancellation 
+// near the endpoints.
+double Integral::tanhSinh (double a, double b)
+{
+  PROFILE_INTEGRATION (false);
+  double h = 0.5 * (b - a);
+  itsResult = 0.;
+  itsAbsErr = 0.;
+  itsStatus = 0;
+  if (h == 0.) return itsResult;
+  double step = 1.;
+  double sum = 0.;
+  double previous = 0.;
+  double previousDifference = 0.;
+  double lastTerm = 0.;
+  double tMax = TANH_SINH_MAX_T;
+  for (size_t level = 0; level <= TANH_SINH_MAX_LEVEL; level++) {
+    // At level 0 all integer t are used (starting with t = 0);
+    // after that, only the new points at odd multiples of the step.
+    double t = (level == 0) ? 0. : step;
+    double increment = (level == 0) ? step : 2. * step;
+    for (; t <= tMax; t += increment) {
+      double s = M_PI_2 * sinh (t);
+      double e = exp (-2. * s);
+      double distance = h * 2. * e / (1. + e); // distance from endpoint
+      double weight = M_PI_2 * cosh (t) * 4. * e / ((1. + e) * (1. + e));
+      double term = 0.;
+      if (t == 0.) {
+	term = weight * GSL_FN_EVAL (&F, a + h);
+      } else {
+	// Skip abscissae that can't be distinguished from the endpoints.
+	// Stop when there are none left on either side.
+	bool isLeft = (a + distance != a);
+	bool isRight = (b - distance != b);
+	if (!isLeft && !isRight) {
+	  if (level == 0) tMax = t - step;
+	  break;
+	}
+	if (isLeft) term += weight * GSL_FN_EVAL (&F, a + distance);
+	if (isRight) term += weight * GSL_FN_EVAL (&F, b - distance);
+      }
+      sum += term;
+      if (level == 0) {
+	lastTerm = fabs (term);
+	// Truncate once the terms are negligible.
+	if (t > 0. && lastTerm <= GSL_DBL_EPSILON * fabs (sum)) {
+	  tMax = t;
+	  break;
+	}
+      }
+    }
+    itsResult = h * step * sum;
+    if (!gsl_finite (itsResult)) {
+      itsStatus = GSL_EDIVERGE;
+      return itsResult;
+    }
+    if (level > 0) {
+      double difference = fabs (itsResult - previous);
+      double tolerance = GSL_MAX_DBL (itsEpsAbs, itsEpsRel * fabs (itsResult));
+      // The difference between levels is really the error of the 
+      // previous level. Convergence is roughly quadratic, so once the 
+      // differences are shrinking, the error of this level is estimated
+      // by extrapolating their ratio.
+      itsAbsErr = difference;
+      if ((level > 1) && (difference < previousDifference)) {
+	itsAbsErr = difference * difference / previousDifference;
+      }
+      previousDifference = difference;
+      // Don't trust agreement between the two coarsest levels, which 
+      // can be accidental.
+      if ((level > 1) && (itsAbsErr <= tolerance)) {
+	// If the sum was cut off at the largest t with terms that are 
+	// still not negligible, the singularity is too strong.
+	if (h * lastTerm > tolerance) itsStatus = GSL_EDIVERGE;
+	return itsResult;
+      }
+    }
+    previous = itsResult;
+    step *= 0.5;
+  }
+  itsStatus = GSL_EMAXITER;
+  return itsResult;
+}
+
 // Static function to call the real integrand.
 // Also counts the number of calls.
 double Integral::integrandGSL (double x, void* object)
@@ -237,20 +390,41 @@ double Integral::integrandGSL (double x, void* object)
   return ThisIntegral->integrand (x);
 }
 
-void Integral::handleError (string functionName) {
-  cout << "GSL error in " << functionName << endl;
-  if (itsStatus == GSL_EDIVERGE) {
-    cout << "Error code is GSL_EDIVERGE; integral is not converging." 
-	 << endl;
-  } else if (itsStatus == GSL_EINVAL) {
-    cout << "Error code is GSL_EINVAL. Some input was invalid.";
-  } else if (itsStatus == GSL_EMAXITER) {
-    cout << "Error code is GSL_EMAXITER. Integration exceeded maximum number of iterations.";
-  } else if (itsStatus == GSL_EROUND) {
-    cout << "Error code is GSL_EROUND. Integration failed because of roundoff error.";
-  } else {
-    cout << "Error code number is " << itsStatus << endl;
+// At reference precision the tolerance may be below what roundoff 
+// allows; GSL still returns its best estimate, which is then used.
+void Integral::acceptRoundoff ()
+{
+  if (isReference && (itsStatus == GSL_EROUND)) itsStatus = GSL_SUCCESS;
+  return;
+}
+
+const char* Integral::describeError (int status)
+{
+  switch (status) {
+  case GSL_EDIVERGE: return "integral is not converging";
+  case GSL_EINVAL: return "some input was invalid";
+  case GSL_EMAXITER: return "exceeded maximum number of iterations";
+  case GSL_EROUND: return "failed because of roundoff error";
+  default: return "unexpected error";
   }
-  cout << "Please send debugging information to Maurice." << endl;
+}
+
+// One message per failure, since this is called inside the nested
+// integrals (see Diagnostics for the rate limit).
+void Integral::handleError (const string& functionName)
+{
+  DIAGNOSE (diagnosticWarning, "Integral::handleError",
+	    "GSL error in " << functionName << ": "
+	    << describeError (itsStatus) << " (code " << itsStatus
+	    << "). Please send debugging information to Maurice.");
+  return;
+}
+
+void Integral::handleError (const string& functionName, double a, double b)
+{
+  DIAGNOSE (diagnosticWarning, "Integral::handleError",
+	    "GSL error in " << functionName << " on [" << a << ", " << b
+	    << "]: " << describeError (itsStatus) << " (code " << itsStatus
+	    << "). Please send debugging information to Maurice.");
   return;
 }
@@ -80,11 +80,35 @@ class Integral
   double qagi (); // adaptive from -infinity to infinity
   double qagiu (double a); // adaptive from a to infinity
   double qagil (double b); // adaptive from -infinity to b
+  // Tanh-sinh (double exponential) quadrature on [a,b]. This is not
+  // from GSL. It is meant for integrable endpoint singularities, 
+  // e.g. power laws u^q with q > -1, which it handles with a few dozen
+  // integrand evaluations. The integrand is never evaluated at a or b.
+  double qts (double a, double b);
+  // Integral on [a,b] with only endpoint singularities, using whichever 
+  // backend the derived class has selected with setTanhSinh. If tanh-sinh
+  // fails to converge it falls back on qagp.
+  double qendpoints (double a, double b);
+  // Tanh-sinh on [a,b] for a caller with its own fallback: false, with
+  // no error report, if it did not converge (or at reference precision,
+  // where it is not used); the result is then getResult ().
+  bool tryTanhSinh (double a, double b);
+  void setTanhSinh (bool tanhsinh) {isTanhSinh = tanhsinh; return;}
+  bool getTanhSinh () const {return isTanhSinh;}
   // If you want to change the accuracy goal of the integration. 
   //   Setting either parameter individually zeroes out the other.
   void setEpsAbs (double epsabs); 
   void setEpsRel (double epsrel); // default 1.e-4
   void setEps (double epsabs, double epsrel);
+  // Reference precision, for checking the faster settings against: 
+  // every integration is done to REFERENCE_EPSREL with no absolute
+  // tolerance, qng and tanh-sinh are replaced by the adaptive GSL 
+  // routines, and a result limited only by roundoff is accepted. 
+  // It applies to all instances, so it must not be changed while a 
+  // model is being evaluated.
+  static void setReference (bool reference) {isReference = reference; return;}
+  static bool getReference () {return isReference;}
+  static const double REFERENCE_EPSREL;
   // Changes the size of the workspace; deallocates and reallocates memory.
   void setLimit (size_t limit); // default 1000
   size_t getLimit () const {return itsLimit;}
@@ -100,11 +124,18 @@ class Integral
   double getAbsErr () const {return itsAbsErr;}
   size_t getNEval () const {return itsNEval;} // for qng only
   size_t getNCalls () const {return itsNCalls;}
+  // subintervals used by the last adaptive integration
+  size_t getNIntervals () const {return itsWorkspace->size;}
  private:
   // settings
   double itsEpsAbs;
   double itsEpsRel;
   size_t itsLimit;
+  bool isTanhSinh; // backend for qendpoints; default is qagp
+  static bool isReference;
+  // tanh-sinh settings
+  static const size_t TANH_SINH_MAX_LEVEL;
+  static const double TANH_SINH_MAX_T;
   // gsl integration objects
   gsl_function F;
   gsl_integration_workspace* itsWorkspace;
@@ -117,7 +148,14 @@ class Integral
   size_t itsNCalls; // for others
   void AllocateWorkspace ();
   void FreeWorkspace ();
-  void handleError (string functionName);
+  void handleError (const string& functionName);
+  void handleError (const string& functionName, double a, double b);
+  static const char* describeError (int status);
+  double getWorkingEpsAbs () const {return isReference ? 0. : itsEpsAbs;}
+  double getWorkingEpsRel () const
+  {return isReference ? REFERENCE_EPSREL : itsEpsRel;}
+  void acceptRoundoff ();
+  double tanhSinh (double a, double b); // qts without the error report
   Integral (const Integral& I); // no copy constructor
   //  Integral operator = (const Integral& I); //no assignment operator
 };
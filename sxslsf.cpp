@@ -26,6 +26,10 @@
 #include "calorimeterLSF.h"
 #include "Gaussian.h"
 #include "isisCPPFunctionWrapper.h"
+#include "WindProfileConfig.h"
+#include "IntegrationProfiler.h"
+#include "PrecisionSchedule.h"
+#include "Diagnostics.h"
 #include <gsl/gsl_poly.h>
 
 static const size_t SXSLSF_N_PARAMETERS (5);
@@ -62,6 +66,12 @@ void sxslsf
  /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
+  PROFILE_MODEL_CALL ("sxslsf", getConfigVariable ("WINDPROFPROFILE", ""));
+  DIAGNOSTICS_MODEL_CALL
+    ("sxslsf", getConfigVariable ("WINDPROFDIAGNOSTICS", ""));
+  // reference precision for checking (see PrecisionSchedule)
+  PrecisionSchedule::instance ().setMode
+    (getConfigVariable ("WINDPROFPRECISION", "FULL"));
   size_t esize = energy.size ();
   size_t fsize = esize - 1;
   flux.resize (fsize);
@@ -79,17 +89,15 @@ void sxslsf
   Real bin_size_KEV = energy[2] - energy[1];
   Real bin_fraction = bin_size_KEV / e0KEV;
   calorimeterLSF CLSF (sigmaKEV, etailKEV, elc_tail_ratio, e0KEV); 
-  for (size_t j=0; j<fsize; j++) {
-    flux[j] = CLSF.getLSF (deltaE[j], deltaE[j+1]);
-  }
+  CLSF.getLSF (deltaE, flux);
   Real total = flux.sum ();
-  cout << "CLSF total:\t" << total << endl; 
+  DIAGNOSE (diagnosticDebug, "sxslsf", "CLSF total:\t" << total);
   flux *= elc_tail_sum;
   Real sigmaC = sigmaKEV / e0KEV;
   Gaussian G (energy, e0KEV, sigmaC);
   RealArray gflux (fsize);
   G.getFlux (gflux);
-  cout << "gflux total:\t" << gflux.sum () << endl; 
+  DIAGNOSE (diagnosticDebug, "sxslsf", "gflux total:\t" << gflux.sum ());
   flux += gflux * (1. - ftail);
   return;
 }
@@ -6,6 +6,10 @@
 #include "isisCPPFunctionWrapper.h"
 #include <gsl/gsl_const_cgsm.h>
 #include "LoadWindAbsorptionTables.h"
+#include "WindProfileConfig.h"
+#include "IntegrationProfiler.h"
+#include "Diagnostics.h"
+#include "PrecisionSchedule.h"
 
 static const Real CONST_HC_KEV_A = GSL_CONST_CGSM_PLANCKS_CONSTANT_H * 
     GSL_CONST_CGSM_SPEED_OF_LIGHT * 1.e5 / GSL_CONST_CGSM_ELECTRON_VOLT;
@@ -28,6 +32,13 @@ void windcabs
 {
   // ------------------- Initialize -----------------------
 
+  PROFILE_MODEL_CALL ("windcabs", getConfigVariable ("WINDPROFPROFILE", ""));
+  DIAGNOSTICS_MODEL_CALL
+    ("windcabs", getConfigVariable ("WINDPROFDIAGNOSTICS", ""));
+  // reference precision for checking (see PrecisionSchedule)
+  PrecisionSchedule::instance ().setMode
+    (getConfigVariable ("WINDPROFPRECISION", "FULL"));
+
   size_t energySize = energy.size ();
   size_t fluxSize = energySize - 1;
   fluxError.resize (0);
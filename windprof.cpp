@@ -24,8 +24,20 @@
 #include "xsTypes.h"
 #include "WindProfile.h"
 #include "WindAbsorptionProfile.h"
-#include "isisCPPFunctionWrapper.h"
 #include "NParameters.h"
+#include "WindProfileConfig.h"
+#include "PrecisionSchedule.h"
+#include "FastMath.h"
+#include "IntegrationProfiler.h"
+#include "Diagnostics.h"
+#include "OpticalDepth.h"
+#include "Span.h"
+#include "WindProfileEmulator.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <sstream>
 
 //static const size_t WINDPROF_N_PARAMETERS (18);
 //static const size_t HWIND_N_PARAMETERS (18);
@@ -77,105 +89,258 @@ extern "C" void C_abswind
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
  Real* flux, Real* fluxError, const char* init);
 
+// Accuracy goal for the renormalized profile (see ToleranceBudget).
+// Setting it to 0 gives the old fixed epsrel on every integral.
+// It is loosened early in a fit if WINDPROFPRECISION is progressive 
+// (see PrecisionSchedule); the state is kept per model and spectrum.
+// At reference precision there is no budget (see Integral::setReference).
+static Real getTargetAccuracy 
+(const string& model, ConstRealSpan parameter, int spectrum)
+{
+  PrecisionSchedule& P = PrecisionSchedule::instance ();
+  if (P.getMode () == referencePrecision) return 0.;
+  ostringstream key;
+  key << model << spectrum;
+  Real target = 
+    atof (getConfigVariable ("WINDPROFTOLERANCE", "1.e-4").c_str ());
+  return target * P.getFactor (key.str (), parameter);
+}
+
+// Approximate exp, log, pow and exprel in the integrands (see FastMath),
+// except at reference precision.
+static bool getFastMathSwitch ()
+{
+  if (PrecisionSchedule::instance ().getMode () == referencePrecision) {
+    return false;
+  }
+  return (atoi (getConfigVariable ("WINDPROFFASTMATH", "0").c_str ()) == 1);
+}
+
+// With AUTO, a numerical optical depth may be evaluated by a faster
+// equivalent (see OpticalDepth.h), except at reference precision.
+static bool getAutomaticOpticalDepthSwitch ()
+{
+  if (PrecisionSchedule::instance ().getMode () == referencePrecision) {
+    return false;
+  }
+  string backend = getConfigVariable ("WINDPROFOPTICALDEPTH", "SWITCH");
+  for (size_t i = 0; i < backend.size (); i++) {
+    backend[i] = toupper (backend[i]);
+  }
+  return (backend == "AUTO");
+}
+
+// This also switches reference precision on or off for all integrals.
+static void setPrecisionMode ()
+{
+  PrecisionSchedule& P = PrecisionSchedule::instance ();
+  P.setMode (getConfigVariable ("WINDPROFPRECISION", "FULL"));
+  return;
+}
+
+/*
+  If an emulator file is given for windprof, hwind or hewind (with the
+  setting WINDPROFEMULATOR, HWINDEMULATOR or HEWINDEMULATOR; see
+  WindProfileEmulator), it gives the flux whenever its error estimate
+  at the parameters of the call is within WINDPROFEMULATORTOLERANCE;
+  otherwise (e.g. outside the grid it was trained on) the profile is
+  integrated as usual. It is not used at reference precision. Each
+  call reports which it did (debug for the emulator, info for the
+  integration).
+*/
+static bool emulate
+(ConstRealSpan energy, ConstRealSpan parameter, RealSpan flux,
+ const string& model)
+{
+  ModelType type;
+  if (!ProfileGrid::getModelType (model, type)) return false;
+  if (PrecisionSchedule::instance ().getMode () == referencePrecision) {
+    return false;
+  }
+  string key (model);
+  for (size_t i = 0; i < key.size (); i++) key[i] = toupper (key[i]);
+  key += "EMULATOR";
+  string filename = getConfigVariable (key, "");
+  if (filename.empty ()) return false;
+  static map<string, WindProfileEmulator> theEmulators;
+  WindProfileEmulator& emulator = theEmulators[model];
+  if (!emulator.read (filename)) return false;
+  if (emulator.getModelName () != model) {
+    DIAGNOSE (diagnosticError, "emulator",
+	      model << ": " << filename << " is an emulator of "
+	      << emulator.getModelName () << ", not " << model);
+    return false;
+  }
+  Real tolerance = atof
+    (getConfigVariable ("WINDPROFEMULATORTOLERANCE", "1.e-3").c_str ());
+  Real error = emulator.getErrorEstimate (parameter);
+  if (isinf (error)) {
+    DIAGNOSE (diagnosticInfo, "emulator fallback",
+	      model << ": outside the validated region of the emulator; "
+	      << "integrating");
+    return false;
+  }
+  if (error > tolerance) {
+    DIAGNOSE (diagnosticInfo, "emulator fallback",
+	      model << ": emulator error estimate " << error << " > "
+	      << tolerance << "; integrating");
+    return false;
+  }
+  emulator.getModelFlux (energy, parameter, flux);
+  DIAGNOSE (diagnosticDebug, "emulator",
+	    model << ": emulated, error estimate " << error);
+  return true;
+}
+
+/*
+  The model cores work on spans over the caller's buffers: the XSPEC
+  entry points below pass their RealArrays, and the ISIS C entry points
+  pass their raw pointers, so nothing is copied on the way in or out.
+  flux must have one element fewer than energy.
+*/
+static void emissionCore
+(ConstRealSpan energy, ConstRealSpan parameter, int spectrum, RealSpan flux,
+ ModelType type, const string& model)
+{
+  PROFILE_MODEL_CALL (model, getConfigVariable ("WINDPROFPROFILE", ""));
+  DIAGNOSTICS_MODEL_CALL
+    (model, getConfigVariable ("WINDPROFDIAGNOSTICS", ""));
+  setPrecisionMode ();
+  if (emulate (energy, parameter, flux, model)) return;
+  setFastMath (getFastMathSwitch ());
+  OpticalDepth::setAutomatic (getAutomaticOpticalDepthSwitch ());
+  WindProfile W (energy, parameter, type);
+  W.setTargetAccuracy (getTargetAccuracy (model, parameter, spectrum));
+  W.getModelFlux (flux);
+  return;
+}
+
+static void absorptionCore
+(ConstRealSpan energy, ConstRealSpan parameter, int spectrum, RealSpan flux)
+{
+  PROFILE_MODEL_CALL ("abswind", getConfigVariable ("WINDPROFPROFILE", ""));
+  DIAGNOSTICS_MODEL_CALL
+    ("abswind", getConfigVariable ("WINDPROFDIAGNOSTICS", ""));
+  setPrecisionMode ();
+  setFastMath (getFastMathSwitch ());
+  OpticalDepth::setAutomatic (getAutomaticOpticalDepthSwitch ());
+  WindAbsorptionProfile W (energy, parameter);
+  W.setTargetAccuracy (getTargetAccuracy ("abswind", parameter, spectrum));
+  W.multiplyModelFlux (flux);
+  return;
+}
+
+static void prepareOutput 
+(const RealArray& energy, RealArray& flux, RealArray& fluxError)
+{
+  fluxError.resize (0);
+  if (flux.size () != energy.size () - 1) flux.resize (energy.size () - 1);
+  return;
+}
+
 void windprof
 (const RealArray& energy, const RealArray& parameter, 
- /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
-  fluxError.resize (0);
-  WindProfile W (energy, parameter, general);
-  W.getModelFlux (flux);
+  prepareOutput (energy, flux, fluxError);
+  emissionCore (energy, parameter, spectrum, flux, general, "windprof");
   return;
 }
 
 void hwind
 (const RealArray& energy, const RealArray& parameter, 
- /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
-  fluxError.resize (0);
-  WindProfile W (energy, parameter, hlike);
-  W.getModelFlux (flux);
+  prepareOutput (energy, flux, fluxError);
+  emissionCore (energy, parameter, spectrum, flux, hlike, "hwind");
   return;
 }
 
 void hewind
 (const RealArray& energy, const RealArray& parameter, 
- /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
-  fluxError.resize (0);
-  WindProfile W (energy, parameter, helike);
-  W.getModelFlux (flux);
+  prepareOutput (energy, flux, fluxError);
+  emissionCore (energy, parameter, spectrum, flux, helike, "hewind");
   return;
 }
 
 void radwind
 (const RealArray& energy, const RealArray& parameter, 
- /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
-  fluxError.resize (0);
-  WindProfile W (energy, parameter, rad);
-  W.getModelFlux (flux);
+  prepareOutput (energy, flux, fluxError);
+  emissionCore (energy, parameter, spectrum, flux, rad, "radwind");
   return;
 }  
 
 void abswind
 (const RealArray& energy, const RealArray& parameter, 
- /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
  /*@unused@*/ const string& init)
 {
-  fluxError.resize (0);
-  WindAbsorptionProfile W (energy, parameter);
-  W.multiplyModelFlux (flux);
+  prepareOutput (energy, flux, fluxError);
+  absorptionCore (energy, parameter, spectrum, flux);
   return;
 }
 
-/*-------------------isis C-C++ wrapper functions----------------------*/
+/*-------------------isis C entry points----------------------*/
+
+/* The parameter array has one more element than NParameters (the
+   normalization), except for abswind, which is multiplicative.
+   fluxError is left untouched, as it was by isisCPPFunctionWrapper for
+   models that do not compute an error. */
 
 void C_windprof
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
- Real* flux, Real* fluxError, const char* init)
+ Real* flux, /*@unused@*/ Real* fluxError, /*@unused@*/ const char* init)
 {
-  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux, fluxError,
-			  init, WINDPROF_N_PARAMETERS, &windprof);
+  emissionCore (ConstRealSpan (energy, Nflux + 1), 
+		ConstRealSpan (parameter, WINDPROF_N_PARAMETERS + 1), 
+		spectrum, RealSpan (flux, Nflux), general, "windprof");
   return;
 }
 
 void C_hwind
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
- Real* flux, Real* fluxError, const char* init)
+ Real* flux, /*@unused@*/ Real* fluxError, /*@unused@*/ const char* init)
 {
-  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux, fluxError,
-			  init, HWIND_N_PARAMETERS, &hwind);
+  emissionCore (ConstRealSpan (energy, Nflux + 1), 
+		ConstRealSpan (parameter, HWIND_N_PARAMETERS + 1), 
+		spectrum, RealSpan (flux, Nflux), hlike, "hwind");
   return;
 }
 
 void C_hewind
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
- Real* flux, Real* fluxError, const char* init)
+ Real* flux, /*@unused@*/ Real* fluxError, /*@unused@*/ const char* init)
 {
-  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux, fluxError,
-			  init, HEWIND_N_PARAMETERS, &hewind);
+  emissionCore (ConstRealSpan (energy, Nflux + 1), 
+		ConstRealSpan (parameter, HEWIND_N_PARAMETERS + 1), 
+		spectrum, RealSpan (flux, Nflux), helike, "hewind");
   return;
 }
 
 void C_radwind
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
- Real* flux, Real* fluxError, const char* init)
+ Real* flux, /*@unused@*/ Real* fluxError, /*@unused@*/ const char* init)
 {
-  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux, fluxError,
-			  init, RADWIND_N_PARAMETERS, &radwind);
+  emissionCore (ConstRealSpan (energy, Nflux + 1), 
+		ConstRealSpan (parameter, RADWIND_N_PARAMETERS + 1), 
+		spectrum, RealSpan (flux, Nflux), rad, "radwind");
   return;
 }
 
 void C_abswind
 (const Real* energy, int Nflux, const Real* parameter, int spectrum, 
- Real* flux, Real* fluxError, const char* init)
+ Real* flux, /*@unused@*/ Real* fluxError, /*@unused@*/ const char* init)
 {
-  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux, fluxError,
-			  init, ABSWIND_N_PARAMETERS, &abswind);
+  absorptionCore (ConstRealSpan (energy, Nflux + 1), 
+		  ConstRealSpan (parameter, ABSWIND_N_PARAMETERS), 
+		  spectrum, RealSpan (flux, Nflux));
   return;
 }
-
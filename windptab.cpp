@@ -0,0 +1,154 @@
+/***************************************************************************
+    windptab.cpp    - windptab, hwindtab and hewindtb: windprof, hwind
+                      and hewind interpolated in tables made with
+                      TableModel/windtable (see WindProfileTable.h).
+
+                             -------------------
+    begin				: October 2026
+    copyright			: (C) 2026 by Maurice Leutenegger
+    email				: Maurice.A.Leutenegger@nasa.gov
+ ***************************************************************************/
+ /* This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA */
+
+/*
+  The parameters are those of windprof, hwind and hewind, so a fit can
+  switch between the table and the direct calculation. The table is
+  the file given by the setting WINDPTABFILE, HWINDTABFILE or
+  HEWINDTBFILE (an xset key in XSPEC; see WindProfileConfig), and is
+  read again only when the setting changes.
+*/
+
+#include "xsTypes.h"
+#include <map>
+#include <string>
+#include "WindProfileTable.h"
+#include "WindProfileConfig.h"
+#include "Diagnostics.h"
+#include "NParameters.h"
+#include "isisCPPFunctionWrapper.h"
+
+using namespace std;
+
+extern "C" void windptab
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void C_windptab
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init);
+
+extern "C" void hwindtab
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void C_hwindtab
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init);
+
+extern "C" void hewindtb
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init);
+
+extern "C" void C_hewindtb
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init);
+
+static void tableCore
+(const RealArray& energy, const RealArray& parameter, RealArray& flux,
+ const string& model, const string& tableModel, const string& key)
+{
+  DIAGNOSTICS_MODEL_CALL
+    (tableModel, getConfigVariable ("WINDPROFDIAGNOSTICS", ""));
+  size_t fluxSize = energy.size () - 1;
+  flux.resize (fluxSize);
+  flux = 0.;
+  static map<string, WindProfileTable> theTables;
+  WindProfileTable& table = theTables[model];
+  string filename = getConfigVariable (key, "");
+  if (filename.empty ()) {
+    DIAGNOSE (diagnosticError, "windptab",
+	      tableModel << ": set " << key << " to the table file");
+    return;
+  }
+  if (!table.read (filename)) return;
+  if (table.getModelName () != model) {
+    DIAGNOSE (diagnosticError, "windptab",
+	      tableModel << ": " << filename << " is a table of "
+	      << table.getModelName () << ", not " << model);
+    return;
+  }
+  table.getModelFlux (energy, parameter, flux);
+  return;
+}
+
+void windptab
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  tableCore (energy, parameter, flux, "windprof", "windptab", "WINDPTABFILE");
+  return;
+}
+
+void hwindtab
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  tableCore (energy, parameter, flux, "hwind", "hwindtab", "HWINDTABFILE");
+  return;
+}
+
+void hewindtb
+(const RealArray& energy, const RealArray& parameter,
+ /*@unused@*/ int spectrum, RealArray& flux, /*@unused@*/ RealArray& fluxError,
+ /*@unused@*/ const string& init)
+{
+  fluxError.resize (0);
+  tableCore (energy, parameter, flux, "hewind", "hewindtb", "HEWINDTBFILE");
+  return;
+}
+
+void C_windptab
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, WINDPROF_N_PARAMETERS, &windptab);
+  return;
+}
+
+void C_hwindtab
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, HWIND_N_PARAMETERS, &hwindtab);
+  return;
+}
+
+void C_hewindtb
+(const Real* energy, int Nflux, const Real* parameter, int spectrum,
+ Real* flux, Real* fluxError, const char* init)
+{
+  isisCPPFunctionWrapper (energy, Nflux, parameter, spectrum, flux,
+			  fluxError, init, HEWIND_N_PARAMETERS, &hewindtb);
+  return;
+}
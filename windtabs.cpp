@@ -24,11 +24,12 @@
 #include "xsTypes.h"
 #include <gsl/gsl_const_cgsm.h>
 #include "Utilities.h"
-#include "XspecUtilities.h"
+#include "WindProfileConfig.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include "LoadWindAbsorptionTables.h"
+#include "TableTransmission.h"
 #include "isisCPPFunctionWrapper.h"
 
 using namespace std;
@@ -99,7 +100,7 @@ void vvwindta (const RealArray& energy, const RealArray& parameter,
   for (size_t j=0; j<abundanceSize; j++) {
     abundances[j] = parameter[i++];
   }
-  if (getXspecVariable ("HEII", "0") == "1") {
+  if (getConfigVariable ("HEII", "0") == "1") {
     windtab4 (energy, flux, rhoRstar, abundances);
   } else {
     windtab3 (energy, flux, rhoRstar, abundances);
@@ -151,7 +152,7 @@ void windtabs
   size_t i = 0;
   Real rhoRstar = parameter[i++];
 
-  if (getXspecVariable ("HEII", "0") == "1") {
+  if (getConfigVariable ("HEII", "0") == "1") {
     windtab2 (energy, flux, rhoRstar);
     return;
   } else {
@@ -203,14 +204,8 @@ void windtab1 (const RealArray& energy, RealArray& flux, Real rhoRstar)
   TransmissionTauStar = theTransmissionData.getTauStar ();
 
   // calculate output transmission on energy grid
-  size_t fluxSize = flux.size ();
-  for (size_t i = 0; i < fluxSize; i++) {
-    Real responseWavelength = 2. * CONST_HC_KEV_A / (energy[i] + energy[i+1]); 
-    size_t j = BinarySearch (kappaWavelength, responseWavelength);
-    Real TauStar = rhoRstar * kappa[j];
-    size_t k = BinarySearch (TransmissionTauStar, TauStar);
-    flux[i] = Transmission[k];
-  }
+  getTableTransmission (energy, flux, rhoRstar, kappaWavelength, kappa,
+			TransmissionTauStar, Transmission);
   return;
 }
 
@@ -317,9 +312,9 @@ void windtab4 (const RealArray& energy, RealArray& flux, Real rhoRstar,
   
   // Write out a file with kappa, given the abundances.
   // But only if SAVEKAPPAZ is set to 1
-  if (getXspecVariable ("SAVEKAPPAZ", "0") == "1") {
-    string kappaOutFilename = getXspecVariable ("KAPPAZOUTFILE",    \
-                                                "kappaZ.txt");
+  if (getConfigVariable ("SAVEKAPPAZ", "0") == "1") {
+    string kappaOutFilename = getConfigVariable ("KAPPAZOUTFILE",    \
+                                                 "kappaZ.txt");
     writeKappaZHeII (kappa, kappaHeII, kappaEnergy, kappaOutFilename);
   }
 
@@ -377,9 +372,9 @@ void windtab3 (const RealArray& energy, RealArray& flux, Real rhoRstar,
   
   // Write out a file with kappa, given the abundances.
   // But only if SAVEKAPPAZ is set to 1
-  if (getXspecVariable ("SAVEKAPPAZ", "0") == "1") {
-    string kappaOutFilename = getXspecVariable ("KAPPAZOUTFILE",    \
-                                                "kappaZ.txt");
+  if (getConfigVariable ("SAVEKAPPAZ", "0") == "1") {
+    string kappaOutFilename = getConfigVariable ("KAPPAZOUTFILE",    \
+                                                 "kappaZ.txt");
     writeKappaZ (kappa, kappaEnergy, kappaOutFilename);
   }
 